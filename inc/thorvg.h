@@ -53,6 +53,7 @@ enum class TVG_EXPORT FillSpread { Pad = 0, Reflect, Repeat };
 enum class TVG_EXPORT FillRule { Winding = 0, EvenOdd };
 enum class TVG_EXPORT CompositeMethod { None = 0, ClipPath, AlphaMask, InvAlphaMask };
 enum class TVG_EXPORT CanvasEngine { Sw = (1 << 1), Gl = (1 << 2)};
+enum class TVG_EXPORT Quality { Draft = 0, Normal, High };
 
 
 struct Point
@@ -69,6 +70,16 @@ struct Matrix
 };
 
 
+struct MemoryUsage
+{
+    size_t pool;        //outline pools and scratch buffers of the threads
+    size_t rle;         //span buffers of the prepared paints
+    size_t ctable;      //gradient color tables
+    size_t image;       //layer caches and composition images
+    size_t block;       //free lists of the paint and task allocation pools
+};
+
+
 /**
  * @class Paint
  *
@@ -87,6 +98,7 @@ public:
     Result translate(float x, float y) noexcept;
     Result transform(const Matrix& m) noexcept;
     Result bounds(float* x, float* y, float* w, float* h) const noexcept;
+    Result bounds(float* x, float* y, float* w, float* h, bool tight) const noexcept;   //tight: curve extrema instead of control points
     Result opacity(uint8_t o) noexcept;
     Paint* duplicate() const noexcept;
 
@@ -147,9 +159,19 @@ public:
     Result reserve(uint32_t n) noexcept;
     virtual Result push(std::unique_ptr<Paint> paint) noexcept;
     virtual Result clear(bool free = true) noexcept;
+    //These look up the paint and shift the drawing order, linear in the number of the paints.
+    Result insert(std::unique_ptr<Paint> paint, const Paint* at, bool after) noexcept;    //after: drawn right above the at
+    Result remove(Paint* paint) noexcept;   //paint is released on the next update, it must not be accessed anymore
+    Result moveToFront(Paint* paint) noexcept;
+    Result moveToBack(Paint* paint) noexcept;
     virtual Result update(Paint* paint) noexcept;
     virtual Result draw() noexcept;
     virtual Result sync() noexcept;
+    Result quality(Quality q) noexcept;     //curve flattening accuracy, Draft trades it for speed
+    Quality quality() const noexcept;
+
+    uint32_t hit(uint32_t x, uint32_t y, Paint** paints, uint32_t n, uint8_t threshold = 0) noexcept;
+    uint32_t hit(uint32_t x, uint32_t y, uint32_t w, uint32_t h, Paint** paints, uint32_t n, uint8_t threshold = 0) noexcept;
 
     _TVG_DECLARE_PRIVATE(Canvas);
 };
@@ -226,6 +248,7 @@ public:
     Result appendCircle(float cx, float cy, float rx, float ry) noexcept;
     Result appendArc(float cx, float cy, float radius, float startAngle, float sweep, bool pie) noexcept;
     Result appendPath(const PathCommand* cmds, uint32_t cmdCnt, const Point* pts, uint32_t ptsCnt) noexcept;
+    Result appendPath(PathCommand* cmds, uint32_t cmdCnt, Point* pts, uint32_t ptsCnt, void (*deleter)(void*)) noexcept;   //Takes the ownership of the buffers. free() is used if deleter is null.
 
     //Stroke
     Result stroke(float width) noexcept;
@@ -239,8 +262,11 @@ public:
     Result fill(std::unique_ptr<Fill> f) noexcept;
     Result fill(FillRule r) noexcept;
 
+    //Instancing
+    Result instances(const Point* offsets, const uint8_t* opacities, uint32_t cnt) noexcept;
+
     //Getters
-    uint32_t pathCommands(const PathCommand** cmds) const noexcept;
+    uint32_t pathCommands(const PathCommand** cmds) const noexcept;     //converted copy of the commands, valid until the path changes
     uint32_t pathCoords(const Point** pts) const noexcept;
     const Fill* fill() const noexcept;
     Result fillColor(uint8_t* r, uint8_t* g, uint8_t* b, uint8_t* a) const noexcept;
@@ -251,6 +277,7 @@ public:
     uint32_t strokeDash(const float** dashPattern) const noexcept;
     StrokeCap strokeCap() const noexcept;
     StrokeJoin strokeJoin() const noexcept;
+    uint32_t instances(const Point** offsets, const uint8_t** opacities) const noexcept;
 
     static std::unique_ptr<Shape> gen() noexcept;
 
@@ -274,6 +301,11 @@ public:
     Result load(const std::string& path) noexcept;
     Result load(const char* data, uint32_t size) noexcept;
     Result load(uint32_t* data, uint32_t w, uint32_t h, bool copy) noexcept;
+
+    //Streaming, the contents are parsed part by part as they are fed
+    Result feed(const char* data, uint32_t size) noexcept;
+    Result finish() noexcept;
+
     //TODO: Replace with size(). Remove API
     Result viewbox(float* x, float* y, float* w, float* h) const noexcept;
 
@@ -303,6 +335,14 @@ public:
     Result push(std::unique_ptr<Paint> paint) noexcept;
     Result reserve(uint32_t size) noexcept;
     Result clear() noexcept;
+    //These look up the paint and shift the drawing order, linear in the number of the paints.
+    Result insert(std::unique_ptr<Paint> paint, const Paint* at, bool after) noexcept;    //after: drawn right above the at
+    Result remove(Paint* paint) noexcept;   //paint is released on the next update, it must not be accessed anymore
+    Result moveToFront(Paint* paint) noexcept;
+    Result moveToBack(Paint* paint) noexcept;
+    Result cache(bool enable) noexcept;
+
+    bool cache() const noexcept;
 
     static std::unique_ptr<Scene> gen() noexcept;
 
@@ -380,6 +420,9 @@ public:
      */
     static Result init(CanvasEngine engine, uint32_t threads) noexcept;
     static Result term(CanvasEngine engine) noexcept;
+    static Result usage(CanvasEngine engine, MemoryUsage* usage) noexcept;
+    static Result budget(CanvasEngine engine, size_t bytes) noexcept;      //soft limit, canvases trim the engine over it. 0: unlimited
+    static Result trim(CanvasEngine engine, uint32_t level) noexcept;      //0: pools, 1: pools and layer caches, dropped on the next draw of each canvas
 
     _TVG_DISABLE_CTOR(Initializer);
 };
@@ -730,6 +730,23 @@ TVG_EXPORT Tvg_Result tvg_shape_append_arc(Tvg_Paint* paint, float cx, float cy,
 TVG_EXPORT Tvg_Result tvg_shape_append_path(Tvg_Paint* paint, const Tvg_Path_Command* cmds, uint32_t cmdCnt, const Tvg_Point* pts, uint32_t ptsCnt);
 
 
+/*!
+* \fn TVG_EXPORT Tvg_Result tvg_shape_move_path(Tvg_Paint* paint, Tvg_Path_Command* cmds, uint32_t cmdCnt, Tvg_Point* pts, uint32_t ptsCnt, void (*deleter)(void*))
+* \brief The function append path like tvg_shape_append_path() but takes the ownership of the arrays instead of copying them.
+* The arrays are released by the deleter (free() if deleter is NULL) once the shape doesn't need them anymore.
+* \param[in] paint Tvg_Paint pointer
+* \param[in] cmds array of path commands
+* \param[in] cmdCnt length of commands array
+* \param[in] pts array of command points
+* \param[in] ptsCnt length of command points array
+* \param[in] deleter function to release each array
+* \return Tvg_Result return value
+* - TVG_RESULT_SUCCESS: if ok.
+* - TVG_RESULT_INVALID_PARAMETERS: if paint or arrays are invalid. The arrays remain owned by the caller.
+*/
+TVG_EXPORT Tvg_Result tvg_shape_move_path(Tvg_Paint* paint, Tvg_Path_Command* cmds, uint32_t cmdCnt, Tvg_Point* pts, uint32_t ptsCnt, void (*deleter)(void*));
+
+
 /*!
 * \fn TVG_EXPORT Tvg_Result tvg_shape_get_path_coords(const Tvg_Paint* paint, const Tvg_Point** pts, uint32_t* cnt)
 * \brief The function get path coordinates to the Tvg_Point array. Array length is specified by cnt output parameter.
@@ -756,7 +773,7 @@ TVG_EXPORT Tvg_Result tvg_shape_get_path_coords(const Tvg_Paint* paint, const Tv
 /*!
 * \fn TVG_EXPORT Tvg_Result tvg_shape_get_path_commands(const Tvg_Paint* paint, const Tvg_Path_Command** cmds, uint32_t* cnt)
 * \brief The function gets path commands to commands array. Array length is specified by cnt output parameter.
-* The function does not allocate any data. There is no need to cmds array.
+* The array is a converted copy kept by the shape, it stays valid until the path changes. There is no need to free cmds array.
 * \code
 * Tvg_Shape *shape = tvg_shape_new();
 * Tvg_Point *coords = NULL;
@@ -266,6 +266,12 @@ TVG_EXPORT Tvg_Result tvg_shape_append_path(Tvg_Paint* paint, const Tvg_Path_Com
     return (Tvg_Result) reinterpret_cast<Shape*>(paint)->appendPath((PathCommand*)cmds, cmdCnt, (Point*)pts, ptsCnt);
 }
 
+TVG_EXPORT Tvg_Result tvg_shape_move_path(Tvg_Paint* paint, Tvg_Path_Command* cmds, uint32_t cmdCnt, Tvg_Point* pts, uint32_t ptsCnt, void (*deleter)(void*))
+{
+    if (!paint) return TVG_RESULT_INVALID_ARGUMENT;
+    return (Tvg_Result) reinterpret_cast<Shape*>(paint)->appendPath((PathCommand*)cmds, cmdCnt, (Point*)pts, ptsCnt, deleter);
+}
+
 TVG_EXPORT Tvg_Result tvg_shape_get_path_coords(const Tvg_Paint* paint, const Tvg_Point** pts, uint32_t* cnt)
 {
     if (!paint) return TVG_RESULT_INVALID_ARGUMENT;
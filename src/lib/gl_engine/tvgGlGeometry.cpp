@@ -43,11 +43,8 @@ const GlSize GlGeometry::getPrimitiveSize(const uint32_t primitiveIndex) const
 }
 
 
-bool GlGeometry::decomposeOutline(const Shape& shape)
+bool GlGeometry::decomposeOutline(const Shape& shape, const PathCmd* cmds, uint32_t cmdCnt)
 {
-    const PathCommand* cmds = nullptr;
-    auto cmdCnt = shape.pathCommands(&cmds);
-
     Point* pts = nullptr;
     auto ptsCnt = shape.pathCoords(const_cast<const Point**>(&pts));
 
@@ -60,7 +57,7 @@ bool GlGeometry::decomposeOutline(const Shape& shape)
 
     for (unsigned i = 0; i < cmdCnt; ++i) {
         switch (*(cmds + i)) {
-            case PathCommand::Close: {
+            case PathCmd::Close: {
                 if (curPrimitive) {
                     if (curPrimitive->mAAPoints.size() > 0 && (curPrimitive->mAAPoints[0].orgPt != curPrimitive->mAAPoints.back().orgPt)) {
                         curPrimitive->mAAPoints.push_back(curPrimitive->mAAPoints[0].orgPt);
@@ -69,7 +66,7 @@ bool GlGeometry::decomposeOutline(const Shape& shape)
                 }
                 break;
             }
-            case PathCommand::MoveTo: {
+            case PathCmd::MoveTo: {
                 if (curPrimitive) {
                     curPrimitive->mTopLeft = min;
                     curPrimitive->mBottomRight = max;
@@ -81,12 +78,12 @@ bool GlGeometry::decomposeOutline(const Shape& shape)
                 curPrimitive = &mPrimitives.back();
             }
             __attribute__ ((fallthrough));
-            case PathCommand::LineTo: {
+            case PathCmd::LineTo: {
                 if (curPrimitive) addPoint(*curPrimitive, pts[0], min, max);
                 pts++;
                 break;
             }
-            case PathCommand::CubicTo: {
+            case PathCmd::CubicTo: {
                 if (curPrimitive) decomposeCubicCurve(*curPrimitive, curPrimitive->mAAPoints.back().orgPt, pts[0], pts[1], pts[2], min, max);
                 pts += 3;
                 break;
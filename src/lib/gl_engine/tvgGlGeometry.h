@@ -237,7 +237,7 @@ public:
 
     uint32_t getPrimitiveCount();
     const GlSize getPrimitiveSize(const uint32_t primitiveIndex) const;
-    bool decomposeOutline(const Shape& shape);
+    bool decomposeOutline(const Shape& shape, const PathCmd* cmds, uint32_t cmdCnt);
     bool generateAAPoints(TVG_UNUSED const Shape& shape, float strokeWd, RenderUpdateFlag flag);
     bool tesselate(TVG_UNUSED const Shape &shape, float viewWd, float viewHt, RenderUpdateFlag flag);
     void disableVertex(uint32_t location);
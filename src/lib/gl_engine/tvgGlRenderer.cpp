@@ -73,6 +73,13 @@ bool GlRenderer::sync()
 }
 
 
+bool GlRenderer::quality(TVG_UNUSED Quality q)
+{
+    //Tessellation is not adjustable yet
+    return false;
+}
+
+
 bool GlRenderer::region(TVG_UNUSED RenderData data, TVG_UNUSED uint32_t* x, TVG_UNUSED uint32_t* y, TVG_UNUSED uint32_t* w, TVG_UNUSED uint32_t* h)
 {
     return true;
@@ -123,6 +130,54 @@ bool GlRenderer::endComposite(TVG_UNUSED Compositor* cmp)
 }
 
 
+bool GlRenderer::hit(TVG_UNUSED RenderData data, TVG_UNUSED uint32_t x, TVG_UNUSED uint32_t y, TVG_UNUSED uint32_t w, TVG_UNUSED uint32_t h, TVG_UNUSED uint8_t threshold)
+{
+    //TODO: Hit test with the tessellated geometry
+    return false;
+}
+
+
+bool GlRenderer::viewport(TVG_UNUSED uint32_t* x, TVG_UNUSED uint32_t* y, TVG_UNUSED uint32_t* w, TVG_UNUSED uint32_t* h)
+{
+    //TODO: Regions of the tasks are not provided yet, nothing can be culled.
+    return false;
+}
+
+
+RenderData GlRenderer::beginCache(TVG_UNUSED RenderData data, TVG_UNUSED uint32_t x, TVG_UNUSED uint32_t y, TVG_UNUSED uint32_t w, TVG_UNUSED uint32_t h)
+{
+    //Layer caches are not supported, the scene is drawn directly
+#ifdef THORVG_LOG_ENABLED
+    printf("GL_ENGINE: Layer cache is not supported!\n");
+#endif
+    return nullptr;
+}
+
+
+bool GlRenderer::endCache(TVG_UNUSED RenderData data)
+{
+    return false;
+}
+
+
+bool GlRenderer::renderCache(TVG_UNUSED RenderData data, TVG_UNUSED int32_t dx, TVG_UNUSED int32_t dy, TVG_UNUSED uint32_t opacity)
+{
+    return false;
+}
+
+
+bool GlRenderer::reusable(TVG_UNUSED RenderData data, TVG_UNUSED int32_t dx, TVG_UNUSED int32_t dy)
+{
+    return false;
+}
+
+
+bool GlRenderer::disposeCache(TVG_UNUSED RenderData data)
+{
+    return true;
+}
+
+
 bool GlRenderer::renderImage(TVG_UNUSED void* data)
 {
     return false;
@@ -191,7 +246,7 @@ RenderData GlRenderer::prepare(TVG_UNUSED const Picture& picture, TVG_UNUSED Ren
 }
 
 
-RenderData GlRenderer::prepare(const Shape& shape, RenderData data, const RenderTransform* transform, TVG_UNUSED uint32_t opacity, Array<RenderData>& clips, RenderUpdateFlag flags)
+RenderData GlRenderer::prepare(const Shape& shape, const PathCmd* cmds, uint32_t cmdCnt, RenderData data, const RenderTransform* transform, TVG_UNUSED uint32_t opacity, Array<RenderData>& clips, RenderUpdateFlag flags)
 {
     //prepare shape data
     GlShape* sdata = static_cast<GlShape*>(data);
@@ -226,7 +281,7 @@ RenderData GlRenderer::prepare(const Shape& shape, RenderData data, const Render
 
     if (sdata->updateFlag & (RenderUpdateFlag::Color | RenderUpdateFlag::Stroke | RenderUpdateFlag::Gradient | RenderUpdateFlag::Transform) )
     {
-        if (!sdata->geometry->decomposeOutline(shape)) return sdata;
+        if (!sdata->geometry->decomposeOutline(shape, cmds, cmdCnt)) return sdata;
         if (!sdata->geometry->generateAAPoints(shape, static_cast<float>(strokeWd), sdata->updateFlag)) return sdata;
         if (!sdata->geometry->tesselate(shape, sdata->viewWd, sdata->viewHt, sdata->updateFlag)) return sdata;
     }
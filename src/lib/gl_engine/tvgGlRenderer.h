@@ -30,7 +30,7 @@ class GlRenderer : public RenderMethod
 public:
     Surface surface = {nullptr, 0, 0, 0};
 
-    RenderData prepare(const Shape& shape, RenderData data, const RenderTransform* transform, uint32_t opacity, Array<RenderData>& clips, RenderUpdateFlag flags) override;
+    RenderData prepare(const Shape& shape, const PathCmd* cmds, uint32_t cmdCnt, RenderData data, const RenderTransform* transform, uint32_t opacity, Array<RenderData>& clips, RenderUpdateFlag flags) override;
     RenderData prepare(const Picture& picture, RenderData data, const RenderTransform* transform, uint32_t opacity, Array<RenderData>& clips, RenderUpdateFlag flags) override;
     bool preRender() override;
     bool renderShape(RenderData data) override;
@@ -38,15 +38,24 @@ public:
     bool postRender() override;
     bool dispose(RenderData data) override;;
     bool region(RenderData data, uint32_t* x, uint32_t* y, uint32_t* w, uint32_t* h) override;
+    bool hit(RenderData data, uint32_t x, uint32_t y, uint32_t w, uint32_t h, uint8_t threshold) override;
+    bool viewport(uint32_t* x, uint32_t* y, uint32_t* w, uint32_t* h) override;
 
     bool target(uint32_t* buffer, uint32_t stride, uint32_t w, uint32_t h);
     bool sync() override;
     bool clear() override;
+    bool quality(Quality q) override;
 
     Compositor* target(uint32_t x, uint32_t y, uint32_t w, uint32_t h) override;
     bool beginComposite(Compositor* cmp, CompositeMethod method, uint32_t opacity) override;
     bool endComposite(Compositor* cmp) override;
 
+    RenderData beginCache(RenderData data, uint32_t x, uint32_t y, uint32_t w, uint32_t h) override;
+    bool endCache(RenderData data) override;
+    bool renderCache(RenderData data, int32_t dx, int32_t dy, uint32_t opacity) override;
+    bool reusable(RenderData data, int32_t dx, int32_t dy) override;
+    bool disposeCache(RenderData data) override;
+
     static GlRenderer* gen();
     static int init(TVG_UNUSED uint32_t threads);
     static int term();
@@ -46,6 +46,16 @@ static double timeStamp()
 #define SW_ANGLE_PI2 (SW_ANGLE_PI >> 1)
 #define SW_ANGLE_PI4 (SW_ANGLE_PI >> 2)
 
+enum SwMemory {SW_MEM_POOL = 0, SW_MEM_RLE, SW_MEM_CTABLE, SW_MEM_IMAGE, SW_MEM_CNT};
+
+//Curve flattening precision, a curve may deviate by a pixel divided by it.
+#define SW_PRECISION_DRAFT 2
+#define SW_PRECISION_NORMAL 6
+#define SW_PRECISION_HIGH 16
+
+//Max stroke width on the device to be drawn as a hairline
+#define SW_HAIRLINE_WIDTH 1.5f
+
 using SwCoord = signed long;
 using SwFixed = signed long long;
 
@@ -148,6 +158,7 @@ struct SwStroke
     SwPoint ptStartSubPath;
     SwFixed subPathLineLength;
     SwFixed width;
+    uint32_t precision;     //curve flattening precision
 
     StrokeCap cap;
     StrokeJoin join;
@@ -218,6 +229,7 @@ struct SwImage
     SwRleData*   rle = nullptr;
     uint32_t*    data = nullptr;
     uint32_t     w, h;
+    SwCoord      ox = 0, oy = 0;    //surface coordinates of the first pixel
 };
 
 struct SwBlender
@@ -232,6 +244,7 @@ struct SwSurface : Surface
 {
     SwBlender blender;                    //mandatory
     SwCompositor* compositor = nullptr;   //compositor (optional)
+    uint32_t ox = 0, oy = 0;              //surface coordinates of the first pixel of the buffer
 };
 
 struct SwCompositor : Compositor
@@ -243,6 +256,16 @@ struct SwCompositor : Compositor
     bool valid;
 };
 
+struct SwCache
+{
+    SwSurface surface;                      //render target of the cached layer
+    SwSurface* recoverSfc;                  //Recover surface when caching is done
+    SwImage image;                          //layer pixels of the bbox size
+    SwBBox bbox;
+    uint32_t w, h;                          //surface size when the layer was cached
+    bool complete;                          //layer is not cut off by the surface boundary
+};
+
 static inline SwCoord TO_SWCOORD(float val)
 {
     return SwCoord(val * 64);
@@ -282,25 +305,25 @@ SwFixed mathSin(SwFixed angle);
 void mathSplitCubic(SwPoint* base);
 SwFixed mathDiff(SwFixed angle1, SwFixed angle2);
 SwFixed mathLength(SwPoint& pt);
-bool mathSmallCubic(SwPoint* base, SwFixed& angleIn, SwFixed& angleMid, SwFixed& angleOut);
+bool mathSmallCubic(SwPoint* base, SwFixed& angleIn, SwFixed& angleMid, SwFixed& angleOut, SwFixed limit);
 SwFixed mathMean(SwFixed angle1, SwFixed angle2);
 SwPoint mathTransform(const Point* to, const Matrix* transform);
 
 void shapeReset(SwShape* shape);
-bool shapeGenOutline(SwShape* shape, const Shape* sdata, unsigned tid, const Matrix* transform);
-bool shapePrepare(SwShape* shape, const Shape* sdata, unsigned tid, const SwSize& clip, const Matrix* transform, SwBBox& bbox);
+bool shapeGenOutline(SwShape* shape, const Shape* sdata, const PathCmd* cmds, uint32_t cmdCnt, unsigned tid, const Matrix* transform);
+bool shapePrepare(SwShape* shape, const Shape* sdata, const PathCmd* cmds, uint32_t cmdCnt, unsigned tid, const SwSize& clip, const Matrix* transform, SwBBox& bbox);
 bool shapePrepared(SwShape* shape);
-bool shapeGenRle(SwShape* shape, const Shape* sdata, const SwSize& clip, bool antiAlias, bool hasComposite);
+bool shapeGenRle(SwShape* shape, const Shape* sdata, const SwSize& clip, bool antiAlias, bool hasComposite, uint32_t precision);
 void shapeDelOutline(SwShape* shape, uint32_t tid);
-void shapeResetStroke(SwShape* shape, const Shape* sdata, const Matrix* transform);
-bool shapeGenStrokeRle(SwShape* shape, const Shape* sdata, unsigned tid, const Matrix* transform, const SwSize& clip, SwBBox& bbox);
+void shapeResetStroke(SwShape* shape, const Shape* sdata, const Matrix* transform, uint32_t precision);
+bool shapeGenStrokeRle(SwShape* shape, const Shape* sdata, const PathCmd* cmds, uint32_t cmdCnt, unsigned tid, const Matrix* transform, const SwSize& clip, SwBBox& bbox);
 void shapeFree(SwShape* shape);
 void shapeDelStroke(SwShape* shape);
 bool shapeGenFillColors(SwShape* shape, const Fill* fill, const Matrix* transform, SwSurface* surface, uint32_t opacity, bool ctable);
 void shapeResetFill(SwShape* shape);
 void shapeDelFill(SwShape* shape);
 
-void strokeReset(SwStroke* stroke, const Shape* shape, const Matrix* transform);
+void strokeReset(SwStroke* stroke, const Shape* shape, const Matrix* transform, uint32_t precision);
 bool strokeParseOutline(SwStroke* stroke, const SwOutline& outline);
 SwOutline* strokeExportOutline(SwStroke* stroke, unsigned tid);
 void strokeFree(SwStroke* stroke);
@@ -319,12 +342,15 @@ void fillFree(SwFill* fill);
 void fillFetchLinear(const SwFill* fill, uint32_t* dst, uint32_t y, uint32_t x, uint32_t offset, uint32_t len);
 void fillFetchRadial(const SwFill* fill, uint32_t* dst, uint32_t y, uint32_t x, uint32_t len);
 
-SwRleData* rleRender(SwRleData* rle, const SwOutline* outline, const SwBBox& bbox, const SwSize& clip, bool antiAlias);
+SwRleData* rleRender(SwRleData* rle, const SwOutline* outline, const SwBBox& bbox, const SwSize& clip, bool antiAlias, uint32_t precision);
 void rleFree(SwRleData* rle);
 void rleReset(SwRleData* rle);
-void rleClipPath(SwRleData *rle, const SwRleData *clip);
-void rleClipRect(SwRleData *rle, const SwBBox* clip);
-void rleAlphaMask(SwRleData *rle, const SwRleData *clip);
+void rleClipPath(SwRleData *rle, const SwRleData *clip, unsigned tid);
+void rleClipRect(SwRleData *rle, const SwBBox* clip, unsigned tid);
+void rleAlphaMask(SwRleData *rle, const SwRleData *clip, unsigned tid);
+bool rleHit(const SwRleData* rle, const SwBBox& region, uint8_t threshold);
+bool rleTranslate(const SwRleData* rle, SwRleData* out, SwCoord x, SwCoord y, const SwSize& clip);
+SwRleData* rleHairline(SwRleData* rle, const SwOutline* outline, float width, const SwSize& clip, uint32_t precision, unsigned tid);
 
 bool mpoolInit(uint32_t threads);
 bool mpoolTerm();
@@ -333,6 +359,14 @@ SwOutline* mpoolReqOutline(unsigned idx);
 void mpoolRetOutline(unsigned idx);
 SwOutline* mpoolReqStrokeOutline(unsigned idx);
 void mpoolRetStrokeOutline(unsigned idx);
+SwOutline* mpoolReqDashOutline(unsigned idx);
+void mpoolRetDashOutline(unsigned idx);
+void* mpoolReqScratch(unsigned idx, uint32_t size);
+void mpoolRetScratch(unsigned idx, void* p);
+uint32_t mpoolScratchPeak();
+void mpoolCount(SwMemory type, int64_t bytes);
+size_t mpoolUsage(SwMemory type);
+void mpoolTrim();
 
 bool rasterCompositor(SwSurface* surface);
 bool rasterGradientShape(SwSurface* surface, SwShape* shape, unsigned id);
@@ -341,10 +375,22 @@ bool rasterImage(SwSurface* surface, SwImage* image, const Matrix* transform, Sw
 bool rasterStroke(SwSurface* surface, SwShape* shape, uint8_t r, uint8_t g, uint8_t b, uint8_t a);
 bool rasterClear(SwSurface* surface);
 
+//Pixel at the surface coordinates, the buffer begins at the surface origin
+static inline uint32_t* PIXEL(const SwSurface* surface, SwCoord x, SwCoord y)
+{
+    return surface->buffer + (y - static_cast<SwCoord>(surface->oy)) * static_cast<SwCoord>(surface->stride) + (x - static_cast<SwCoord>(surface->ox));
+}
+
+//Pixel at the surface coordinates, the image begins at its origin
+static inline uint32_t* IMAGE_PIXEL(const SwImage* image, SwCoord x, SwCoord y)
+{
+    return image->data + (y - image->oy) * static_cast<SwCoord>(image->w) + (x - image->ox);
+}
+
 static inline void rasterRGBA32(uint32_t *dst, uint32_t val, uint32_t offset, int32_t len)
 {
 #ifdef THORVG_AVX_VECTOR_SUPPORT
-    int32_t align = (8 - (offset % 8)) % 8;
+    int32_t align = (8 - ((reinterpret_cast<uintptr_t>(dst + offset) / sizeof(uint32_t)) % 8)) % 8;
     //Vectorization
     auto avxDst = (__m256i*)(dst + offset + align);
     int32_t i = (len - align);
@@ -38,6 +38,7 @@ static bool _updateColorTable(SwFill* fill, const Fill* fdata, SwSurface* surfac
     if (!fill->ctable) {
         fill->ctable = static_cast<uint32_t*>(malloc(GRADIENT_STOP_SIZE * sizeof(uint32_t)));
         if (!fill->ctable) return false;
+        mpoolCount(SW_MEM_CTABLE, GRADIENT_STOP_SIZE * sizeof(uint32_t));
     }
 
     const Fill::ColorStop* colors;
@@ -299,6 +300,7 @@ void fillReset(SwFill* fill)
     if (fill->ctable) {
         free(fill->ctable);
         fill->ctable = nullptr;
+        mpoolCount(SW_MEM_CTABLE, -(int64_t)(GRADIENT_STOP_SIZE * sizeof(uint32_t)));
     }
     fill->translucent = false;
 }
@@ -308,7 +310,10 @@ void fillFree(SwFill* fill)
 {
     if (!fill) return;
 
-    if (fill->ctable) free(fill->ctable);
+    if (fill->ctable) {
+        free(fill->ctable);
+        mpoolCount(SW_MEM_CTABLE, -(int64_t)(GRADIENT_STOP_SIZE * sizeof(uint32_t)));
+    }
 
     free(fill);
 }
\ No newline at end of file
@@ -110,7 +110,8 @@ bool imagePrepared(SwImage* image)
 
 bool imageGenRle(SwImage* image, TVG_UNUSED const Picture* pdata, const SwSize& clip, SwBBox& bbox, bool antiAlias, bool hasComposite)
 {
-    if ((image->rle = rleRender(image->rle, image->outline, bbox, clip, antiAlias))) return true;
+    //Image outline has no curves
+    if ((image->rle = rleRender(image->rle, image->outline, bbox, clip, antiAlias, SW_PRECISION_NORMAL))) return true;
 
     return false;
 }
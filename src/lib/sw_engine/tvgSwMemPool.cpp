@@ -19,6 +19,8 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
  * SOFTWARE.
  */
+#include <atomic>
+#include <cassert>
 #include "tvgSwCommon.h"
 
 
@@ -26,10 +28,78 @@
 /* Internal Class Implementation                                        */
 /************************************************************************/
 
+//Each scratch block is preceded by a header, the blocks are stacked in the arena.
+#define SCRATCH_HEADER 16
+
+struct SwScratchHeader
+{
+    uint32_t prev;          //offset of the block below
+    uint32_t returned;
+};
+
+struct SwArena
+{
+    uint8_t* data;
+    uint32_t reserved;
+    uint32_t used;
+    uint32_t peak;          //high-water mark of the requests
+    uint32_t top;           //offset of the last block
+};
+
 static SwOutline* outline = nullptr;
 static SwOutline* strokeOutline = nullptr;
+static SwOutline* dashOutline = nullptr;
+static SwArena* arena = nullptr;
+static uint32_t* trimmed = nullptr;      //last trim request applied by each thread
 static unsigned allocSize = 0;
 
+static std::atomic<uint32_t> trimReq{0};
+static std::atomic<size_t> usage[SW_MEM_CNT];
+
+
+static void _clearOutline(SwOutline* p)
+{
+    if (p->cntrs) {
+        free(p->cntrs);
+        p->cntrs = nullptr;
+    }
+    if (p->pts) {
+        free(p->pts);
+        p->pts = nullptr;
+    }
+    if (p->types) {
+        free(p->types);
+        p->types = nullptr;
+    }
+    p->cntrsCnt = p->reservedCntrsCnt = 0;
+    p->ptsCnt = p->reservedPtsCnt = 0;
+}
+
+
+static size_t _outlineSize(const SwOutline* p)
+{
+    return p->reservedCntrsCnt * sizeof(uint32_t) + p->reservedPtsCnt * (sizeof(SwPoint) + sizeof(uint8_t));
+}
+
+
+//Only the owner thread touches its pool, it releases them on the trim request.
+static void _trim(unsigned idx)
+{
+    auto req = trimReq.load(std::memory_order_relaxed);
+    if (trimmed[idx] == req) return;
+    trimmed[idx] = req;
+
+    _clearOutline(&outline[idx]);
+    _clearOutline(&strokeOutline[idx]);
+    _clearOutline(&dashOutline[idx]);
+
+    auto a = &arena[idx];
+    if (a->used > 0) return;
+    free(a->data);
+    a->data = nullptr;
+    a->reserved = a->peak = 0;
+}
+
 
 /************************************************************************/
 /* External Class Implementation                                        */
@@ -45,6 +115,8 @@ void mpoolRetOutline(unsigned idx)
 {
     outline[idx].cntrsCnt = 0;
     outline[idx].ptsCnt = 0;
+
+    _trim(idx);
 }
 
 
@@ -61,9 +133,112 @@ void mpoolRetStrokeOutline(unsigned idx)
 }
 
 
+SwOutline* mpoolReqDashOutline(unsigned idx)
+{
+    return &dashOutline[idx];
+}
+
+
+void mpoolRetDashOutline(unsigned idx)
+{
+    dashOutline[idx].cntrsCnt = 0;
+    dashOutline[idx].ptsCnt = 0;
+}
+
+
+void* mpoolReqScratch(unsigned idx, uint32_t size)
+{
+    auto a = &arena[idx];
+
+    size = ((size + 15) & ~15) + SCRATCH_HEADER;
+    if (a->used + size > a->peak) a->peak = a->used + size;
+
+    //Grow up to the high-water mark only while nothing is borrowed.
+    if (a->used == 0 && a->peak > a->reserved) {
+        free(a->data);
+        a->data = static_cast<uint8_t*>(malloc(a->peak));
+        a->reserved = a->data ? a->peak : 0;
+    }
+
+    //Out of the arena, it will fit in from the next request.
+    if (a->used + size > a->reserved) return malloc(size - SCRATCH_HEADER);
+
+    auto header = reinterpret_cast<SwScratchHeader*>(a->data + a->used);
+    header->prev = a->top;
+    header->returned = 0;
+    a->top = a->used;
+    a->used += size;
+
+    return a->data + a->top + SCRATCH_HEADER;
+}
+
+
+void mpoolRetScratch(unsigned idx, void* p)
+{
+    if (!p) return;
+
+    auto a = &arena[idx];
+
+    if (p < a->data || p >= a->data + a->reserved) {
+        free(p);
+        return;
+    }
+
+    auto offset = static_cast<uint32_t>(static_cast<uint8_t*>(p) - a->data) - SCRATCH_HEADER;
+    reinterpret_cast<SwScratchHeader*>(a->data + offset)->returned = 1;
+
+    //Requests must be returned in the reverse order.
+    assert(offset == a->top);
+
+    //Otherwise the block is kept until the ones above it are returned.
+    while (a->used > 0) {
+        auto header = reinterpret_cast<SwScratchHeader*>(a->data + a->top);
+        if (!header->returned) break;
+        a->used = a->top;
+        a->top = header->prev;
+    }
+}
+
+
+void mpoolCount(SwMemory type, int64_t bytes)
+{
+    usage[type].fetch_add(static_cast<size_t>(bytes), std::memory_order_relaxed);
+}
+
+
+size_t mpoolUsage(SwMemory type)
+{
+    if (type != SW_MEM_POOL) return usage[type].load(std::memory_order_relaxed);
+
+    //Approximate, the threads may be growing their pools.
+    size_t bytes = 0;
+    for (unsigned i = 0; i < allocSize; ++i) {
+        bytes += _outlineSize(&outline[i]) + _outlineSize(&strokeOutline[i]) + _outlineSize(&dashOutline[i]);
+        bytes += arena[i].reserved;
+    }
+    return bytes;
+}
+
+
+void mpoolTrim()
+{
+    trimReq.fetch_add(1, std::memory_order_relaxed);
+}
+
+
+uint32_t mpoolScratchPeak()
+{
+    uint32_t peak = 0;
+    for (unsigned i = 0; i < allocSize; ++i) {
+        if (arena[i].peak > peak) peak = arena[i].peak;
+    }
+    return peak;
+}
+
+
 bool mpoolInit(unsigned threads)
 {
-    if (outline || strokeOutline) return false;
+    if (outline || strokeOutline || dashOutline || arena || trimmed) return false;
     if (threads == 0) threads = 1;
 
     outline = static_cast<SwOutline*>(calloc(1, sizeof(SwOutline) * threads));
@@ -72,6 +247,16 @@ bool mpoolInit(unsigned threads)
     strokeOutline = static_cast<SwOutline*>(calloc(1, sizeof(SwOutline) * threads));
     if (!strokeOutline) goto err;
 
+    dashOutline = static_cast<SwOutline*>(calloc(1, sizeof(SwOutline) * threads));
+    if (!dashOutline) goto err;
+
+    arena = static_cast<SwArena*>(calloc(1, sizeof(SwArena) * threads));
+    if (!arena) goto err;
+
+    trimmed = static_cast<uint32_t*>(calloc(1, sizeof(uint32_t) * threads));
+    if (!trimmed) goto err;
+    trimReq = 0;
+
     allocSize = threads;
 
     return true;
@@ -86,49 +271,38 @@ err:
         free(strokeOutline);
         strokeOutline = nullptr;
     }
+
+    if (dashOutline) {
+        free(dashOutline);
+        dashOutline = nullptr;
+    }
+
+    if (arena) {
+        free(arena);
+        arena = nullptr;
+    }
+
+    if (trimmed) {
+        free(trimmed);
+        trimmed = nullptr;
+    }
     return false;
 }
 
 
 bool mpoolClear()
 {
-    SwOutline* p;
-
     for (unsigned i = 0; i < allocSize; ++i) {
-
-        p = &outline[i];
-
-        if (p->cntrs) {
-            free(p->cntrs);
-            p->cntrs = nullptr;
-        }
-        if (p->pts) {
-            free(p->pts);
-            p->pts = nullptr;
-        }
-        if (p->types) {
-            free(p->types);
-            p->types = nullptr;
+        _clearOutline(&outline[i]);
+        _clearOutline(&strokeOutline[i]);
+        _clearOutline(&dashOutline[i]);
+
+        auto a = &arena[i];
+        if (a->data) {
+            free(a->data);
+            a->data = nullptr;
         }
-        p->cntrsCnt = p->reservedCntrsCnt = 0;
-        p->ptsCnt = p->reservedPtsCnt = 0;
-
-        p = &strokeOutline[i];
-
-        if (p->cntrs) {
-            free(p->cntrs);
-            p->cntrs = nullptr;
-        }
-        if (p->pts) {
-            free(p->pts);
-            p->pts = nullptr;
-        }
-        if (p->types) {
-            free(p->types);
-            p->types = nullptr;
-        }
-        p->cntrsCnt = p->reservedCntrsCnt = 0;
-        p->ptsCnt = p->reservedPtsCnt = 0;
+        a->reserved = a->used = a->peak = a->top = 0;
     }
 
     return true;
@@ -149,7 +323,22 @@ bool mpoolTerm()
         strokeOutline = nullptr;
     }
 
+    if (dashOutline) {
+        free(dashOutline);
+        dashOutline = nullptr;
+    }
+
+    if (arena) {
+        free(arena);
+        arena = nullptr;
+    }
+
+    if (trimmed) {
+        free(trimmed);
+        trimmed = nullptr;
+    }
+
     allocSize = 0;
 
     return true;
-}
\ No newline at end of file
+}
@@ -81,12 +81,12 @@ static bool _identify(const Matrix* transform)
 }
 
 
-static SwBBox _clipRegion(Surface* surface, SwBBox& in)
+static SwBBox _clipRegion(SwSurface* surface, SwBBox& in)
 {
     auto bbox = in;
 
-    if (bbox.min.x < 0) bbox.min.x = 0;
-    if (bbox.min.y < 0) bbox.min.y = 0;
+    if (bbox.min.x < static_cast<SwCoord>(surface->ox)) bbox.min.x = surface->ox;
+    if (bbox.min.y < static_cast<SwCoord>(surface->oy)) bbox.min.y = surface->oy;
     if (bbox.max.x > static_cast<SwCoord>(surface->w)) bbox.max.x = surface->w;
     if (bbox.max.y > static_cast<SwCoord>(surface->h)) bbox.max.y = surface->h;
 
@@ -108,7 +108,7 @@ static bool _translucent(SwSurface* surface, uint8_t a)
 
 static bool _translucentRect(SwSurface* surface, const SwBBox& region, uint32_t color)
 {
-    auto buffer = surface->buffer + (region.min.y * surface->stride) + region.min.x;
+    auto buffer = PIXEL(surface, region.min.x, region.min.y);
     auto h = static_cast<uint32_t>(region.max.y - region.min.y);
     auto w = static_cast<uint32_t>(region.max.x - region.min.x);
     auto ialpha = 255 - surface->blender.alpha(color);
@@ -125,7 +125,7 @@ static bool _translucentRect(SwSurface* surface, const SwBBox& region, uint32_t
 
 static bool _translucentRectAlphaMask(SwSurface* surface, const SwBBox& region, uint32_t color)
 {
-    auto buffer = surface->buffer + (region.min.y * surface->stride) + region.min.x;
+    auto buffer = PIXEL(surface, region.min.x, region.min.y);
     auto h = static_cast<uint32_t>(region.max.y - region.min.y);
     auto w = static_cast<uint32_t>(region.max.x - region.min.x);
 
@@ -133,11 +133,11 @@ static bool _translucentRectAlphaMask(SwSurface* surface, const SwBBox& region,
     printf("SW_ENGINE: Rectangle Alpha Mask Composition\n");
 #endif
 
-    auto cbuffer = surface->compositor->image.data + (region.min.y * surface->stride) + region.min.x;   //compositor buffer
+    auto cbuffer = IMAGE_PIXEL(&surface->compositor->image, region.min.x, region.min.y);   //compositor buffer
 
     for (uint32_t y = 0; y < h; ++y) {
         auto dst = &buffer[y * surface->stride];
-        auto cmp = &cbuffer[y * surface->stride];
+        auto cmp = &cbuffer[y * surface->compositor->image.w];
         for (uint32_t x = 0; x < w; ++x) {
             auto tmp = ALPHA_BLEND(color, surface->blender.alpha(*cmp));
             dst[x] = tmp + ALPHA_BLEND(dst[x], 255 - surface->blender.alpha(tmp));
@@ -149,7 +149,7 @@ static bool _translucentRectAlphaMask(SwSurface* surface, const SwBBox& region,
 
 static bool _translucentRectInvAlphaMask(SwSurface* surface, const SwBBox& region, uint32_t color)
 {
-    auto buffer = surface->buffer + (region.min.y * surface->stride) + region.min.x;
+    auto buffer = PIXEL(surface, region.min.x, region.min.y);
     auto h = static_cast<uint32_t>(region.max.y - region.min.y);
     auto w = static_cast<uint32_t>(region.max.x - region.min.x);
 
@@ -157,11 +157,11 @@ static bool _translucentRectInvAlphaMask(SwSurface* surface, const SwBBox& regio
     printf("SW_ENGINE: Rectangle Alpha Mask Composition\n");
 #endif
 
-    auto cbuffer = surface->compositor->image.data + (region.min.y * surface->stride) + region.min.x;   //compositor buffer
+    auto cbuffer = IMAGE_PIXEL(&surface->compositor->image, region.min.x, region.min.y);   //compositor buffer
 
     for (uint32_t y = 0; y < h; ++y) {
         auto dst = &buffer[y * surface->stride];
-        auto cmp = &cbuffer[y * surface->stride];
+        auto cmp = &cbuffer[y * surface->compositor->image.w];
         for (uint32_t x = 0; x < w; ++x) {
             auto ialpha = 255 - surface->blender.alpha(*cmp);
             auto tmp = ALPHA_BLEND(color, ialpha);
@@ -188,12 +188,12 @@ static bool _rasterTranslucentRect(SwSurface* surface, const SwBBox& region, uin
 
 static bool _rasterSolidRect(SwSurface* surface, const SwBBox& region, uint32_t color)
 {
-    auto buffer = surface->buffer + (region.min.y * surface->stride);
+    auto buffer = PIXEL(surface, region.min.x, region.min.y);
     auto w = static_cast<uint32_t>(region.max.x - region.min.x);
     auto h = static_cast<uint32_t>(region.max.y - region.min.y);
 
     for (uint32_t y = 0; y < h; ++y) {
-        rasterRGBA32(buffer + y * surface->stride, color, region.min.x, w);
+        rasterRGBA32(buffer + y * surface->stride, color, 0, w);
     }
     return true;
 }
@@ -210,7 +210,7 @@ static bool _translucentRle(SwSurface* surface, SwRleData* rle, uint32_t color)
     uint32_t src;
 
     for (uint32_t i = 0; i < rle->size; ++i) {
-        auto dst = &surface->buffer[span->y * surface->stride + span->x];
+        auto dst = PIXEL(surface, span->x, span->y);
         if (span->coverage < 255) src = ALPHA_BLEND(color, span->coverage);
         else src = color;
         auto ialpha = 255 - surface->blender.alpha(src);
@@ -231,11 +231,10 @@ static bool _translucentRleAlphaMask(SwSurface* surface, SwRleData* rle, uint32_
     auto span = rle->spans;
     uint32_t src;
     auto tbuffer = static_cast<uint32_t*>(alloca(sizeof(uint32_t) * surface->w));  //temp buffer for intermediate processing
-    auto cbuffer = surface->compositor->image.data;
 
     for (uint32_t i = 0; i < rle->size; ++i) {
-        auto dst = &surface->buffer[span->y * surface->stride + span->x];
-        auto cmp = &cbuffer[span->y * surface->stride + span->x];
+        auto dst = PIXEL(surface, span->x, span->y);
+        auto cmp = IMAGE_PIXEL(&surface->compositor->image, span->x, span->y);
         auto tmp = tbuffer;
         if (span->coverage < 255) src = ALPHA_BLEND(color, span->coverage);
         else src = color;
@@ -258,11 +257,10 @@ static bool _translucentRleInvAlphaMask(SwSurface* surface, SwRleData* rle, uint
     auto span = rle->spans;
     uint32_t src;
     auto tbuffer = static_cast<uint32_t*>(alloca(sizeof(uint32_t) * surface->w));  //temp buffer for intermediate processing
-    auto cbuffer = surface->compositor->image.data;
 
     for (uint32_t i = 0; i < rle->size; ++i) {
-        auto dst = &surface->buffer[span->y * surface->stride + span->x];
-        auto cmp = &cbuffer[span->y * surface->stride + span->x];
+        auto dst = PIXEL(surface, span->x, span->y);
+        auto cmp = IMAGE_PIXEL(&surface->compositor->image, span->x, span->y);
         auto tmp = tbuffer;
         if (span->coverage < 255) src = ALPHA_BLEND(color, span->coverage);
         else src = color;
@@ -302,9 +300,9 @@ static bool _rasterSolidRle(SwSurface* surface, SwRleData* rle, uint32_t color)
 
     for (uint32_t i = 0; i < rle->size; ++i) {
         if (span->coverage == 255) {
-            rasterRGBA32(surface->buffer + span->y * surface->stride, color, span->x, span->len);
+            rasterRGBA32(PIXEL(surface, span->x, span->y), color, 0, span->len);
         } else {
-            auto dst = &surface->buffer[span->y * surface->stride + span->x];
+            auto dst = PIXEL(surface, span->x, span->y);
             auto src = ALPHA_BLEND(color, span->coverage);
             auto ialpha = 255 - span->coverage;
             for (uint32_t i = 0; i < span->len; ++i) {
@@ -329,7 +327,7 @@ static bool _rasterTranslucentImageRle(SwSurface* surface, SwRleData* rle, uint3
     for (uint32_t i = 0; i < rle->size; ++i) {
         auto ey1 = span->y * invTransform->e12 + invTransform->e13;
         auto ey2 = span->y * invTransform->e22 + invTransform->e23;
-        auto dst = &surface->buffer[span->y * surface->stride + span->x];
+        auto dst = PIXEL(surface, span->x, span->y);
         for (uint32_t x = 0; x < span->len; ++x, ++dst) {
             auto rX = static_cast<uint32_t>(roundf((span->x + x) * invTransform->e11 + ey1));
             auto rY = static_cast<uint32_t>(roundf((span->x + x) * invTransform->e21 + ey2));
@@ -351,7 +349,7 @@ static bool _rasterImageRle(SwSurface* surface, SwRleData* rle, uint32_t *img, u
     for (uint32_t i = 0; i < rle->size; ++i) {
         auto ey1 = span->y * invTransform->e12 + invTransform->e13;
         auto ey2 = span->y * invTransform->e22 + invTransform->e23;
-        auto dst = &surface->buffer[span->y * surface->stride + span->x];
+        auto dst = PIXEL(surface, span->x, span->y);
         for (uint32_t x = 0; x < span->len; ++x, ++dst) {
             auto rX = static_cast<uint32_t>(roundf((span->x + x) * invTransform->e11 + ey1));
             auto rY = static_cast<uint32_t>(roundf((span->x + x) * invTransform->e21 + ey2));
@@ -368,7 +366,7 @@ static bool _rasterImageRle(SwSurface* surface, SwRleData* rle, uint32_t *img, u
 static bool _translucentImage(SwSurface* surface, uint32_t *img, uint32_t w, uint32_t h, uint32_t opacity, const SwBBox& region, const Matrix* invTransform)
 {
     for (auto y = region.min.y; y < region.max.y; ++y) {
-        auto dst = &surface->buffer[y * surface->stride + region.min.x];
+        auto dst = PIXEL(surface, region.min.x, y);
         auto ey1 = y * invTransform->e12 + invTransform->e13;
         auto ey2 = y * invTransform->e22 + invTransform->e23;
         for (auto x = region.min.x; x < region.max.x; ++x, ++dst) {
@@ -389,8 +387,8 @@ static bool _translucentImageAlphaMask(SwSurface* surface, uint32_t *img, uint32
     printf("SW_ENGINE: Transformed Image Alpha Mask Composition\n");
 #endif
     for (auto y = region.min.y; y < region.max.y; ++y) {
-        auto dst = &surface->buffer[y * surface->stride + region.min.x];
-        auto cmp = &surface->compositor->image.data[y * surface->stride + region.min.x];
+        auto dst = PIXEL(surface, region.min.x, y);
+        auto cmp = IMAGE_PIXEL(&surface->compositor->image, region.min.x, y);
         float ey1 = y * invTransform->e12 + invTransform->e13;
         float ey2 = y * invTransform->e22 + invTransform->e23;
         for (auto x = region.min.x; x < region.max.x; ++x, ++dst, ++cmp) {
@@ -410,8 +408,8 @@ static bool _translucentImageInvAlphaMask(SwSurface* surface, uint32_t *img, uin
     printf("SW_ENGINE: Transformed Image Alpha Mask Composition\n");
 #endif
     for (auto y = region.min.y; y < region.max.y; ++y) {
-        auto dst = &surface->buffer[y * surface->stride + region.min.x];
-        auto cmp = &surface->compositor->image.data[y * surface->stride + region.min.x];
+        auto dst = PIXEL(surface, region.min.x, y);
+        auto cmp = IMAGE_PIXEL(&surface->compositor->image, region.min.x, y);
         float ey1 = y * invTransform->e12 + invTransform->e13;
         float ey2 = y * invTransform->e22 + invTransform->e23;
         for (auto x = region.min.x; x < region.max.x; ++x, ++dst, ++cmp) {
@@ -439,11 +437,11 @@ static bool _rasterTranslucentImage(SwSurface* surface, uint32_t *img, uint32_t
 }
 
 
-static bool _translucentImage(SwSurface* surface, uint32_t *img, uint32_t w, uint32_t h, uint32_t opacity, const SwBBox& region)
+static bool _translucentImage(SwSurface* surface, const SwImage* image, uint32_t opacity, const SwBBox& region)
 {
     for (auto y = region.min.y; y < region.max.y; ++y) {
-        auto dst = &surface->buffer[y * surface->stride + region.min.x];
-        auto src = img + region.min.x + (y * w);    //TODO: need to use image's stride
+        auto dst = PIXEL(surface, region.min.x, y);
+        auto src = IMAGE_PIXEL(image, region.min.x, y);    //TODO: need to use image's stride
         for (auto x = region.min.x; x < region.max.x; ++x, ++dst, ++src) {
             auto p = ALPHA_BLEND(*src, opacity);
             *dst = p + ALPHA_BLEND(*dst, 255 - surface->blender.alpha(p));
@@ -453,9 +451,9 @@ static bool _translucentImage(SwSurface* surface, uint32_t *img, uint32_t w, uin
 }
 
 
-static bool _translucentImageAlphaMask(SwSurface* surface, uint32_t *img, uint32_t w, uint32_t h, uint32_t opacity, const SwBBox& region)
+static bool _translucentImageAlphaMask(SwSurface* surface, const SwImage* image, uint32_t opacity, const SwBBox& region)
 {
-    auto buffer = surface->buffer + (region.min.y * surface->stride) + region.min.x;
+    auto buffer = PIXEL(surface, region.min.x, region.min.y);
     auto h2 = static_cast<uint32_t>(region.max.y - region.min.y);
     auto w2 = static_cast<uint32_t>(region.max.x - region.min.x);
 
@@ -463,13 +461,13 @@ static bool _translucentImageAlphaMask(SwSurface* surface, uint32_t *img, uint32
     printf("SW_ENGINE: Image Alpha Mask Composition\n");
 #endif
 
-    auto sbuffer = img + (region.min.y * w) + region.min.x;
-    auto cbuffer = surface->compositor->image.data + (region.min.y * surface->stride) + region.min.x;   //compositor buffer
+    auto sbuffer = IMAGE_PIXEL(image, region.min.x, region.min.y);
+    auto cbuffer = IMAGE_PIXEL(&surface->compositor->image, region.min.x, region.min.y);   //compositor buffer
 
     for (uint32_t y = 0; y < h2; ++y) {
         auto dst = &buffer[y * surface->stride];
-        auto cmp = &cbuffer[y * surface->stride];
-        auto src = &sbuffer[y * w];   //TODO: need to use image's stride
+        auto cmp = &cbuffer[y * surface->compositor->image.w];
+        auto src = &sbuffer[y * image->w];   //TODO: need to use image's stride
         for (uint32_t x = 0; x < w2; ++x, ++dst, ++src, ++cmp) {
             auto tmp = ALPHA_BLEND(*src, ALPHA_MULTIPLY(opacity, surface->blender.alpha(*cmp)));
             *dst = tmp + ALPHA_BLEND(*dst, 255 - surface->blender.alpha(tmp));
@@ -479,9 +477,9 @@ static bool _translucentImageAlphaMask(SwSurface* surface, uint32_t *img, uint32
 }
 
 
-static bool _translucentImageInvAlphaMask(SwSurface* surface, uint32_t *img, uint32_t w, uint32_t h, uint32_t opacity, const SwBBox& region)
+static bool _translucentImageInvAlphaMask(SwSurface* surface, const SwImage* image, uint32_t opacity, const SwBBox& region)
 {
-    auto buffer = surface->buffer + (region.min.y * surface->stride) + region.min.x;
+    auto buffer = PIXEL(surface, region.min.x, region.min.y);
     auto h2 = static_cast<uint32_t>(region.max.y - region.min.y);
     auto w2 = static_cast<uint32_t>(region.max.x - region.min.x);
 
@@ -489,13 +487,13 @@ static bool _translucentImageInvAlphaMask(SwSurface* surface, uint32_t *img, uin
     printf("SW_ENGINE: Image Alpha Mask Composition\n");
 #endif
 
-    auto sbuffer = img + (region.min.y * w) + region.min.x;
-    auto cbuffer = surface->compositor->image.data + (region.min.y * surface->stride) + region.min.x;   //compositor buffer
+    auto sbuffer = IMAGE_PIXEL(image, region.min.x, region.min.y);
+    auto cbuffer = IMAGE_PIXEL(&surface->compositor->image, region.min.x, region.min.y);   //compositor buffer
 
     for (uint32_t y = 0; y < h2; ++y) {
         auto dst = &buffer[y * surface->stride];
-        auto cmp = &cbuffer[y * surface->stride];
-        auto src = &sbuffer[y * w];   //TODO: need to use image's stride
+        auto cmp = &cbuffer[y * surface->compositor->image.w];
+        auto src = &sbuffer[y * image->w];   //TODO: need to use image's stride
         for (uint32_t x = 0; x < w2; ++x, ++dst, ++src, ++cmp) {
             auto ialpha = 255 - surface->blender.alpha(*cmp);
             auto tmp = ALPHA_BLEND(*src, ialpha);
@@ -505,25 +503,25 @@ static bool _translucentImageInvAlphaMask(SwSurface* surface, uint32_t *img, uin
     return true;
 }
 
-static bool _rasterTranslucentImage(SwSurface* surface, uint32_t *img, uint32_t w, uint32_t h, uint32_t opacity, const SwBBox& region)
+static bool _rasterTranslucentImage(SwSurface* surface, const SwImage* image, uint32_t opacity, const SwBBox& region)
 {
     if (surface->compositor) {
         if (surface->compositor->method == CompositeMethod::AlphaMask) {
-            return _translucentImageAlphaMask(surface, img, w, h, opacity, region);
+            return _translucentImageAlphaMask(surface, image, opacity, region);
         }
         if (surface->compositor->method == CompositeMethod::InvAlphaMask) {
-            return _translucentImageInvAlphaMask(surface, img, w, h, opacity, region);
+            return _translucentImageInvAlphaMask(surface, image, opacity, region);
         }
     }
-    return _translucentImage(surface, img, w, h, opacity, region);
+    return _translucentImage(surface, image, opacity, region);
 }
 
 
-static bool _rasterImage(SwSurface* surface, uint32_t *img, uint32_t w, uint32_t h, const SwBBox& region)
+static bool _rasterImage(SwSurface* surface, const SwImage* image, const SwBBox& region)
 {
     for (auto y = region.min.y; y < region.max.y; ++y) {
-        auto dst = &surface->buffer[y * surface->stride + region.min.x];
-        auto src = img + region.min.x + (y * w);    //TODO: need to use image's stride
+        auto dst = PIXEL(surface, region.min.x, y);
+        auto src = IMAGE_PIXEL(image, region.min.x, y);    //TODO: need to use image's stride
         for (auto x = region.min.x; x < region.max.x; x++, dst++, src++) {
             *dst = *src + ALPHA_BLEND(*dst, 255 - surface->blender.alpha(*src));
         }
@@ -535,7 +533,7 @@ static bool _rasterImage(SwSurface* surface, uint32_t *img, uint32_t w, uint32_t
 static bool _rasterImage(SwSurface* surface, uint32_t *img, uint32_t w, uint32_t h, const SwBBox& region, const Matrix* invTransform)
 {
     for (auto y = region.min.y; y < region.max.y; ++y) {
-        auto dst = &surface->buffer[y * surface->stride + region.min.x];
+        auto dst = PIXEL(surface, region.min.x, y);
         auto ey1 = y * invTransform->e12 + invTransform->e13;
         auto ey2 = y * invTransform->e22 + invTransform->e23;
         for (auto x = region.min.x; x < region.max.x; ++x, ++dst) {
@@ -558,7 +556,7 @@ static bool _rasterLinearGradientRect(SwSurface* surface, const SwBBox& region,
 {
     if (!fill || fill->linear.len < FLT_EPSILON) return false;
 
-    auto buffer = surface->buffer + (region.min.y * surface->stride) + region.min.x;
+    auto buffer = PIXEL(surface, region.min.x, region.min.y);
     auto h = static_cast<uint32_t>(region.max.y - region.min.y);
     auto w = static_cast<uint32_t>(region.max.x - region.min.x);
 
@@ -589,7 +587,7 @@ static bool _rasterRadialGradientRect(SwSurface* surface, const SwBBox& region,
 {
     if (!fill || fill->radial.a < FLT_EPSILON) return false;
 
-    auto buffer = surface->buffer + (region.min.y * surface->stride) + region.min.x;
+    auto buffer = PIXEL(surface, region.min.x, region.min.y);
     auto h = static_cast<uint32_t>(region.max.y - region.min.y);
     auto w = static_cast<uint32_t>(region.max.x - region.min.x);
 
@@ -629,7 +627,7 @@ static bool _rasterLinearGradientRle(SwSurface* surface, SwRleData* rle, const S
     //Translucent Gradient
     if (fill->translucent) {
         for (uint32_t i = 0; i < rle->size; ++i) {
-            auto dst = &surface->buffer[span->y * surface->stride + span->x];
+            auto dst = PIXEL(surface, span->x, span->y);
             fillFetchLinear(fill, buf, span->y, span->x, 0, span->len);
             if (span->coverage == 255) {
                 for (uint32_t i = 0; i < span->len; ++i) {
@@ -647,9 +645,9 @@ static bool _rasterLinearGradientRle(SwSurface* surface, SwRleData* rle, const S
     } else {
         for (uint32_t i = 0; i < rle->size; ++i) {
             if (span->coverage == 255) {
-                fillFetchLinear(fill, surface->buffer + span->y * surface->stride, span->y, span->x, span->x, span->len);
+                fillFetchLinear(fill, PIXEL(surface, span->x, span->y), span->y, span->x, 0, span->len);
             } else {
-                auto dst = &surface->buffer[span->y * surface->stride + span->x];
+                auto dst = PIXEL(surface, span->x, span->y);
                 fillFetchLinear(fill, buf, span->y, span->x, 0, span->len);
                 auto ialpha = 255 - span->coverage;
                 for (uint32_t i = 0; i < span->len; ++i) {
@@ -675,7 +673,7 @@ static bool _rasterRadialGradientRle(SwSurface* surface, SwRleData* rle, const S
     //Translucent Gradient
     if (fill->translucent) {
         for (uint32_t i = 0; i < rle->size; ++i) {
-            auto dst = &surface->buffer[span->y * surface->stride + span->x];
+            auto dst = PIXEL(surface, span->x, span->y);
             fillFetchRadial(fill, buf, span->y, span->x, span->len);
             if (span->coverage == 255) {
                 for (uint32_t i = 0; i < span->len; ++i) {
@@ -692,7 +690,7 @@ static bool _rasterRadialGradientRle(SwSurface* surface, SwRleData* rle, const S
     //Opaque Gradient
     } else {
         for (uint32_t i = 0; i < rle->size; ++i) {
-            auto dst = &surface->buffer[span->y * surface->stride + span->x];
+            auto dst = PIXEL(surface, span->x, span->y);
             if (span->coverage == 255) {
                 fillFetchRadial(fill, dst, span->y, span->x, span->len);
             } else {
@@ -785,11 +783,17 @@ bool rasterClear(SwSurface* surface)
 {
     if (!surface || !surface->buffer || surface->stride <= 0 || surface->w <= 0 || surface->h <= 0) return false;
 
-    if (surface->w == surface->stride) {
-        rasterRGBA32(surface->buffer, 0x00000000, 0, surface->w * surface->h);
+    if (surface->ox >= surface->w || surface->oy >= surface->h) return false;
+
+    //The buffer covers the surface from its origin
+    auto w = surface->w - surface->ox;
+    auto h = surface->h - surface->oy;
+
+    if (w == surface->stride) {
+        rasterRGBA32(surface->buffer, 0x00000000, 0, w * h);
     } else {
-        for (uint32_t i = 0; i < surface->h; i++) {
-            rasterRGBA32(surface->buffer + surface->stride * i, 0x00000000, 0, surface->w);
+        for (uint32_t i = 0; i < h; i++) {
+            rasterRGBA32(surface->buffer + surface->stride * i, 0x00000000, 0, w);
         }
     }
     return true;
@@ -821,14 +825,15 @@ bool rasterImage(SwSurface* surface, SwImage* image, const Matrix* transform, Sw
         }
     }
     else {
+        auto region = _clipRegion(surface, bbox);
         //Fast track
         if (_identify(transform)) {
             //OPTIMIZE ME: Support non transformed image. Only shifted image can use these routines.
-            if (translucent) return _rasterTranslucentImage(surface, image->data, image->w, image->h, opacity, bbox);
-            else return _rasterImage(surface, image->data, image->w, image->h, bbox);
+            if (translucent) return _rasterTranslucentImage(surface, image, opacity, region);
+            else return _rasterImage(surface, image, region);
         } else {
-            if (translucent) return _rasterTranslucentImage(surface, image->data, image->w, image->h, opacity, bbox, &invTransform);
-            else return _rasterImage(surface, image->data, image->w, image->h, bbox, &invTransform);
+            if (translucent) return _rasterTranslucentImage(surface, image->data, image->w, image->h, opacity, region, &invTransform);
+            else return _rasterImage(surface, image->data, image->w, image->h, region, &invTransform);
         }
     }
 }
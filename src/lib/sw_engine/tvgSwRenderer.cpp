@@ -19,7 +19,9 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
  * SOFTWARE.
  */
+#include <float.h>
 #include <math.h>
+#include <mutex>
 #include "tvgSwCommon.h"
 #include "tvgTaskScheduler.h"
 #include "tvgSwRenderer.h"
@@ -29,15 +31,34 @@
 /************************************************************************/
 static bool initEngine = false;
 static uint32_t rendererCnt = 0;
+static size_t memBudget = 0;                //soft limit of the engine memory, 0: unlimited
+static Array<SwRenderer*> renderers;        //for dropping the layer caches
+static mutex renderersMtx;                  //renderers are generated and trimmed on any thread
+
+
+static uint32_t _precision(Quality level)
+{
+    if (level == Quality::Draft) return SW_PRECISION_DRAFT;
+    if (level == Quality::High) return SW_PRECISION_HIGH;
+    return SW_PRECISION_NORMAL;
+}
+
+
+static bool _overlap(const SwBBox& bbox, const SwBBox& region)
+{
+    return !(region.min.x >= bbox.max.x || region.min.y >= bbox.max.y || region.max.x <= bbox.min.x || region.max.y <= bbox.min.y);
+}
 
 
 struct SwTask : Task
 {
-    Matrix* transform = nullptr;
+    Matrix m;                             //Transform storage
+    Matrix* transform = nullptr;          //Refers m if it's transformed
     SwSurface* surface = nullptr;
     RenderUpdateFlag flags = RenderUpdateFlag::None;
     Array<RenderData> clips;
     uint32_t opacity;
+    uint32_t precision = SW_PRECISION_NORMAL;   //Curve flattening precision
     SwBBox bbox = {{0, 0}, {0, 0}};       //Whole Rendering Region
 
     void bounds(uint32_t* x, uint32_t* y, uint32_t* w, uint32_t* h)
@@ -53,19 +74,247 @@ struct SwTask : Task
     }
 
     virtual bool dispose() = 0;
+    virtual bool hit(const SwBBox& region, uint8_t threshold) = 0;
+};
+
+
+static bool _instanceRegion(const Shape* sdata, const Matrix& m, SwBBox& region)
+{
+    const Point* pts;
+    auto cnt = sdata->pathCoords(&pts);
+    if (cnt == 0) return false;
+
+    auto minx = FLT_MAX, miny = FLT_MAX;
+    auto maxx = -FLT_MAX, maxy = -FLT_MAX;
+
+    for (uint32_t i = 0; i < cnt; ++i) {
+        auto x = pts[i].x * m.e11 + pts[i].y * m.e12 + m.e13;
+        auto y = pts[i].x * m.e21 + pts[i].y * m.e22 + m.e23;
+        if (x < minx) minx = x;
+        if (y < miny) miny = y;
+        if (x > maxx) maxx = x;
+        if (y > maxy) maxy = y;
+    }
+
+    //Stroking spreads out up to the miter limit (4), otherwise the square cap.
+    auto sx = sqrtf(m.e11 * m.e11 + m.e21 * m.e21);
+    auto sy = sqrtf(m.e12 * m.e12 + m.e22 * m.e22);
+    auto margin = sdata->strokeWidth() * 0.5f * (sx > sy ? sx : sy);
+    margin *= (sdata->strokeJoin() == StrokeJoin::Miter) ? 4.0f : 1.5f;
+
+    //1 more pixel for the sub-pixel phase
+    region.min.x = static_cast<SwCoord>(floorf(minx - margin)) - 2;
+    region.min.y = static_cast<SwCoord>(floorf(miny - margin)) - 2;
+    region.max.x = static_cast<SwCoord>(ceilf(maxx + margin)) + 2;
+    region.max.y = static_cast<SwCoord>(ceilf(maxy + margin)) + 2;
+
+    //Span has 16 bits coordinates
+    if (region.max.x - region.min.x > INT16_MAX || region.max.y - region.min.y > INT16_MAX) return false;
+
+    return true;
+}
+
+
+struct SwInstanceGroup
+{
+    SwShape shape;
+    SwBBox bbox = {{0, 0}, {0, 0}};     //Prepared Region
+    SwCoord phaseX, phaseY;             //Sub-pixel phase of the shared placements (26.6)
+};
+
+
+struct SwInstance
+{
+    SwInstanceGroup* group;
+    SwCoord x, y;                       //Pixel offset from the prepared group
+    uint8_t opacity;
 };
 
 
 struct SwShapeTask : SwTask
 {
+    TVG_DECLARE_POOL(SwShapeTask);
+
     SwShape shape;
     const Shape* sdata = nullptr;
+    const PathCmd* cmds = nullptr;          //path of the sdata, handed over on every prepare
+    uint32_t cmdCnt = 0;
     bool cmpStroking;
 
+    Array<SwInstanceGroup*> groups;         //Prepared shapes for the instances
+    Array<SwInstance> instances;
+    SwRleData instRle = {nullptr, 0, 0};    //Placed instance spans
+    SwRleData instStrokeRle = {nullptr, 0, 0};
+
+    SwInstanceGroup* prepareGroup(unsigned tid, const Matrix& m, float tx, float ty, const SwSize& clip, uint32_t opacity, uint8_t strokeAlpha, float strokeWidth)
+    {
+        auto group = new SwInstanceGroup;
+        if (!group) return nullptr;
+
+        auto shape = &group->shape;
+        shape->rect = false;
+
+        auto transform = m;
+        transform.e13 += tx;
+        transform.e23 += ty;
+
+        uint8_t alpha = 0;
+        sdata->fillColor(nullptr, nullptr, nullptr, &alpha);
+        alpha = static_cast<uint8_t>(static_cast<uint32_t>(alpha) * opacity / 255);
+        bool renderShape = (alpha > 0 || sdata->fill());
+
+        if (!renderShape && !strokeAlpha) goto err;
+        if (!shapePrepare(shape, sdata, cmds, cmdCnt, tid, clip, &transform, group->bbox)) goto err;
+
+        if (renderShape) {
+            auto antiAlias = (strokeAlpha == 255 && strokeWidth > 2) ? false : true;
+            //No fast track, the rectangle is placed with the spans.
+            if (!shapeGenRle(shape, sdata, clip, antiAlias, true, precision)) goto err;
+            if (auto fill = sdata->fill()) {
+                shapeResetFill(shape);
+                if (!shapeGenFillColors(shape, fill, &transform, surface, opacity, true)) goto err;
+            }
+        }
+
+        if (strokeAlpha > 0) {
+            shapeResetStroke(shape, sdata, &transform, precision);
+            if (!shapeGenStrokeRle(shape, sdata, cmds, cmdCnt, tid, &transform, clip, group->bbox)) goto err;
+        }
+
+        for (auto clip = clips.data; clip < (clips.data + clips.count); ++clip) {
+            auto clipper = &static_cast<SwShapeTask*>(*clip)->shape;
+            if (shape->rle) {
+                if (clipper->rect) rleClipRect(shape->rle, &clipper->bbox, tid);
+                else if (clipper->rle) rleClipPath(shape->rle, clipper->rle, tid);
+            }
+            if (shape->strokeRle) {
+                if (clipper->rect) rleClipRect(shape->strokeRle, &clipper->bbox, tid);
+                else if (clipper->rle) rleClipPath(shape->strokeRle, clipper->rle, tid);
+            }
+        }
+
+        shapeDelOutline(shape, tid);
+        return group;
+
+    err:
+        shapeDelOutline(shape, tid);
+        shapeFree(shape);
+        delete(group);
+        return nullptr;
+    }
+
+    void runInstances(unsigned tid, const Point* offsets, const uint8_t* opacities, uint32_t cnt)
+    {
+        clearInstances();
+        shapeReset(&shape);
+        bbox = {{0, 0}, {0, 0}};
+
+        uint8_t strokeAlpha = 0;
+        auto strokeWidth = sdata->strokeWidth();
+        if (HALF_STROKE(strokeWidth) > 0) {
+            sdata->strokeColor(nullptr, nullptr, nullptr, &strokeAlpha);
+        }
+
+        Matrix m = {1, 0, 0, 0, 1, 0, 0, 0, 1};
+        if (transform) m = *transform;
+
+        SwSize clip = {static_cast<SwCoord>(surface->w), static_cast<SwCoord>(surface->h)};
+
+        /* Placements can share the spans only if the shape is fully prepared.
+           Gradient and clipping depend on the position, prepare each of them. */
+        SwBBox region = {{0, 0}, {0, 0}};
+        auto exact = (sdata->fill() || clips.count > 0 || !_instanceRegion(sdata, m, region));
+        SwSize size = {region.max.x - region.min.x, region.max.y - region.min.y};
+
+        auto first = true;
+
+        for (uint32_t i = 0; i < cnt; ++i) {
+            SwInstance inst;
+            inst.group = nullptr;
+            inst.opacity = opacities[i];
+
+            if (exact) {
+                inst.x = inst.y = 0;
+                auto opacity = static_cast<uint32_t>(this->opacity) * opacities[i] / 255;
+                if (opacity == 0) continue;
+                inst.group = prepareGroup(tid, m, offsets[i].x, offsets[i].y, clip, opacity, strokeAlpha, strokeWidth);
+                if (!inst.group) continue;
+                inst.group->phaseX = inst.group->phaseY = 0;
+            } else {
+                auto x = static_cast<SwCoord>(roundf(offsets[i].x * 64.0f));
+                auto y = static_cast<SwCoord>(roundf(offsets[i].y * 64.0f));
+                auto phaseX = x & 63;
+                auto phaseY = y & 63;
+                inst.x = region.min.x + (x >> 6);
+                inst.y = region.min.y + (y >> 6);
+
+                //Same sub-pixel phase shares the spans
+                for (auto group = groups.data; group < (groups.data + groups.count); ++group) {
+                    if ((*group)->phaseX == phaseX && (*group)->phaseY == phaseY) {
+                        inst.group = *group;
+                        break;
+                    }
+                }
+                if (!inst.group) {
+                    inst.group = prepareGroup(tid, m, phaseX / 64.0f - region.min.x, phaseY / 64.0f - region.min.y, size, opacity, strokeAlpha, strokeWidth);
+                    if (!inst.group) return;
+                    inst.group->phaseX = phaseX;
+                    inst.group->phaseY = phaseY;
+                    groups.push(inst.group);
+                }
+            }
+
+            if (exact) groups.push(inst.group);
+            instances.push(inst);
+
+            //Merge regions
+            auto& gbox = inst.group->bbox;
+            if (first || gbox.min.x + inst.x < bbox.min.x) bbox.min.x = gbox.min.x + inst.x;
+            if (first || gbox.min.y + inst.y < bbox.min.y) bbox.min.y = gbox.min.y + inst.y;
+            if (first || gbox.max.x + inst.x > bbox.max.x) bbox.max.x = gbox.max.x + inst.x;
+            if (first || gbox.max.y + inst.y > bbox.max.y) bbox.max.y = gbox.max.y + inst.y;
+            first = false;
+        }
+
+        if (bbox.max.x > clip.w) bbox.max.x = clip.w;
+        if (bbox.max.y > clip.h) bbox.max.y = clip.h;
+    }
+
+    SwShape* place(const SwInstance& inst, SwShape& view, const SwSize& clip)
+    {
+        auto shape = &inst.group->shape;
+        if (inst.x == 0 && inst.y == 0) return shape;
+
+        view = *shape;
+        view.rle = rleTranslate(shape->rle, &instRle, inst.x, inst.y, clip) ? &instRle : nullptr;
+        view.strokeRle = rleTranslate(shape->strokeRle, &instStrokeRle, inst.x, inst.y, clip) ? &instStrokeRle : nullptr;
+
+        return &view;
+    }
+
+    void clearInstances()
+    {
+        for (auto group = groups.data; group < (groups.data + groups.count); ++group) {
+            shapeFree(&(*group)->shape);
+            delete(*group);
+        }
+        groups.clear();
+        instances.clear();
+    }
+
     void run(unsigned tid) override
     {
         if (opacity == 0) return;  //Invisible
 
+        //Instancing
+        const Point* offsets;
+        const uint8_t* opacities;
+        if (auto cnt = sdata->instances(&offsets, &opacities)) {
+            runInstances(tid, offsets, opacities, cnt);
+            return;
+        }
+        if (groups.count > 0) clearInstances();
+
         /* Valid filling & stroking each increases the value by 1.
            This value is referenced for compositing shape & stroking. */
         uint32_t addStroking = 0;
@@ -91,13 +340,13 @@ struct SwShapeTask : SwTask
             bool renderShape = (alpha > 0 || sdata->fill());
             if (renderShape || strokeAlpha) {
                 shapeReset(&shape);
-                if (!shapePrepare(&shape, sdata, tid, clip, transform, bbox)) goto err;
+                if (!shapePrepare(&shape, sdata, cmds, cmdCnt, tid, clip, transform, bbox)) goto err;
                 if (renderShape) {
                     /* We assume that if stroke width is bigger than 2,
                        shape outline below stroke could be full covered by stroke drawing.
                        Thus it turns off antialising in that condition. */
                     auto antiAlias = (strokeAlpha == 255 && strokeWidth > 2) ? false : true;
-                    if (!shapeGenRle(&shape, sdata, clip, antiAlias, clips.count > 0 ? true : false)) goto err;
+                    if (!shapeGenRle(&shape, sdata, clip, antiAlias, clips.count > 0 ? true : false, precision)) goto err;
                     ++addStroking;
                 }
             }
@@ -119,8 +368,8 @@ struct SwShapeTask : SwTask
         //Stroke
         if (flags & (RenderUpdateFlag::Stroke | RenderUpdateFlag::Transform)) {
             if (strokeAlpha > 0) {
-                shapeResetStroke(&shape, sdata, transform);
-                if (!shapeGenStrokeRle(&shape, sdata, tid, transform, clip, bbox)) goto err;
+                shapeResetStroke(&shape, sdata, transform, precision);
+                if (!shapeGenStrokeRle(&shape, sdata, cmds, cmdCnt, tid, transform, clip, bbox)) goto err;
                 ++addStroking;
             } else {
                 shapeDelStroke(&shape);
@@ -132,13 +381,13 @@ struct SwShapeTask : SwTask
             auto clipper = &static_cast<SwShapeTask*>(*clip)->shape;
             //Clip shape rle
             if (shape.rle) {
-                if (clipper->rect) rleClipRect(shape.rle, &clipper->bbox);
-                else if (clipper->rle) rleClipPath(shape.rle, clipper->rle);
+                if (clipper->rect) rleClipRect(shape.rle, &clipper->bbox, tid);
+                else if (clipper->rle) rleClipPath(shape.rle, clipper->rle, tid);
             }
             //Clip stroke rle
             if (shape.strokeRle) {
-                if (clipper->rect) rleClipRect(shape.strokeRle, &clipper->bbox);
-                else if (clipper->rle) rleClipPath(shape.strokeRle, clipper->rle);
+                if (clipper->rect) rleClipRect(shape.strokeRle, &clipper->bbox, tid);
+                else if (clipper->rle) rleClipPath(shape.strokeRle, clipper->rle, tid);
             }
         }
         goto end;
@@ -154,13 +403,53 @@ struct SwShapeTask : SwTask
     bool dispose() override
     {
        shapeFree(&shape);
+       clearInstances();
+       if (instRle.spans) free(instRle.spans);
+       if (instStrokeRle.spans) free(instStrokeRle.spans);
+       mpoolCount(SW_MEM_RLE, -(int64_t)((instRle.alloc + instStrokeRle.alloc) * sizeof(SwSpan)));
        return true;
     }
+
+    bool hit(const SwShape& shape, const SwBBox& region, uint8_t threshold)
+    {
+        uint8_t alpha = 0;
+
+        //Fill
+        sdata->fillColor(nullptr, nullptr, nullptr, &alpha);
+        if (alpha > 0 || sdata->fill()) {
+            if (shape.rect) {
+                if (_overlap(shape.bbox, region)) return true;
+            } else if (rleHit(shape.rle, region, threshold)) return true;
+        }
+
+        //Stroke
+        if (sdata->strokeColor(nullptr, nullptr, nullptr, &alpha) == Result::Success && alpha > 0) {
+            if (rleHit(shape.strokeRle, region, threshold)) return true;
+        }
+        return false;
+    }
+
+    bool hit(const SwBBox& region, uint8_t threshold) override
+    {
+        if (opacity == 0 || !_overlap(bbox, region)) return false;
+
+        if (instances.count == 0) return hit(shape, region, threshold);
+
+        for (auto inst = instances.data; inst < (instances.data + instances.count); ++inst) {
+            if (inst->opacity == 0) continue;
+            SwBBox local = {{region.min.x - inst->x, region.min.y - inst->y}, {region.max.x - inst->x, region.max.y - inst->y}};
+            if (!_overlap(inst->group->bbox, local)) continue;
+            if (hit(inst->group->shape, local, threshold)) return true;
+        }
+        return false;
+    }
 };
 
 
 struct SwImageTask : SwTask
 {
+    TVG_DECLARE_POOL(SwImageTask);
+
     SwImage image;
     const Picture* pdata = nullptr;
 
@@ -182,8 +471,8 @@ struct SwImageTask : SwTask
                 if (image.rle) {
                     for (auto clip = clips.data; clip < (clips.data + clips.count); ++clip) {
                         auto clipper = &static_cast<SwShapeTask*>(*clip)->shape;
-                        if (clipper->rect) rleClipRect(image.rle, &clipper->bbox);
-                        else if (clipper->rle) rleClipPath(image.rle, clipper->rle);
+                        if (clipper->rect) rleClipRect(image.rle, &clipper->bbox, tid);
+                        else if (clipper->rle) rleClipPath(image.rle, clipper->rle, tid);
                     }
                 }
             }
@@ -198,6 +487,13 @@ struct SwImageTask : SwTask
        imageFree(&image);
        return true;
     }
+
+    bool hit(const SwBBox& region, uint8_t threshold) override
+    {
+        if (opacity == 0 || !_overlap(bbox, region)) return false;
+        if (image.rle) return rleHit(image.rle, region, threshold);
+        return true;
+    }
 };
 
 
@@ -219,6 +515,16 @@ SwRenderer::~SwRenderer()
 
     if (surface) delete(surface);
 
+    {
+        lock_guard<mutex> lock(renderersMtx);
+        for (uint32_t i = 0; i < renderers.count; ++i) {
+            if (renderers.data[i] == this) {
+                renderers.data[i] = renderers.data[--renderers.count];
+                break;
+            }
+        }
+    }
+
     --rendererCnt;
     if (!initEngine) _termEngine();
 }
@@ -233,6 +539,13 @@ bool SwRenderer::clear()
 }
 
 
+bool SwRenderer::quality(Quality q)
+{
+    level = q;
+    return true;
+}
+
+
 bool SwRenderer::sync()
 {
     return true;
@@ -246,6 +559,7 @@ bool SwRenderer::target(uint32_t* buffer, uint32_t stride, uint32_t w, uint32_t
     if (!surface) {
         surface = new SwSurface;
         if (!surface) return false;
+        mainSurface = surface;
     }
 
     surface->buffer = buffer;
@@ -260,6 +574,8 @@ bool SwRenderer::target(uint32_t* buffer, uint32_t stride, uint32_t w, uint32_t
 
 bool SwRenderer::preRender()
 {
+    if (dropCache.exchange(false)) dropCaches();
+
     return rasterClear(surface);
 }
 
@@ -271,11 +587,26 @@ bool SwRenderer::postRender()
     //Free Composite Caches
     for (auto comp = compositors.data; comp < (compositors.data + compositors.count); ++comp) {
         free((*comp)->compositor->image.data);
+        mpoolCount(SW_MEM_IMAGE, -(int64_t)(sizeof(uint32_t) * (*comp)->compositor->image.w * (*comp)->compositor->image.h));
         delete((*comp)->compositor);
         delete(*comp);
     }
     compositors.reset();
 
+#ifdef THORVG_LOG_ENABLED
+    printf("SW_ENGINE: Scratch Arena High-Water Mark = %u bytes\n", mpoolScratchPeak());
+#endif
+
+    //Over the budget, release the pools first and then the own layer caches.
+    if (memBudget > 0) {
+        MemoryUsage mem;
+        usage(&mem);
+        if (mem.pool + mem.block + mem.rle + mem.ctable + mem.image > memBudget) {
+            trim(0);
+            if (mem.rle + mem.ctable + mem.image > memBudget) dropCaches();
+        }
+    }
+
     return true;
 }
 
@@ -291,57 +622,123 @@ bool SwRenderer::renderImage(RenderData data)
 }
 
 
-bool SwRenderer::renderShape(RenderData data)
+bool SwRenderer::rasterShape(const Shape* sdata, SwShape* shape, uint32_t opacity, bool cmpStroking, const SwBBox& bbox)
 {
-    auto task = static_cast<SwShapeTask*>(data);
-    task->done();
-
-    if (task->opacity == 0) return true;
-
-    uint32_t opacity;
     Compositor* cmp = nullptr;
+    auto cmpOpacity = opacity;
 
     //Do Stroking Composition
-    if (task->cmpStroking) {
-        uint32_t x, y, w, h;
-        task->bounds(&x, &y, &w, &h);
+    if (cmpStroking) {
+        auto x = bbox.min.x > 0 ? bbox.min.x : 0;
+        auto y = bbox.min.y > 0 ? bbox.min.y : 0;
         opacity = 255;
-        cmp = target(x, y, w, h);
-        beginComposite(cmp, CompositeMethod::None, task->opacity);
-    //No Stroking Composition
-    } else {
-        opacity = task->opacity;
+        cmp = target(x, y, bbox.max.x - x, bbox.max.y - y);
+        beginComposite(cmp, CompositeMethod::None, cmpOpacity);
     }
 
     //Main raster stage
     uint8_t r, g, b, a;
 
-    if (auto fill = task->sdata->fill()) {
-        rasterGradientShape(surface, &task->shape, fill->id());
+    if (auto fill = sdata->fill()) {
+        rasterGradientShape(surface, shape, fill->id());
     } else {
-        task->sdata->fillColor(&r, &g, &b, &a);
+        sdata->fillColor(&r, &g, &b, &a);
         a = static_cast<uint8_t>((opacity * (uint32_t) a) / 255);
-        if (a > 0) rasterSolidShape(surface, &task->shape, r, g, b, a);
+        if (a > 0) rasterSolidShape(surface, shape, r, g, b, a);
     }
 
-    if (task->sdata->strokeColor(&r, &g, &b, &a) == Result::Success) {
+    if (sdata->strokeColor(&r, &g, &b, &a) == Result::Success) {
         a = static_cast<uint8_t>((opacity * (uint32_t) a) / 255);
-        if (a > 0) rasterStroke(surface, &task->shape, r, g, b, a);
+        if (a > 0) rasterStroke(surface, shape, r, g, b, a);
     }
 
-    if (task->cmpStroking) endComposite(cmp);
+    if (cmpStroking) endComposite(cmp);
 
     return true;
 }
 
+
+bool SwRenderer::renderShape(RenderData data)
+{
+    auto task = static_cast<SwShapeTask*>(data);
+    task->done();
+
+    if (task->opacity == 0) return true;
+
+    //Instancing
+    if (task->instances.count > 0) {
+        uint8_t fillAlpha, strokeAlpha = 0;
+        task->sdata->fillColor(nullptr, nullptr, nullptr, &fillAlpha);
+        task->sdata->strokeColor(nullptr, nullptr, nullptr, &strokeAlpha);
+        auto stroking = ((fillAlpha > 0 || task->sdata->fill()) && strokeAlpha > 0);
+
+        SwSize clip = {static_cast<SwCoord>(surface->w), static_cast<SwCoord>(surface->h)};
+        SwShape view;
+
+        for (auto inst = task->instances.data; inst < (task->instances.data + task->instances.count); ++inst) {
+            auto opacity = static_cast<uint32_t>(task->opacity) * inst->opacity / 255;
+            if (opacity == 0) continue;
+            auto& gbox = inst->group->bbox;
+            SwBBox bbox = {{gbox.min.x + inst->x, gbox.min.y + inst->y}, {gbox.max.x + inst->x, gbox.max.y + inst->y}};
+            if (bbox.max.x <= 0 || bbox.max.y <= 0 || bbox.min.x >= clip.w || bbox.min.y >= clip.h) continue;
+            rasterShape(task->sdata, task->place(*inst, view, clip), opacity, stroking && opacity < 255, bbox);
+        }
+        return true;
+    }
+
+    SwBBox bbox;
+    uint32_t x, y, w, h;
+    task->bounds(&x, &y, &w, &h);
+    bbox.min.x = x;
+    bbox.min.y = y;
+    bbox.max.x = x + w;
+    bbox.max.y = y + h;
+
+    return rasterShape(task->sdata, &task->shape, task->opacity, task->cmpStroking, bbox);
+}
+
 bool SwRenderer::region(RenderData data, uint32_t* x, uint32_t* y, uint32_t* w, uint32_t* h)
 {
-    static_cast<SwTask*>(data)->bounds(x, y, w, h);
+    auto task = static_cast<SwTask*>(data);
+
+    //Bounding box is valid only after the preparation
+    task->done();
+    task->bounds(x, y, w, h);
 
     return true;
 }
 
 
+bool SwRenderer::viewport(uint32_t* x, uint32_t* y, uint32_t* w, uint32_t* h)
+{
+    if (!surface) return false;
+
+    *x = 0;
+    *y = 0;
+    *w = surface->w;
+    *h = surface->h;
+
+    return true;
+}
+
+
+bool SwRenderer::hit(RenderData data, uint32_t x, uint32_t y, uint32_t w, uint32_t h, uint8_t threshold)
+{
+    auto task = static_cast<SwTask*>(data);
+    if (!task) return false;
+
+    task->done();
+
+    SwBBox region;
+    region.min.x = x;
+    region.min.y = y;
+    region.max.x = x + w;
+    region.max.y = y + h;
+
+    return task->hit(region, threshold);
+}
+
+
 bool SwRenderer::beginComposite(Compositor* cmp, CompositeMethod method, uint32_t opacity)
 {
     if (!cmp) return false;
@@ -364,9 +761,9 @@ Compositor* SwRenderer::target(uint32_t x, uint32_t y, uint32_t w, uint32_t h)
 {
     SwSurface* cmp = nullptr;
 
-    //Use cached data
+    //Use cached data, the layout must follow the canvas target
     for (auto p = compositors.data; p < (compositors.data + compositors.count); ++p) {
-        if ((*p)->compositor->valid) {
+        if ((*p)->compositor->valid && (*p)->stride == mainSurface->stride && (*p)->h == mainSurface->h) {
             cmp = *p;
             break;
         }
@@ -377,21 +774,25 @@ Compositor* SwRenderer::target(uint32_t x, uint32_t y, uint32_t w, uint32_t h)
         cmp = new SwSurface;
         if (!cmp) goto err;
 
-        //Inherits attributes from main surface
-        *cmp = *surface;
+        //Inherits attributes from main surface, a layer cache only covers its own region
+        *cmp = *mainSurface;
 
         cmp->compositor = new SwCompositor;
         if (!cmp->compositor) goto err;
 
         //SwImage, Optimize Me: Surface size from MainSurface(WxH) to Parameter W x H
-        cmp->compositor->image.data = (uint32_t*) malloc(sizeof(uint32_t) * surface->w * surface->h);
+        cmp->compositor->image.w = mainSurface->stride;
+        cmp->compositor->image.h = mainSurface->h;
+        cmp->compositor->image.data = (uint32_t*) malloc(sizeof(uint32_t) * cmp->compositor->image.w * cmp->compositor->image.h);
         if (!cmp->compositor->image.data) goto err;
+        mpoolCount(SW_MEM_IMAGE, sizeof(uint32_t) * cmp->compositor->image.w * cmp->compositor->image.h);
+        cmp->buffer = cmp->compositor->image.data;
         compositors.push(cmp);
     }
 
     //Boundary Check
-    if (x + w > surface->w) w = (surface->w - x);
-    if (y + h > surface->h) h = (surface->h - y);
+    if (x + w > cmp->w) w = (x < cmp->w) ? (cmp->w - x) : 0;
+    if (y + h > cmp->h) h = (y < cmp->h) ? (cmp->h - y) : 0;
 
 #ifdef THORVG_LOG_ENABLED
     printf("SW_ENGINE: Using intermediate composition [Region: %d %d %d %d]\n", x, y, w, h);
@@ -404,20 +805,11 @@ Compositor* SwRenderer::target(uint32_t x, uint32_t y, uint32_t w, uint32_t h)
     cmp->compositor->bbox.min.y = y;
     cmp->compositor->bbox.max.x = x + w;
     cmp->compositor->bbox.max.y = y + h;
-    cmp->compositor->image.w = surface->w;
-    cmp->compositor->image.h = surface->h;
 
     //We know partial clear region
-    cmp->buffer = cmp->compositor->image.data + (cmp->stride * y + x);
-    cmp->w = w;
-    cmp->h = h;
-
-    rasterClear(cmp);
-
-    //Recover context
-    cmp->buffer = cmp->compositor->image.data;
-    cmp->w = cmp->compositor->image.w;
-    cmp->h = cmp->compositor->image.h;
+    for (auto cy = y; cy < y + h; ++cy) {
+        rasterRGBA32(PIXEL(cmp, x, cy), 0x00000000, 0, w);
+    }
 
     //Switch render target
     surface = cmp;
@@ -454,14 +846,178 @@ bool SwRenderer::endComposite(Compositor* cmp)
 }
 
 
+RenderData SwRenderer::beginCache(RenderData data, uint32_t x, uint32_t y, uint32_t w, uint32_t h)
+{
+    if (x >= surface->w || y >= surface->h || x + w <= surface->ox || y + h <= surface->oy) return nullptr;
+
+    auto cache = static_cast<SwCache*>(data);
+
+    //The layer can be shifted only if nothing is cut off
+    auto complete = (x > surface->ox && y > surface->oy && x + w < surface->w && y + h < surface->h);
+
+    //Boundary Check
+    if (x < surface->ox) {
+        w -= (surface->ox - x);
+        x = surface->ox;
+    }
+    if (y < surface->oy) {
+        h -= (surface->oy - y);
+        y = surface->oy;
+    }
+    if (x + w > surface->w) w = (surface->w - x);
+    if (y + h > surface->h) h = (surface->h - y);
+
+    if (!cache) {
+        cache = new SwCache;
+        if (!cache) return nullptr;
+        cache->image.data = nullptr;
+        cache->image.w = cache->image.h = 0;
+        caches.push(cache);
+    }
+
+    //Region has been changed, recreate the layer buffer
+    if (cache->image.data && (cache->image.w != w || cache->image.h != h)) {
+        free(cache->image.data);
+        mpoolCount(SW_MEM_IMAGE, -(int64_t)(sizeof(uint32_t) * cache->image.w * cache->image.h));
+        cache->image.data = nullptr;
+    }
+
+    if (!cache->image.data) {
+        cache->image.data = (uint32_t*) malloc(sizeof(uint32_t) * w * h);
+        if (!cache->image.data) {
+            disposeCache(cache);
+            return nullptr;
+        }
+        cache->image.w = w;
+        cache->image.h = h;
+        mpoolCount(SW_MEM_IMAGE, sizeof(uint32_t) * w * h);
+    }
+
+#ifdef THORVG_LOG_ENABLED
+    printf("SW_ENGINE: Using layer cache [Region: %d %d %d %d]\n", x, y, w, h);
+#endif
+
+    cache->bbox.min.x = x;
+    cache->bbox.min.y = y;
+    cache->bbox.max.x = x + w;
+    cache->bbox.max.y = y + h;
+    cache->w = surface->w;
+    cache->h = surface->h;
+    cache->complete = complete;
+
+    //Inherits attributes from main surface
+    cache->surface = *surface;
+    cache->surface.compositor = nullptr;
+
+    //The layer buffer covers the region, the children are drawn in the surface coordinates
+    cache->surface.buffer = cache->image.data;
+    cache->surface.stride = w;
+    cache->surface.ox = x;
+    cache->surface.oy = y;
+    cache->surface.w = x + w;
+    cache->surface.h = y + h;
+
+    rasterClear(&cache->surface);
+
+    //Switch render target
+    cache->recoverSfc = surface;
+    surface = &cache->surface;
+
+    return cache;
+}
+
+
+bool SwRenderer::endCache(RenderData data)
+{
+    auto cache = static_cast<SwCache*>(data);
+    if (!cache) return false;
+
+    surface = cache->recoverSfc;
+
+    return true;
+}
+
+
+bool SwRenderer::renderCache(RenderData data, int32_t dx, int32_t dy, uint32_t opacity)
+{
+    auto cache = static_cast<SwCache*>(data);
+    if (!cache) return false;
+
+    if (opacity == 0) return true;
+
+    //Shifted region on the current surface
+    SwBBox bbox;
+    bbox.min.x = cache->bbox.min.x + dx;
+    bbox.min.y = cache->bbox.min.y + dy;
+    bbox.max.x = cache->bbox.max.x + dx;
+    bbox.max.y = cache->bbox.max.y + dy;
+
+    if (bbox.min.x < static_cast<SwCoord>(surface->ox)) bbox.min.x = surface->ox;
+    if (bbox.min.y < static_cast<SwCoord>(surface->oy)) bbox.min.y = surface->oy;
+    if (bbox.max.x > static_cast<SwCoord>(surface->w)) bbox.max.x = surface->w;
+    if (bbox.max.y > static_cast<SwCoord>(surface->h)) bbox.max.y = surface->h;
+
+    if (bbox.max.x <= bbox.min.x || bbox.max.y <= bbox.min.y) return true;
+
+    //The layer image begins at the shifted region
+    SwImage image;
+    image.data = cache->image.data;
+    image.w = cache->image.w;
+    image.h = cache->image.h;
+    image.ox = cache->bbox.min.x + dx;
+    image.oy = cache->bbox.min.y + dy;
+
+    return rasterImage(surface, &image, nullptr, bbox, opacity);
+}
+
+
+bool SwRenderer::reusable(RenderData data, int32_t dx, int32_t dy)
+{
+    auto cache = static_cast<SwCache*>(data);
+    if (!cache || !surface) return false;
+
+    if (!cache->image.data || cache->w != surface->w || cache->h != surface->h) return false;
+
+    return (cache->complete || (dx == 0 && dy == 0));
+}
+
+
+bool SwRenderer::disposeCache(RenderData data)
+{
+    auto cache = static_cast<SwCache*>(data);
+    if (!cache) return true;
+
+    for (uint32_t i = 0; i < caches.count; ++i) {
+        if (caches.data[i] == cache) {
+            caches.data[i] = caches.data[--caches.count];
+            break;
+        }
+    }
+
+    if (cache->image.data) {
+        free(cache->image.data);
+        mpoolCount(SW_MEM_IMAGE, -(int64_t)(sizeof(uint32_t) * cache->image.w * cache->image.h));
+    }
+    delete(cache);
+
+    return true;
+}
+
+
 bool SwRenderer::dispose(RenderData data)
 {
     auto task = static_cast<SwTask*>(data);
     if (!task) return true;
 
     task->done();
+
+    //Not in the list of this frame anymore
+    for (uint32_t i = 0; i < tasks.count;) {
+        if (tasks.data[i] == task) tasks.data[i] = tasks.data[--tasks.count];
+        else ++i;
+    }
+
     task->dispose();
-    if (task->transform) free(task->transform);
     delete(task);
 
     return true;
@@ -484,14 +1040,14 @@ void* SwRenderer::prepareCommon(SwTask* task, const RenderTransform* transform,
     }
 
     if (transform) {
-        if (!task->transform) task->transform = static_cast<Matrix*>(malloc(sizeof(Matrix)));
-        *task->transform = transform->m;
+        task->m = transform->m;
+        task->transform = &task->m;
     } else {
-        if (task->transform) free(task->transform);
         task->transform = nullptr;
     }
 
     task->opacity = opacity;
+    task->precision = _precision(level);
     task->surface = surface;
     task->flags = flags;
 
@@ -515,7 +1071,7 @@ RenderData SwRenderer::prepare(const Picture& pdata, RenderData data, const Rend
 }
 
 
-RenderData SwRenderer::prepare(const Shape& sdata, RenderData data, const RenderTransform* transform, uint32_t opacity, Array<RenderData>& clips, RenderUpdateFlag flags)
+RenderData SwRenderer::prepare(const Shape& sdata, const PathCmd* cmds, uint32_t cmdCnt, RenderData data, const RenderTransform* transform, uint32_t opacity, Array<RenderData>& clips, RenderUpdateFlag flags)
 {
     //prepare task
     auto task = static_cast<SwShapeTask*>(data);
@@ -524,6 +1080,12 @@ RenderData SwRenderer::prepare(const Shape& sdata, RenderData data, const Render
         if (!task) return nullptr;
         task->sdata = &sdata;
     }
+    //The previous run might still read the path
+    if (flags != RenderUpdateFlag::None) {
+        task->done();
+        task->cmds = cmds;
+        task->cmdCnt = cmdCnt;
+    }
     return prepareCommon(task, transform, opacity, clips, flags);
 }
 
@@ -555,5 +1117,65 @@ bool SwRenderer::term()
 SwRenderer* SwRenderer::gen()
 {
     ++rendererCnt;
-    return new SwRenderer();
+    auto renderer = new SwRenderer();
+    lock_guard<mutex> lock(renderersMtx);
+    renderers.push(renderer);
+    return renderer;
+}
+
+
+bool SwRenderer::usage(MemoryUsage* mem)
+{
+    if (!initEngine || !mem) return false;
+
+    mem->pool = mpoolUsage(SW_MEM_POOL);
+    mem->rle = mpoolUsage(SW_MEM_RLE);
+    mem->ctable = mpoolUsage(SW_MEM_CTABLE);
+    mem->image = mpoolUsage(SW_MEM_IMAGE);
+    mem->block = PoolStatus::usage().load(std::memory_order_relaxed);
+
+    return true;
+}
+
+
+bool SwRenderer::budget(size_t bytes)
+{
+    if (!initEngine) return false;
+
+    memBudget = bytes;
+
+    return true;
+}
+
+
+bool SwRenderer::trim(uint32_t level)
+{
+    if (!initEngine) return false;
+
+    //The threads release their pools on their next task.
+    mpoolTrim();
+    PoolStatus::trim();
+
+    if (level == 0) return true;
+
+    //The renderers might be drawing on the other threads, they drop their caches on the next frame.
+    lock_guard<mutex> lock(renderersMtx);
+    for (auto renderer = renderers.data; renderer < (renderers.data + renderers.count); ++renderer) {
+        (*renderer)->dropCache = true;
+    }
+
+    return true;
+}
+
+
+//Drop the layer images, the scenes will redraw them on demand.
+void SwRenderer::dropCaches()
+{
+    for (auto cache = caches.data; cache < (caches.data + caches.count); ++cache) {
+        if (!(*cache)->image.data) continue;
+        free((*cache)->image.data);
+        mpoolCount(SW_MEM_IMAGE, -(int64_t)(sizeof(uint32_t) * (*cache)->image.w * (*cache)->image.h));
+        (*cache)->image.data = nullptr;
+        (*cache)->image.w = (*cache)->image.h = 0;
+    }
 }
@@ -22,11 +22,15 @@
 #ifndef _TVG_SW_RENDERER_H_
 #define _TVG_SW_RENDERER_H_
 
+#include <atomic>
 #include "tvgRender.h"
 
 struct SwSurface;
 struct SwTask;
 struct SwCompositor;
+struct SwShape;
+struct SwBBox;
+struct SwCache;
 
 namespace tvg
 {
@@ -34,7 +38,7 @@ namespace tvg
 class SwRenderer : public RenderMethod
 {
 public:
-    RenderData prepare(const Shape& shape, RenderData data, const RenderTransform* transform, uint32_t opacity, Array<RenderData>& clips, RenderUpdateFlag flags) override;
+    RenderData prepare(const Shape& shape, const PathCmd* cmds, uint32_t cmdCnt, RenderData data, const RenderTransform* transform, uint32_t opacity, Array<RenderData>& clips, RenderUpdateFlag flags) override;
     RenderData prepare(const Picture& picture, RenderData data, const RenderTransform* transform, uint32_t opacity, Array<RenderData>& clips, RenderUpdateFlag flags) override;
     bool preRender() override;
     bool renderShape(RenderData data) override;
@@ -42,28 +46,46 @@ public:
     bool postRender() override;
     bool dispose(RenderData data) override;
     bool region(RenderData data, uint32_t* x, uint32_t* y, uint32_t* w, uint32_t* h) override;
+    bool hit(RenderData data, uint32_t x, uint32_t y, uint32_t w, uint32_t h, uint8_t threshold) override;
+    bool viewport(uint32_t* x, uint32_t* y, uint32_t* w, uint32_t* h) override;
 
     bool clear() override;
     bool sync() override;
+    bool quality(Quality q) override;
     bool target(uint32_t* buffer, uint32_t stride, uint32_t w, uint32_t h, uint32_t cs);
 
     Compositor* target(uint32_t x, uint32_t y, uint32_t w, uint32_t h) override;
     bool beginComposite(Compositor* cmp, CompositeMethod method, uint32_t opacity) override;
     bool endComposite(Compositor* cmp) override;
 
+    RenderData beginCache(RenderData data, uint32_t x, uint32_t y, uint32_t w, uint32_t h) override;
+    bool endCache(RenderData data) override;
+    bool renderCache(RenderData data, int32_t dx, int32_t dy, uint32_t opacity) override;
+    bool reusable(RenderData data, int32_t dx, int32_t dy) override;
+    bool disposeCache(RenderData data) override;
+
     static SwRenderer* gen();
     static bool init(uint32_t threads);
     static bool term();
+    static bool usage(MemoryUsage* mem);
+    static bool budget(size_t bytes);
+    static bool trim(uint32_t level);
 
 private:
     SwSurface*           surface = nullptr;           //active surface
+    SwSurface*           mainSurface = nullptr;       //canvas target
     Array<SwTask*>       tasks;                       //async task list
     Array<SwSurface*>    compositors;                 //render targets cache list
+    Array<SwCache*>      caches;                      //layer caches
+    Quality              level = Quality::Normal;     //curve flattening quality
+    atomic<bool>         dropCache{false};            //trim request, applied on the next preRender()
 
     SwRenderer(){};
     ~SwRenderer();
 
     RenderData prepareCommon(SwTask* task, const RenderTransform* transform, uint32_t opacity, Array<RenderData>& clips, RenderUpdateFlag flags);
+    bool rasterShape(const Shape* sdata, SwShape* shape, uint32_t opacity, bool cmpStroking, const SwBBox& bbox);
+    void dropCaches();
 };
 
 }
@@ -22,6 +22,8 @@
 #include <setjmp.h>
 #include <limits.h>
 #include <memory.h>
+#include <float.h>
+#include <math.h>
 
 #include "tvgSwCommon.h"
 
@@ -89,6 +91,8 @@ struct RleWorker
 
     SwSize clip;
 
+    SwCoord tolerance;      //max deviation of the flattened curves
+
     bool invalid;
     bool antiAlias;
 };
@@ -143,6 +147,7 @@ static void _genSpan(SwRleData* rle, SwSpan* spans, uint32_t count)
     /* alloc is required to prevent free and reallocation */
     /* when the rle needs to be regenerated because of attribute change. */
     if (rle->alloc < newSize) {
+        mpoolCount(SW_MEM_RLE, (int64_t)(newSize * 2 - rle->alloc) * sizeof(SwSpan));
         rle->alloc = (newSize * 2);
         rle->spans = static_cast<SwSpan*>(realloc(rle->spans, rle->alloc * sizeof(SwSpan)));
     }
@@ -512,7 +517,7 @@ static void _cubicTo(RleWorker& rw, const SwPoint& ctrl1, const SwPoint& ctrl2,
             if (L > SHRT_MAX) goto split;
 
             //max deviation may be as much as (s/L) * 3/4 (if Hain's v = 1)
-            auto sLimit = L * (ONE_PIXEL / 6);
+            auto sLimit = L * rw.tolerance;
 
             auto diff1 = arc[1] - arc[0];
             auto s = diff.y * diff1.x - diff.x * diff1.y;
@@ -529,8 +534,10 @@ static void _cubicTo(RleWorker& rw, const SwPoint& ctrl1, const SwPoint& ctrl2,
             from the chord that the angles P0-P1-P3 or P0-P2-P3 become
             acute as detected by appropriate dot products */
             if (diff1.x * (diff1.x - diff.x) + diff1.y * (diff1.y - diff.y) > 0 ||
-                diff2.x * (diff2.x - diff.x) + diff2.y * (diff2.y - diff.y) > 0)
-                goto split;
+                diff2.x * (diff2.x - diff.x) + diff2.y * (diff2.y - diff.y) > 0) {
+                //Unless the whole segment is within the tolerance on the device
+                if (HYPOT(diff1) > rw.tolerance || HYPOT(diff2) > rw.tolerance || L > rw.tolerance) goto split;
+            }
 
             //no reason to split
             goto draw;
@@ -772,11 +779,187 @@ SwSpan* _intersectSpansRect(const SwBBox *bbox, const SwRleData *targetRle, SwSp
     return out;
 }
 
+struct HairPixel
+{
+    uint32_t key;           //y << 16 | x
+    uint32_t coverage;
+};
+
+
+struct HairWorker
+{
+    HairPixel* pixels;      //null: estimates the number of pixels only
+    uint32_t cnt;
+    float width;
+    float tolerance;        //flattening tolerance in pixels
+    SwSize clip;
+};
+
+
+static void _hairPixel(HairWorker& hw, int32_t x, int32_t y, float coverage)
+{
+    if (x < 0 || y < 0 || x >= hw.clip.w || y >= hw.clip.h) return;
+
+    auto c = static_cast<uint32_t>(coverage * 255.0f + 0.5f);
+    if (c == 0) return;
+    if (c > 255) c = 255;
+
+    hw.pixels[hw.cnt++] = {(static_cast<uint32_t>(y) << 16) | static_cast<uint32_t>(x), c};
+}
+
+
+/* Coverage of the line band of the width, sampled at the pixel centers
+   along the major axis. Only the contour ends are cut off, the joints
+   are covered fully by both of the lines. */
+static void _hairLine(HairWorker& hw, float x0, float y0, float x1, float y1, bool cap0, bool cap1)
+{
+    auto steep = fabsf(y1 - y0) > fabsf(x1 - x0);
+    if (steep) {
+        swap(x0, y0);
+        swap(x1, y1);
+    }
+    if (x0 > x1) {
+        swap(x0, x1);
+        swap(y0, y1);
+        swap(cap0, cap1);
+    }
+
+    auto dx = x1 - x0;
+    auto slope = (dx > FLT_EPSILON) ? (y1 - y0) / dx : 0.0f;
+    auto half = 0.5f * hw.width * sqrtf(1.0f + slope * slope);
+
+    //Visible columns only
+    auto last = static_cast<float>(steep ? hw.clip.h : hw.clip.w);
+    if (x1 < 0.0f || x0 >= last) return;
+    auto begin = static_cast<int32_t>(floorf(x0 > 0.0f ? x0 : 0.0f));
+    auto end = static_cast<int32_t>(floorf(x1 < last ? x1 : last - 1.0f));
+
+    if (!hw.pixels) {
+        hw.cnt += (end - begin + 1) * (static_cast<int32_t>(2.0f * half) + 2);
+        return;
+    }
+
+    for (auto i = begin; i <= end; ++i) {
+        auto cover = 1.0f;
+        if (cap0 && i == static_cast<int32_t>(floorf(x0))) cover -= (x0 - i);
+        if (cap1 && i == static_cast<int32_t>(floorf(x1))) cover -= (i + 1 - x1);
+        if (cover <= 0.0f) continue;
+
+        auto c = i + 0.5f;
+        if (c < x0) c = x0;
+        if (c > x1) c = x1;
+
+        auto yc = y0 + (c - x0) * slope;
+        auto top = yc - half;
+        auto bottom = yc + half;
+        if (bottom < 0.0f || top >= (steep ? hw.clip.w : hw.clip.h)) continue;
+
+        for (auto r = static_cast<int32_t>(floorf(top)); r <= static_cast<int32_t>(floorf(bottom)); ++r) {
+            auto overlap = (bottom < r + 1 ? bottom : r + 1) - (top > r ? top : r);
+            if (overlap <= 0.0f) continue;
+            if (steep) _hairPixel(hw, r, i, overlap * cover);
+            else _hairPixel(hw, i, r, overlap * cover);
+        }
+    }
+}
+
+
+static void _hairCubic(HairWorker& hw, const SwPoint& from, const SwPoint& ctrl1, const SwPoint& ctrl2, const SwPoint& to, bool cap0, bool cap1)
+{
+    float x[4] = {from.x / 64.0f, ctrl1.x / 64.0f, ctrl2.x / 64.0f, to.x / 64.0f};
+    float y[4] = {from.y / 64.0f, ctrl1.y / 64.0f, ctrl2.y / 64.0f, to.y / 64.0f};
+
+    //Wang's formula: segments to keep the flattening error under the tolerance
+    auto dd1 = hypotf(x[0] - 2 * x[1] + x[2], y[0] - 2 * y[1] + y[2]);
+    auto dd2 = hypotf(x[1] - 2 * x[2] + x[3], y[1] - 2 * y[2] + y[3]);
+    auto n = static_cast<int32_t>(ceilf(sqrtf(0.75f * (dd1 > dd2 ? dd1 : dd2) / hw.tolerance)));
+    if (n < 1) n = 1;
+    else if (n > 256) n = 256;
+
+    auto px = x[0];
+    auto py = y[0];
+
+    for (auto i = 1; i <= n; ++i) {
+        auto t = static_cast<float>(i) / n;
+        auto mt = 1.0f - t;
+        auto a = mt * mt * mt;
+        auto b = 3.0f * mt * mt * t;
+        auto c = 3.0f * mt * t * t;
+        auto d = t * t * t;
+        auto nx = a * x[0] + b * x[1] + c * x[2] + d * x[3];
+        auto ny = a * y[0] + b * y[1] + c * y[2] + d * y[3];
+        _hairLine(hw, px, py, nx, ny, cap0 && i == 1, cap1 && i == n);
+        px = nx;
+        py = ny;
+    }
+}
+
+
+static void _hairSegment(HairWorker& hw, const SwPoint& from, const SwPoint& to, bool cap0, bool cap1)
+{
+    _hairLine(hw, from.x / 64.0f, from.y / 64.0f, to.x / 64.0f, to.y / 64.0f, cap0, cap1);
+}
+
+
+//Walks the contours as the stroker does
+static void _hairOutline(HairWorker& hw, const SwOutline& outline)
+{
+    uint32_t first = 0;
+
+    for (uint32_t i = 0; i < outline.cntrsCnt; ++i) {
+        auto last = outline.cntrs[i];
+        if (last <= first) {
+            first = last + 1;
+            continue;
+        }
+
+        auto start = outline.pts[first];
+        auto pt = outline.pts + first;
+        auto limit = outline.pts + last;
+        auto types = outline.types + first;
+        auto closed = false;
+
+        if (types[0] == SW_CURVE_TYPE_CUBIC) return;
+
+        while (pt < limit) {
+            auto cap0 = outline.opened && (pt == outline.pts + first);
+            if (types[1] == SW_CURVE_TYPE_POINT) {
+                _hairSegment(hw, pt[0], pt[1], cap0, outline.opened && (pt + 1 == limit));
+                ++pt;
+                ++types;
+            } else {
+                if (pt + 2 > limit || types[2] != SW_CURVE_TYPE_CUBIC) return;
+                if (pt + 3 > limit) {
+                    _hairCubic(hw, pt[0], pt[1], pt[2], start, cap0, false);
+                    closed = true;
+                    break;
+                }
+                _hairCubic(hw, pt[0], pt[1], pt[2], pt[3], cap0, outline.opened && (pt + 3 == limit));
+                pt += 3;
+                types += 3;
+            }
+        }
+
+        if (!outline.opened && !closed) _hairSegment(hw, *limit, start, false, false);
+
+        first = last + 1;
+    }
+}
+
+
+static int _comparePixel(const void* a, const void* b)
+{
+    auto ka = static_cast<const HairPixel*>(a)->key;
+    auto kb = static_cast<const HairPixel*>(b)->key;
+    return (ka > kb) - (ka < kb);
+}
+
+
 /************************************************************************/
 /* External Class Implementation                                        */
 /************************************************************************/
 
-SwRleData* rleRender(SwRleData* rle, const SwOutline* outline, const SwBBox& bbox, const SwSize& clip, bool antiAlias)
+SwRleData* rleRender(SwRleData* rle, const SwOutline* outline, const SwBBox& bbox, const SwSize& clip, bool antiAlias, uint32_t precision)
 {
     constexpr auto RENDER_POOL_SIZE = 16384L;
     constexpr auto BAND_SIZE = 40;
@@ -805,6 +988,7 @@ SwRleData* rleRender(SwRleData* rle, const SwOutline* outline, const SwBBox& bbo
     rw.bandShoot = 0;
     rw.clip = clip;
     rw.antiAlias = antiAlias;
+    rw.tolerance = ONE_PIXEL / precision;
 
     if (!rle) rw.rle = reinterpret_cast<SwRleData*>(calloc(1, sizeof(SwRleData)));
     else rw.rle = rle;
@@ -901,6 +1085,68 @@ error:
 }
 
 
+SwRleData* rleHairline(SwRleData* rle, const SwOutline* outline, float width, const SwSize& clip, uint32_t precision, unsigned tid)
+{
+    HairWorker hw;
+    hw.pixels = nullptr;
+    hw.cnt = 0;
+    hw.width = width;
+    hw.tolerance = 1.0f / precision;
+    hw.clip = clip;
+
+    //Estimate the pixels to reserve
+    _hairOutline(hw, *outline);
+    auto reserved = hw.cnt;
+
+    if (!rle) rle = reinterpret_cast<SwRleData*>(calloc(1, sizeof(SwRleData)));
+    rle->size = 0;
+    if (reserved == 0) return rle;
+
+    hw.pixels = static_cast<HairPixel*>(mpoolReqScratch(tid, reserved * sizeof(HairPixel)));
+    if (!hw.pixels) return rle;
+    hw.cnt = 0;
+    _hairOutline(hw, *outline);
+
+    qsort(hw.pixels, hw.cnt, sizeof(HairPixel), _comparePixel);
+
+    if (rle->alloc < hw.cnt) {
+        auto spans = static_cast<SwSpan*>(realloc(rle->spans, hw.cnt * sizeof(SwSpan)));
+        if (!spans) {
+            mpoolRetScratch(tid, hw.pixels);
+            return rle;
+        }
+        mpoolCount(SW_MEM_RLE, (int64_t)(hw.cnt - rle->alloc) * sizeof(SwSpan));
+        rle->spans = spans;
+        rle->alloc = hw.cnt;
+    }
+
+    //Overlapped pixels take the max coverage, the same coverages in a row are merged.
+    SwSpan* span = nullptr;
+    for (auto p = hw.pixels; p < hw.pixels + hw.cnt; ++p) {
+        auto coverage = p->coverage;
+        while (p + 1 < hw.pixels + hw.cnt && p[1].key == p->key) {
+            ++p;
+            if (p->coverage > coverage) coverage = p->coverage;
+        }
+        auto x = static_cast<int16_t>(p->key & 0xffff);
+        auto y = static_cast<int16_t>(p->key >> 16);
+        if (span && span->y == y && span->x + span->len == x && span->coverage == coverage) {
+            ++span->len;
+            continue;
+        }
+        span = rle->spans + rle->size++;
+        span->x = x;
+        span->y = y;
+        span->len = 1;
+        span->coverage = coverage;
+    }
+
+    mpoolRetScratch(tid, hw.pixels);
+
+    return rle;
+}
+
+
 void rleReset(SwRleData* rle)
 {
     if (!rle) return;
@@ -911,56 +1157,59 @@ void rleReset(SwRleData* rle)
 void rleFree(SwRleData* rle)
 {
     if (!rle) return;
-    if (rle->spans) free(rle->spans);
+    if (rle->spans) {
+        free(rle->spans);
+        mpoolCount(SW_MEM_RLE, -(int64_t)(rle->alloc * sizeof(SwSpan)));
+    }
     free(rle);
 }
 
-void updateRleSpans(SwRleData *rle, SwSpan* curSpans, uint32_t size)
+static void _replaceSpans(SwRleData *rle, const SwSpan* curSpans, uint32_t size)
 {
     if (!rle->spans || !curSpans || size == 0) return;
-    rle->size = size;
-    rle->spans = static_cast<SwSpan*>(realloc(rle->spans, rle->size * sizeof(SwSpan)));
-
-    if (!rle->spans) return;
 
-    for (int i = 0; i < (int)rle->size ; i++)
-    {
-       rle->spans[i].x = curSpans[i].x;
-       rle->spans[i].y = curSpans[i].y;
-       rle->spans[i].len = curSpans[i].len;
-       rle->spans[i].coverage = curSpans[i].coverage;
+    //Keep the buffer, it's reused when the rle is regenerated.
+    if (rle->alloc < size) {
+        auto spans = static_cast<SwSpan*>(realloc(rle->spans, size * sizeof(SwSpan)));
+        if (!spans) return;
+        mpoolCount(SW_MEM_RLE, (int64_t)(size - rle->alloc) * sizeof(SwSpan));
+        rle->spans = spans;
+        rle->alloc = size;
     }
+    memcpy(rle->spans, curSpans, size * sizeof(SwSpan));
+    rle->size = size;
 }
 
-void rleClipPath(SwRleData *rle, const SwRleData *clip)
+
+void rleClipPath(SwRleData *rle, const SwRleData *clip, unsigned tid)
 {
     if (rle->size == 0 || clip->size == 0) return;
     auto spanCnt = rle->size > clip->size ? rle->size : clip->size;
-    auto spans = static_cast<SwSpan*>(malloc(sizeof(SwSpan) * (spanCnt)));
+    auto spans = static_cast<SwSpan*>(mpoolReqScratch(tid, sizeof(SwSpan) * (spanCnt)));
     if (!spans) return;
     auto spansEnd = _intersectSpansRegion(clip, rle, spans, spanCnt);
 
     //Update Spans
-    updateRleSpans(rle, spans, spansEnd - spans);
+    _replaceSpans(rle, spans, spansEnd - spans);
 
-    if (spans) free(spans);
+    mpoolRetScratch(tid, spans);
 
 #ifdef THORVG_LOG_ENABLED
     printf("SW_ENGINE: Using ClipPath!\n");
 #endif
 }
 
-void rleClipRect(SwRleData *rle, const SwBBox* clip)
+void rleClipRect(SwRleData *rle, const SwBBox* clip, unsigned tid)
 {
     if (rle->size == 0) return;
-    auto spans = static_cast<SwSpan*>(malloc(sizeof(SwSpan) * (rle->size)));
+    auto spans = static_cast<SwSpan*>(mpoolReqScratch(tid, sizeof(SwSpan) * (rle->size)));
     if (!spans) return;
     auto spansEnd = _intersectSpansRect(clip, rle, spans, rle->size);
 
     //Update Spans
-    updateRleSpans(rle, spans, spansEnd - spans);
+    _replaceSpans(rle, spans, spansEnd - spans);
 
-    if (spans) free(spans);
+    mpoolRetScratch(tid, spans);
 
 #ifdef THORVG_LOG_ENABLED
     printf("SW_ENGINE: Using ClipRect!\n");
@@ -968,19 +1217,89 @@ void rleClipRect(SwRleData *rle, const SwBBox* clip)
 }
 
 
-void rleAlphaMask(SwRleData *rle, const SwRleData *clip)
+void rleAlphaMask(SwRleData *rle, const SwRleData *clip, unsigned tid)
 {
     if (rle->size == 0 || clip->size == 0) return;
     auto spanCnt = rle->size + clip->size;
 
-    auto spans = static_cast<SwSpan*>(malloc(sizeof(SwSpan) * (spanCnt)));
+    auto spans = static_cast<SwSpan*>(mpoolReqScratch(tid, sizeof(SwSpan) * (spanCnt)));
 
     if (!spans) return;
     auto spansEnd = _intersectMaskRegion(clip, rle, spans, spanCnt);
 
     //Update Spans
-    updateRleSpans(rle, spans, spansEnd - spans);
+    _replaceSpans(rle, spans, spansEnd - spans);
+
+    mpoolRetScratch(tid, spans);
+}
+
+
+bool rleHit(const SwRleData* rle, const SwBBox& region, uint8_t threshold)
+{
+    if (!rle || rle->size == 0) return false;
+
+    //Spans are sorted by y. Find the first span of the region.
+    auto span = rle->spans;
+    auto cnt = rle->size;
+    while (cnt > 0) {
+        auto half = cnt / 2;
+        if (span[half].y < region.min.y) {
+            span += (half + 1);
+            cnt -= (half + 1);
+        } else {
+            cnt = half;
+        }
+    }
+
+    auto end = rle->spans + rle->size;
 
-    if (spans) free(spans);
+    for (; span < end && span->y < region.max.y; ++span) {
+        if (span->coverage <= threshold) continue;
+        if (span->x + span->len <= region.min.x || span->x >= region.max.x) continue;
+        return true;
+    }
+    return false;
 }
 
+
+bool rleTranslate(const SwRleData* rle, SwRleData* out, SwCoord x, SwCoord y, const SwSize& clip)
+{
+    out->size = 0;
+
+    if (!rle || rle->size == 0) return false;
+
+    if (out->alloc < rle->size) {
+        mpoolCount(SW_MEM_RLE, (int64_t)(rle->size - out->alloc) * sizeof(SwSpan));
+        out->alloc = rle->size;
+        out->spans = static_cast<SwSpan*>(realloc(out->spans, sizeof(SwSpan) * out->alloc));
+        if (!out->spans) {
+            mpoolCount(SW_MEM_RLE, -(int64_t)(out->alloc * sizeof(SwSpan)));
+            out->alloc = 0;
+            return false;
+        }
+    }
+
+    auto dst = out->spans;
+    auto span = rle->spans;
+
+    for (uint32_t i = 0; i < rle->size; ++i, ++span) {
+        auto sy = span->y + y;
+        if (sy < 0) continue;
+        //Spans are sorted by y
+        if (sy >= clip.h) break;
+        auto x1 = span->x + x;
+        auto x2 = x1 + span->len;
+        if (x1 < 0) x1 = 0;
+        if (x2 > clip.w) x2 = clip.w;
+        if (x1 >= x2) continue;
+        dst->x = static_cast<int16_t>(x1);
+        dst->y = static_cast<int16_t>(sy);
+        dst->len = static_cast<uint16_t>(x2 - x1);
+        dst->coverage = span->coverage;
+        ++dst;
+    }
+
+    out->size = dst - out->spans;
+
+    return (out->size > 0);
+}
@@ -302,11 +302,8 @@ static void _dashCubicTo(SwDashStroke& dash, const Point* ctrl1, const Point* ct
 }
 
 
-SwOutline* _genDashOutline(const Shape* sdata, const Matrix* transform)
+SwOutline* _genDashOutline(const Shape* sdata, const PathCmd* cmds, uint32_t cmdCnt, unsigned tid, const Matrix* transform)
 {
-    const PathCommand* cmds = nullptr;
-    auto cmdCnt = sdata->pathCommands(&cmds);
-
     const Point* pts = nullptr;
     auto ptsCnt = sdata->pathCoords(&pts);
 
@@ -324,9 +321,8 @@ SwOutline* _genDashOutline(const Shape* sdata, const Matrix* transform)
     dash.cnt = sdata->strokeDash(&pattern);
     if (dash.cnt == 0) return nullptr;
 
-    //OPTMIZE ME: Use mempool???
     dash.pattern = const_cast<float*>(pattern);
-    dash.outline = static_cast<SwOutline*>(calloc(1, sizeof(SwOutline)));
+    dash.outline = mpoolReqDashOutline(tid);
     dash.outline->opened = true;
 
     //smart reservation
@@ -335,20 +331,20 @@ SwOutline* _genDashOutline(const Shape* sdata, const Matrix* transform)
 
     for (uint32_t i = 0; i < cmdCnt; ++i) {
         switch(*(cmds + i)) {
-            case PathCommand::Close: {
+            case PathCmd::Close: {
                 ++outlinePtsCnt;
                 break;
             }
-            case PathCommand::MoveTo: {
+            case PathCmd::MoveTo: {
                 ++outlineCntrsCnt;
                 ++outlinePtsCnt;
                 break;
             }
-            case PathCommand::LineTo: {
+            case PathCmd::LineTo: {
                 ++outlinePtsCnt;
                 break;
             }
-            case PathCommand::CubicTo: {
+            case PathCmd::CubicTo: {
                 outlinePtsCnt += 3;
                 break;
             }
@@ -364,11 +360,11 @@ SwOutline* _genDashOutline(const Shape* sdata, const Matrix* transform)
 
     while (cmdCnt-- > 0) {
         switch(*cmds) {
-            case PathCommand::Close: {
+            case PathCmd::Close: {
                 _dashLineTo(dash, &dash.ptStart, transform);
                 break;
             }
-            case PathCommand::MoveTo: {
+            case PathCmd::MoveTo: {
                 //reset the dash
                 dash.curIdx = 0;
                 dash.curLen = *dash.pattern;
@@ -377,12 +373,12 @@ SwOutline* _genDashOutline(const Shape* sdata, const Matrix* transform)
                 ++pts;
                 break;
             }
-            case PathCommand::LineTo: {
+            case PathCmd::LineTo: {
                 _dashLineTo(dash, pts, transform);
                 ++pts;
                 break;
             }
-            case PathCommand::CubicTo: {
+            case PathCmd::CubicTo: {
                 _dashCubicTo(dash, pts, pts + 1, pts + 2, transform);
                 pts += 3;
                 break;
@@ -420,9 +416,9 @@ bool _fastTrack(const SwOutline* outline)
 /* External Class Implementation                                        */
 /************************************************************************/
 
-bool shapePrepare(SwShape* shape, const Shape* sdata, unsigned tid, const SwSize& clip, const Matrix* transform, SwBBox& bbox)
+bool shapePrepare(SwShape* shape, const Shape* sdata, const PathCmd* cmds, uint32_t cmdCnt, unsigned tid, const SwSize& clip, const Matrix* transform, SwBBox& bbox)
 {
-    if (!shapeGenOutline(shape, sdata, tid, transform)) return false;
+    if (!shapeGenOutline(shape, sdata, cmds, cmdCnt, tid, transform)) return false;
 
     if (!_updateBBox(shape->outline, shape->bbox)) return false;
 
@@ -440,7 +436,7 @@ bool shapePrepared(SwShape* shape)
 }
 
 
-bool shapeGenRle(SwShape* shape, TVG_UNUSED const Shape* sdata, const SwSize& clip, bool antiAlias, bool hasComposite)
+bool shapeGenRle(SwShape* shape, TVG_UNUSED const Shape* sdata, const SwSize& clip, bool antiAlias, bool hasComposite, uint32_t precision)
 {
     //FIXME: Should we draw it?
     //Case: Stroke Line
@@ -449,7 +445,7 @@ bool shapeGenRle(SwShape* shape, TVG_UNUSED const Shape* sdata, const SwSize& cl
     //Case A: Fast Track Rectangle Drawing
     if (!hasComposite && (shape->rect = _fastTrack(shape->outline))) return true;
     //Case B: Normale Shape RLE Drawing
-    if ((shape->rle = rleRender(shape->rle, shape->outline, shape->bbox, clip, antiAlias))) return true;
+    if ((shape->rle = rleRender(shape->rle, shape->outline, shape->bbox, clip, antiAlias, precision))) return true;
 
     return false;
 }
@@ -471,11 +467,8 @@ void shapeReset(SwShape* shape)
 }
 
 
-bool shapeGenOutline(SwShape* shape, const Shape* sdata, unsigned tid, const Matrix* transform)
+bool shapeGenOutline(SwShape* shape, const Shape* sdata, const PathCmd* cmds, uint32_t cmdCnt, unsigned tid, const Matrix* transform)
 {
-    const PathCommand* cmds = nullptr;
-    auto cmdCnt = sdata->pathCommands(&cmds);
-
     const Point* pts = nullptr;
     auto ptsCnt = sdata->pathCoords(&pts);
 
@@ -488,20 +481,20 @@ bool shapeGenOutline(SwShape* shape, const Shape* sdata, unsigned tid, const Mat
 
     for (uint32_t i = 0; i < cmdCnt; ++i) {
         switch(*(cmds + i)) {
-            case PathCommand::Close: {
+            case PathCmd::Close: {
                 ++outlinePtsCnt;
                 break;
             }
-            case PathCommand::MoveTo: {
+            case PathCmd::MoveTo: {
                 ++outlineCntrsCnt;
                 ++outlinePtsCnt;
                 break;
             }
-            case PathCommand::LineTo: {
+            case PathCmd::LineTo: {
                 ++outlinePtsCnt;
                 break;
             }
-            case PathCommand::CubicTo: {
+            case PathCmd::CubicTo: {
                 outlinePtsCnt += 3;
                 break;
             }
@@ -523,22 +516,22 @@ bool shapeGenOutline(SwShape* shape, const Shape* sdata, unsigned tid, const Mat
     //Generate Outlines
     while (cmdCnt-- > 0) {
         switch(*cmds) {
-            case PathCommand::Close: {
+            case PathCmd::Close: {
                 _outlineClose(*outline);
                 closed = true;
                 break;
             }
-            case PathCommand::MoveTo: {
+            case PathCmd::MoveTo: {
                 _outlineMoveTo(*outline, pts, transform);
                 ++pts;
                 break;
             }
-            case PathCommand::LineTo: {
+            case PathCmd::LineTo: {
                 _outlineLineTo(*outline, pts, transform);
                 ++pts;
                 break;
             }
-            case PathCommand::CubicTo: {
+            case PathCmd::CubicTo: {
                 _outlineCubicTo(*outline, pts, pts + 1, pts + 2, transform);
                 pts += 3;
                 break;
@@ -580,64 +573,78 @@ void shapeDelStroke(SwShape* shape)
 }
 
 
-void shapeResetStroke(SwShape* shape, const Shape* sdata, const Matrix* transform)
+void shapeResetStroke(SwShape* shape, const Shape* sdata, const Matrix* transform, uint32_t precision)
 {
     if (!shape->stroke) shape->stroke = static_cast<SwStroke*>(calloc(1, sizeof(SwStroke)));
     auto stroke = shape->stroke;
     if (!stroke) return;
 
-    strokeReset(stroke, sdata, transform);
+    strokeReset(stroke, sdata, transform, precision);
     rleReset(shape->strokeRle);
 }
 
 
-bool shapeGenStrokeRle(SwShape* shape, const Shape* sdata, unsigned tid, const Matrix* transform, const SwSize& clip, SwBBox& bbox)
+bool shapeGenStrokeRle(SwShape* shape, const Shape* sdata, const PathCmd* cmds, uint32_t cmdCnt, unsigned tid, const Matrix* transform, const SwSize& clip, SwBBox& bbox)
 {
     SwOutline* shapeOutline = nullptr;
     SwOutline* strokeOutline = nullptr;
-    bool freeOutline = false;
+    bool dashed = false;
     bool ret = true;
 
     //Dash Style Stroke
     if (sdata->strokeDash(nullptr) > 0) {
-        shapeOutline = _genDashOutline(sdata, transform);
+        shapeOutline = _genDashOutline(sdata, cmds, cmdCnt, tid, transform);
         if (!shapeOutline) return false;
-        freeOutline = true;
+        dashed = true;
     //Normal Style stroke
     } else {
         if (!shape->outline) {
-            if (!shapeGenOutline(shape, sdata, tid, transform)) return false;
+            if (!shapeGenOutline(shape, sdata, cmds, cmdCnt, tid, transform)) return false;
         }
         shapeOutline = shape->outline;
     }
 
+    //Hairline: coverage of the outline itself, no stroke borders. The caps reach out of the outline, so butt only.
+    //The widest scaled extent decides it, so a stroke stretched in one direction isn't thinned.
+    auto width = sdata->strokeWidth() * (shape->stroke->sx > shape->stroke->sy ? shape->stroke->sx : shape->stroke->sy);
+    if (sdata->strokeCap() == StrokeCap::Butt && width <= SW_HAIRLINE_WIDTH) {
+        _updateBBox(shapeOutline, bbox);
+        --bbox.min.x;
+        --bbox.min.y;
+        ++bbox.max.x;
+        ++bbox.max.y;
+
+        if (!_checkValid(shapeOutline, bbox, clip)) {
+            ret = false;
+            goto end;
+        }
+
+        shape->strokeRle = rleHairline(shape->strokeRle, shapeOutline, width, clip, shape->stroke->precision, tid);
+        goto end;
+    }
+
     if (!strokeParseOutline(shape->stroke, *shapeOutline)) {
         ret = false;
-        goto fail;
+        goto end;
     }
 
     strokeOutline = strokeExportOutline(shape->stroke, tid);
     if (!strokeOutline) {
         ret = false;
-        goto fail;
+        goto end;
     }
 
     _updateBBox(strokeOutline, bbox);
 
     if (!_checkValid(strokeOutline, bbox, clip)) {
         ret = false;
-        goto fail;
+        goto end;
     }
 
-    shape->strokeRle = rleRender(shape->strokeRle, strokeOutline, bbox, clip, true);
+    shape->strokeRle = rleRender(shape->strokeRle, strokeOutline, bbox, clip, true, shape->stroke->precision);
 
-fail:
-    if (freeOutline) {
-        if (shapeOutline->cntrs) free(shapeOutline->cntrs);
-        if (shapeOutline->pts) free(shapeOutline->pts);
-        if (shapeOutline->types) free(shapeOutline->types);
-        free(shapeOutline);
-    }
+end:
+    if (dashed) mpoolRetDashOutline(tid);
     mpoolRetStrokeOutline(tid);
 
     return ret;
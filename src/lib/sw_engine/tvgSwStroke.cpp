@@ -39,6 +39,36 @@ static inline SwFixed SIDE_TO_ROTATE(const int32_t s)
 }
 
 
+/* Max angle of a curve segment to be offset without splitting.
+   Offsetting deviates by about r * angle^2 / 8 where r is the segment size
+   plus the stroke radius on the device, so the segments small on the screen
+   can take wider angles within the tolerance. The lower bound follows the
+   tolerance, PI/8 on Normal quality. */
+static SwFixed _arcAngleLimit(const SwStroke& stroke, const SwPoint* arc)
+{
+    auto min = arc[0];
+    auto max = arc[0];
+    for (auto i = 1; i < 4; ++i) {
+        if (arc[i].x < min.x) min.x = arc[i].x;
+        if (arc[i].y < min.y) min.y = arc[i].y;
+        if (arc[i].x > max.x) max.x = arc[i].x;
+        if (arc[i].y > max.y) max.y = arc[i].y;
+    }
+    auto extent = (max.x - min.x) > (max.y - min.y) ? (max.x - min.x) : (max.y - min.y);
+    auto radius = stroke.width * (stroke.sx > stroke.sy ? stroke.sx : stroke.sy);
+    auto size = static_cast<float>(extent) + radius;
+    auto tolerance = 64.0f / stroke.precision;
+
+    if (size < 1.0f) return SW_ANGLE_PI4;
+    auto limit = static_cast<SwFixed>(sqrtf(8.0f * tolerance / size) * SW_ANGLE_PI / M_PI);
+    if (limit > SW_ANGLE_PI4) return SW_ANGLE_PI4;
+    auto lower = SW_ANGLE_PI / 8 * SW_PRECISION_NORMAL / stroke.precision;
+    if (lower > SW_ANGLE_PI4) lower = SW_ANGLE_PI4;
+    if (limit < lower) return lower;
+    return limit;
+}
+
+
 static inline void SCALE(SwStroke& stroke, SwPoint& pt)
 {
     pt.x *= stroke.sx;
@@ -441,13 +471,15 @@ static void _cubicTo(SwStroke& stroke, const SwPoint& ctrl1, const SwPoint& ctrl
     arc[2] = ctrl1;
     arc[3] = stroke.center;
 
+    auto angleLimit = _arcAngleLimit(stroke, arc);
+
     while (arc >= bezStack) {
         SwFixed angleIn, angleOut, angleMid;
 
         //initialize with current direction
         angleIn = angleOut = angleMid = stroke.angleIn;
 
-        if (arc < limit && !mathSmallCubic(arc, angleIn, angleMid, angleOut)) {
+        if (arc < limit && !mathSmallCubic(arc, angleIn, angleMid, angleOut, angleLimit)) {
             if (stroke.firstPt) stroke.angleIn = angleIn;
             mathSplitCubic(arc);
             arc += 3;
@@ -825,7 +857,7 @@ void strokeFree(SwStroke* stroke)
 }
 
 
-void strokeReset(SwStroke* stroke, const Shape* sdata, const Matrix* transform)
+void strokeReset(SwStroke* stroke, const Shape* sdata, const Matrix* transform, uint32_t precision)
 {
     if (transform) {
         stroke->sx = sqrt(pow(transform->e11, 2) + pow(transform->e21, 2));
@@ -836,6 +868,7 @@ void strokeReset(SwStroke* stroke, const Shape* sdata, const Matrix* transform)
 
     stroke->width = HALF_STROKE(sdata->strokeWidth());
     stroke->cap = sdata->strokeCap();
+    stroke->precision = precision;
 
     //Save line join: it can be temporarily changed when stroking curves...
     stroke->joinSaved = stroke->join = sdata->strokeJoin();
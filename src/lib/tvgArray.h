@@ -51,6 +51,28 @@ struct Array
         }
     }
 
+    void insert(uint32_t idx, T element)
+    {
+        if (idx >= count) {
+            push(element);
+            return;
+        }
+        if (count + 1 > reserved) {
+            reserved = (count + 1) * 2;
+            data = static_cast<T*>(realloc(data, sizeof(T) * reserved));
+        }
+        memmove(data + idx + 1, data + idx, sizeof(T) * (count - idx));
+        data[idx] = element;
+        ++count;
+    }
+
+    void erase(uint32_t idx)
+    {
+        if (idx >= count) return;
+        --count;
+        memmove(data + idx, data + idx + 1, sizeof(T) * (count - idx));
+    }
+
     void pop()
     {
         if (count > 0) --count;
@@ -55,6 +55,30 @@ Result Canvas::clear(bool free) noexcept
 }
 
 
+Result Canvas::insert(unique_ptr<Paint> paint, const Paint* at, bool after) noexcept
+{
+    return pImpl->insert(move(paint), at, after);
+}
+
+
+Result Canvas::remove(Paint* paint) noexcept
+{
+    return pImpl->remove(paint);
+}
+
+
+Result Canvas::moveToFront(Paint* paint) noexcept
+{
+    return pImpl->reorder(paint, true);
+}
+
+
+Result Canvas::moveToBack(Paint* paint) noexcept
+{
+    return pImpl->reorder(paint, false);
+}
+
+
 Result Canvas::draw() noexcept
 {
     return pImpl->draw();
@@ -67,6 +91,30 @@ Result Canvas::update(Paint* paint) noexcept
 }
 
 
+uint32_t Canvas::hit(uint32_t x, uint32_t y, Paint** paints, uint32_t n, uint8_t threshold) noexcept
+{
+    return pImpl->hit(x, y, 1, 1, paints, n, threshold);
+}
+
+
+uint32_t Canvas::hit(uint32_t x, uint32_t y, uint32_t w, uint32_t h, Paint** paints, uint32_t n, uint8_t threshold) noexcept
+{
+    return pImpl->hit(x, y, w, h, paints, n, threshold);
+}
+
+
+Result Canvas::quality(Quality q) noexcept
+{
+    return pImpl->quality(q);
+}
+
+
+Quality Canvas::quality() const noexcept
+{
+    return pImpl->level;
+}
+
+
 Result Canvas::sync() noexcept
 {
     if (pImpl->renderer->sync()) return Result::Success;
@@ -31,7 +31,10 @@
 struct Canvas::Impl
 {
     Array<Paint*> paints;
+    Array<Paint::Impl*> pending;    //paints having changes to be updated
+    Array<Paint*> trash;            //removed paints, disposed on the next update
     RenderMethod* renderer;
+    Quality level = Quality::Normal;
 
     Impl(RenderMethod* pRenderer):renderer(pRenderer)
     {
@@ -49,7 +52,10 @@ struct Canvas::Impl
         if (!p) return Result::MemoryCorruption;
         paints.push(p);
 
-        return update(p, true);
+        auto ret = update(p, true);
+        p->pImpl->attach(nullptr, &pending);
+
+        return ret;
     }
 
     Result clear(bool free)
@@ -59,11 +65,16 @@ struct Canvas::Impl
         //Clear render target before drawing
         if (!renderer->clear()) return Result::InsufficientCondition;
 
+        pending.clear();
+        clean();
+
         //free paints
-        if (free) {
-            for (auto paint = paints.data; paint < (paints.data + paints.count); ++paint) {
+        for (auto paint = paints.data; paint < (paints.data + paints.count); ++paint) {
+            if (free) {
                 (*paint)->pImpl->dispose(*renderer);
                 delete(*paint);
+            } else {
+                (*paint)->pImpl->detach();
             }
         }
 
@@ -72,10 +83,72 @@ struct Canvas::Impl
         return Result::Success;
     }
 
+    void clean()
+    {
+        for (auto paint = trash.data; paint < (trash.data + trash.count); ++paint) {
+            (*paint)->pImpl->dispose(*renderer);
+            delete(*paint);
+        }
+        trash.clear();
+    }
+
+    uint32_t find(const Paint* paint)
+    {
+        for (uint32_t i = 0; i < paints.count; ++i) {
+            if (paints.data[i] == paint) return i;
+        }
+        return paints.count;
+    }
+
+    Result insert(unique_ptr<Paint> paint, const Paint* at, bool after)
+    {
+        auto idx = find(at);
+        if (idx == paints.count) return Result::InvalidArguments;
+
+        auto p = paint.release();
+        if (!p) return Result::MemoryCorruption;
+        paints.insert(after ? idx + 1 : idx, p);
+
+        auto ret = update(p, true);
+        p->pImpl->attach(nullptr, &pending);
+
+        return ret;
+    }
+
+    Result remove(Paint* paint)
+    {
+        if (!renderer) return Result::InsufficientCondition;
+
+        auto idx = find(paint);
+        if (idx == paints.count) return Result::InvalidArguments;
+        paints.erase(idx);
+
+        //The engine might be still working on it, release it on the next update like the scenes do.
+        paint->pImpl->detach();
+        trash.push(paint);
+
+        return Result::Success;
+    }
+
+    //Only the drawing order is changed, engine data is kept.
+    Result reorder(Paint* paint, bool front)
+    {
+        auto idx = find(paint);
+        if (idx == paints.count) return Result::InvalidArguments;
+        paints.erase(idx);
+
+        if (front) paints.push(paint);
+        else paints.insert(0, paint);
+
+        return Result::Success;
+    }
+
     Result update(Paint* paint, bool force)
     {
         if (!renderer) return Result::InsufficientCondition;
 
+        if (trash.count > 0) clean();
+
         Array<RenderData> clips;
 	auto flag = force ? RenderUpdateFlag::All : RenderUpdateFlag::None;
 
@@ -83,14 +156,52 @@ struct Canvas::Impl
         if (paint) {
             paint->pImpl->update(*renderer, nullptr, 255, clips, flag);
         //Update all retained paint nodes
-        } else {
+        } else if (force) {
             for (auto paint = paints.data; paint < (paints.data + paints.count); ++paint) {
                 (*paint)->pImpl->update(*renderer, nullptr, 255, clips, flag);
             }
+            pending.clear();
+        //Update the changed paint nodes only
+        } else {
+            for (uint32_t i = 0; i < pending.count; ++i) {
+                if (pending.data[i]) pending.data[i]->update(*renderer, nullptr, 255, clips, flag);
+            }
+            pending.clear();
         }
         return Result::Success;
     }
 
+    Result quality(Quality q)
+    {
+        if (!renderer) return Result::InsufficientCondition;
+        if (q == level) return Result::Success;
+        if (!renderer->quality(q)) return Result::NonSupport;
+        level = q;
+
+        //Every geometry is flattened again
+        return update(nullptr, true);
+    }
+
+    uint32_t hit(uint32_t x, uint32_t y, uint32_t w, uint32_t h, Paint** out, uint32_t n, uint8_t threshold)
+    {
+        if (!renderer || w == 0 || h == 0) return 0;
+
+        Array<Paint*> list;
+
+        //Front to back
+        for (auto i = paints.count; i > 0; --i) {
+            paints.data[i - 1]->pImpl->hit(*renderer, x, y, w, h, threshold, list);
+        }
+
+        //Just count the hit paints
+        if (!out) return list.count;
+
+        if (n > list.count) n = list.count;
+        for (uint32_t i = 0; i < n; ++i) out[i] = list.data[i];
+
+        return n;
+    }
+
     Result draw()
     {
         if (!renderer) return Result::InsufficientCondition;
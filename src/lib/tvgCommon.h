@@ -33,4 +33,12 @@ using namespace tvg;
 
 #define TVG_UNUSED __attribute__ ((__unused__))
 
+namespace tvg
+{
+
+//Paths store the commands in 1 byte, PathCommand is converted at the API boundary.
+enum class PathCmd : uint8_t { Close = 0, MoveTo, LineTo, CubicTo };
+
+}
+
 #endif //_TVG_COMMON_H_
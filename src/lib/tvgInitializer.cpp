@@ -102,4 +102,55 @@ Result Initializer::term(CanvasEngine engine) noexcept
     initialized = false;
 
     return Result::Success;
-}
\ No newline at end of file
+}
+
+Result Initializer::usage(CanvasEngine engine, MemoryUsage* usage) noexcept
+{
+    if (!initialized) return Result::InsufficientCondition;
+    if (!usage) return Result::InvalidArguments;
+
+    if (static_cast<uint32_t>(engine) & static_cast<uint32_t>(CanvasEngine::Sw)) {
+        #ifdef THORVG_SW_RASTER_SUPPORT
+            if (!SwRenderer::usage(usage)) return Result::InsufficientCondition;
+            return Result::Success;
+        #endif
+    } else if (!(static_cast<uint32_t>(engine) & static_cast<uint32_t>(CanvasEngine::Gl))) {
+        return Result::InvalidArguments;
+    }
+
+    return Result::NonSupport;
+}
+
+
+Result Initializer::budget(CanvasEngine engine, size_t bytes) noexcept
+{
+    if (!initialized) return Result::InsufficientCondition;
+
+    if (static_cast<uint32_t>(engine) & static_cast<uint32_t>(CanvasEngine::Sw)) {
+        #ifdef THORVG_SW_RASTER_SUPPORT
+            if (!SwRenderer::budget(bytes)) return Result::InsufficientCondition;
+            return Result::Success;
+        #endif
+    } else if (!(static_cast<uint32_t>(engine) & static_cast<uint32_t>(CanvasEngine::Gl))) {
+        return Result::InvalidArguments;
+    }
+
+    return Result::NonSupport;
+}
+
+
+Result Initializer::trim(CanvasEngine engine, uint32_t level) noexcept
+{
+    if (!initialized) return Result::InsufficientCondition;
+
+    if (static_cast<uint32_t>(engine) & static_cast<uint32_t>(CanvasEngine::Sw)) {
+        #ifdef THORVG_SW_RASTER_SUPPORT
+            if (!SwRenderer::trim(level)) return Result::InsufficientCondition;
+            return Result::Success;
+        #endif
+    } else if (!(static_cast<uint32_t>(engine) & static_cast<uint32_t>(CanvasEngine::Gl))) {
+        return Result::InvalidArguments;
+    }
+
+    return Result::NonSupport;
+}
@@ -123,3 +123,16 @@ unique_ptr<Loader> LoaderMgr::loader(uint32_t *data, uint32_t w, uint32_t h, boo
     }
     return nullptr;
 }
+
+
+unique_ptr<Loader> LoaderMgr::stream(const char* data, uint32_t size)
+{
+    for (int i = 0; i < static_cast<int>(FileType::Unknown); i++) {
+        auto loader = _find(static_cast<FileType>(i));
+        if (loader) {
+            if (loader->feed(data, size)) return unique_ptr<Loader>(loader);
+            else delete(loader);
+        }
+    }
+    return nullptr;
+}
@@ -33,6 +33,7 @@ struct LoaderMgr
     static unique_ptr<Loader> loader(const string& path);
     static unique_ptr<Loader> loader(const char* data, uint32_t size);
     static unique_ptr<Loader> loader(uint32_t* data, uint32_t w, uint32_t h, bool copy);
+    static unique_ptr<Loader> stream(const char* data, uint32_t size);
 };
 
 #endif //_TVG_LOADER_MGR_H_
@@ -70,7 +70,14 @@ Result Paint::transform(const Matrix& m) noexcept
 
 Result Paint::bounds(float* x, float* y, float* w, float* h) const noexcept
 {
-    if (pImpl->bounds(x, y, w, h)) return Result::Success;
+    if (pImpl->bounds(x, y, w, h, false)) return Result::Success;
+    return Result::InsufficientCondition;
+}
+
+
+Result Paint::bounds(float* x, float* y, float* w, float* h, bool tight) const noexcept
+{
+    if (pImpl->bounds(x, y, w, h, tight)) return Result::Success;
     return Result::InsufficientCondition;
 }
 
@@ -94,6 +101,7 @@ Result Paint::opacity(uint8_t o) noexcept
 
     pImpl->opacity = o;
     pImpl->flag |= RenderUpdateFlag::Color;
+    pImpl->mark();
 
     return Result::Success;
 }
@@ -36,13 +36,17 @@ namespace tvg
         virtual bool dispose(RenderMethod& renderer) = 0;
         virtual void* update(RenderMethod& renderer, const RenderTransform* transform, uint32_t opacity, Array<RenderData>& clips, RenderUpdateFlag pFlag) = 0;   //Return engine data if it has.
         virtual bool render(RenderMethod& renderer) = 0;
-        virtual bool bounds(float* x, float* y, float* w, float* h) const = 0;
+        virtual bool bounds(float* x, float* y, float* w, float* h, bool tight) const = 0;
         virtual bool bounds(RenderMethod& renderer, uint32_t* x, uint32_t* y, uint32_t* w, uint32_t* h) const = 0;
         virtual Paint* duplicate() = 0;
+        virtual bool dirty() = 0;
+        virtual bool hit(RenderMethod& renderer, uint32_t x, uint32_t y, uint32_t w, uint32_t h, uint8_t threshold, Array<Paint*>& list) = 0;   //Collect hit paints, front to back.
     };
 
     struct Paint::Impl
     {
+        TVG_DECLARE_POOL(Paint::Impl);
+
         StrategyMethod* smethod = nullptr;
         RenderTransform *rTransform = nullptr;
         uint32_t flag = RenderUpdateFlag::None;
@@ -52,6 +56,12 @@ namespace tvg
 
         uint8_t opacity = 255;
 
+        Paint::Impl* parent = nullptr;              //owner to be notified of the changes
+        Array<Paint::Impl*>* pending = nullptr;     //dirty list of the owner
+        uint32_t slot = 0;                          //position in the dirty list of the owner
+        void* edata = nullptr;                      //engine data of the last update
+        bool touched = true;                        //this subtree has changes to be updated
+
         ~Impl() {
             if (cmpTarget) delete(cmpTarget);
             if (smethod) delete(smethod);
@@ -63,6 +73,39 @@ namespace tvg
             smethod = method;
         }
 
+        void queue()
+        {
+            slot = pending->count;
+            pending->push(this);
+        }
+
+        //Report the changes to the ancestors, stops at the one already reported.
+        void mark()
+        {
+            for (auto p = this; p && !p->touched; p = p->parent) {
+                p->touched = true;
+                if (p->pending) p->queue();
+            }
+        }
+
+        void attach(Paint::Impl* parent, Array<Paint::Impl*>* pending)
+        {
+            this->parent = parent;
+            this->pending = pending;
+
+            if (!touched) return;
+            if (pending) queue();
+            if (parent) parent->mark();
+        }
+
+        void detach()
+        {
+            //Not an update target of the owner anymore, the owner skips the emptied slot
+            if (pending && slot < pending->count && pending->data[slot] == this) pending->data[slot] = nullptr;
+            parent = nullptr;
+            pending = nullptr;
+        }
+
         bool rotate(float degree)
         {
             if (rTransform) {
@@ -73,7 +116,10 @@ namespace tvg
                 if (!rTransform) return false;
             }
             rTransform->degree = degree;
-            if (!rTransform->overriding) flag |= RenderUpdateFlag::Transform;
+            if (!rTransform->overriding) {
+                flag |= RenderUpdateFlag::Transform;
+                mark();
+            }
 
             return true;
         }
@@ -88,7 +134,10 @@ namespace tvg
                 if (!rTransform) return false;
             }
             rTransform->scale = factor;
-            if (!rTransform->overriding) flag |= RenderUpdateFlag::Transform;
+            if (!rTransform->overriding) {
+                flag |= RenderUpdateFlag::Transform;
+                mark();
+            }
 
             return true;
         }
@@ -104,7 +153,10 @@ namespace tvg
             }
             rTransform->x = x;
             rTransform->y = y;
-            if (!rTransform->overriding) flag |= RenderUpdateFlag::Transform;
+            if (!rTransform->overriding) {
+                flag |= RenderUpdateFlag::Transform;
+                mark();
+            }
 
             return true;
         }
@@ -117,13 +169,14 @@ namespace tvg
             }
             rTransform->override(m);
             flag |= RenderUpdateFlag::Transform;
+            mark();
 
             return true;
         }
 
-        bool bounds(float* x, float* y, float* w, float* h) const
+        bool bounds(float* x, float* y, float* w, float* h, bool tight) const
         {
-            return smethod->bounds(x, y, w, h);
+            return smethod->bounds(x, y, w, h, tight);
         }
 
         bool bounds(RenderMethod& renderer, uint32_t* x, uint32_t* y, uint32_t* w, uint32_t* h) const
@@ -131,6 +184,18 @@ namespace tvg
             return smethod->bounds(renderer, x, y, w, h);
         }
 
+        bool dirty()
+        {
+            if (flag != RenderUpdateFlag::None) return true;
+            if (cmpTarget && cmpTarget->pImpl->dirty()) return true;
+            return smethod->dirty();
+        }
+
+        bool hit(RenderMethod& renderer, uint32_t x, uint32_t y, uint32_t w, uint32_t h, uint8_t threshold, Array<Paint*>& list)
+        {
+            return smethod->hit(renderer, x, y, w, h, threshold, list);
+        }
+
         bool dispose(RenderMethod& renderer)
         {
             if (cmpTarget) cmpTarget->pImpl->dispose(renderer);
@@ -139,6 +204,10 @@ namespace tvg
 
         void* update(RenderMethod& renderer, const RenderTransform* pTransform, uint32_t opacity, Array<RenderData>& clips, uint32_t pFlag)
         {
+            //Nothing changed in this subtree, engine data is still valid.
+            if (!touched && pFlag == RenderUpdateFlag::None) return edata;
+            touched = false;
+
             if (flag & RenderUpdateFlag::Transform) {
                 if (!rTransform) return nullptr;
                 if (!rTransform->update()) {
@@ -169,6 +238,8 @@ namespace tvg
 
             if (cmpData) clips.pop();
 
+            this->edata = edata;
+
             return edata;
         }
 
@@ -211,7 +282,10 @@ namespace tvg
 
             ret->pImpl->opacity = opacity;
 
-            if (cmpTarget) ret->pImpl->cmpTarget = cmpTarget->duplicate();
+            if (cmpTarget) {
+                ret->pImpl->cmpTarget = cmpTarget->duplicate();
+                if (ret->pImpl->cmpTarget) ret->pImpl->cmpTarget->pImpl->attach(ret->pImpl, nullptr);
+            }
 
             ret->pImpl->cmpMethod = cmpMethod;
 
@@ -224,6 +298,8 @@ namespace tvg
             if (target && method == CompositeMethod::None) return false;
             cmpTarget = target;
             cmpMethod = method;
+            if (target) target->pImpl->attach(this, nullptr);
+            mark();
             return true;
         }
     };
@@ -232,14 +308,16 @@ namespace tvg
     template<class T>
     struct PaintMethod : StrategyMethod
     {
+        TVG_DECLARE_POOL(PaintMethod);
+
         T* inst = nullptr;
 
         PaintMethod(T* _inst) : inst(_inst) {}
         ~PaintMethod() {}
 
-        bool bounds(float* x, float* y, float* w, float* h) const override
+        bool bounds(float* x, float* y, float* w, float* h, bool tight) const override
         {
-            return inst->bounds(x, y, w, h);
+            return inst->bounds(x, y, w, h, tight);
         }
 
         bool bounds(RenderMethod& renderer, uint32_t* x, uint32_t* y, uint32_t* w, uint32_t* h) const override
@@ -266,6 +344,16 @@ namespace tvg
         {
             return inst->duplicate();
         }
+
+        bool dirty() override
+        {
+            return inst->dirty();
+        }
+
+        bool hit(RenderMethod& renderer, uint32_t x, uint32_t y, uint32_t w, uint32_t h, uint8_t threshold, Array<Paint*>& list) override
+        {
+            return inst->hit(renderer, x, y, w, h, threshold, list);
+        }
     };
 }
 
@@ -48,6 +48,8 @@ Result Picture::load(const std::string& path) noexcept
 {
     if (path.empty()) return Result::InvalidArguments;
 
+    Paint::pImpl->mark();
+
     return pImpl->load(path);
 }
 
@@ -56,6 +58,8 @@ Result Picture::load(const char* data, uint32_t size) noexcept
 {
     if (!data || size <= 0) return Result::InvalidArguments;
 
+    Paint::pImpl->mark();
+
     return pImpl->load(data, size);
 }
 
@@ -64,10 +68,30 @@ Result Picture::load(uint32_t* data, uint32_t w, uint32_t h, bool copy) noexcept
 {
     if (!data || w <= 0 || h <= 0) return Result::InvalidArguments;
 
+    Paint::pImpl->mark();
+
     return pImpl->load(data, w, h, copy);
 }
 
 
+Result Picture::feed(const char* data, uint32_t size) noexcept
+{
+    if (!data || size <= 0) return Result::InvalidArguments;
+
+    Paint::pImpl->mark();
+
+    return pImpl->feed(data, size);
+}
+
+
+Result Picture::finish() noexcept
+{
+    Paint::pImpl->mark();
+
+    return pImpl->finish();
+}
+
+
 Result Picture::viewbox(float* x, float* y, float* w, float* h) const noexcept
 {
     if (pImpl->viewbox(x, y, w, h)) return Result::Success;
@@ -77,8 +101,11 @@ Result Picture::viewbox(float* x, float* y, float* w, float* h) const noexcept
 
 Result Picture::size(float w, float h) noexcept
 {
-    if (pImpl->size(w, h)) return Result::Success;
-    return Result::InsufficientCondition;
+    if (!pImpl->size(w, h)) return Result::InsufficientCondition;
+
+    Paint::pImpl->mark();
+
+    return Result::Success;
 }
 
 
@@ -32,6 +32,8 @@
 
 struct Picture::Impl
 {
+    TVG_DECLARE_POOL(Picture::Impl);
+
     unique_ptr<Loader> loader = nullptr;
     Paint* paint = nullptr;
     uint32_t *pixels = nullptr;
@@ -39,6 +41,7 @@ struct Picture::Impl
     void *rdata = nullptr;              //engine data
     float w = 0, h = 0;
     bool resizing = false;
+    bool streaming = false;             //contents are being fed
 
     Impl(Picture* p) : picture(p)
     {
@@ -148,10 +151,10 @@ struct Picture::Impl
         return true;
     }
 
-    bool bounds(float* x, float* y, float* w, float* h)
+    bool bounds(float* x, float* y, float* w, float* h, bool tight)
     {
         if (!paint) return false;
-        return paint->pImpl->bounds(x, y, w, h);
+        return paint->pImpl->bounds(x, y, w, h, tight);
     }
 
     bool bounds(RenderMethod& renderer, uint32_t* x, uint32_t* y, uint32_t* w, uint32_t* h)
@@ -161,8 +164,23 @@ struct Picture::Impl
         return false;
     }
 
+    bool hit(RenderMethod& renderer, uint32_t x, uint32_t y, uint32_t w, uint32_t h, uint8_t threshold, Array<Paint*>& list)
+    {
+        auto ret = false;
+        if (pixels) {
+            ret = (rdata && renderer.hit(rdata, x, y, w, h, threshold));
+        } else if (paint) {
+            //The loaded contents are internal, report the picture itself
+            Array<Paint*> contents;
+            ret = paint->pImpl->hit(renderer, x, y, w, h, threshold, contents);
+        }
+        if (ret) list.push(picture);
+        return ret;
+    }
+
     Result load(const string& path)
     {
+        streaming = false;
         if (loader) loader->close();
         loader = LoaderMgr::loader(path);
         if (!loader) return Result::NonSupport;
@@ -174,6 +192,7 @@ struct Picture::Impl
 
     Result load(const char* data, uint32_t size)
     {
+        streaming = false;
         if (loader) loader->close();
         loader = LoaderMgr::loader(data, size);
         if (!loader) return Result::NonSupport;
@@ -185,12 +204,45 @@ struct Picture::Impl
 
     Result load(uint32_t* data, uint32_t w, uint32_t h, bool copy)
     {
+        streaming = false;
         if (loader) loader->close();
         loader = LoaderMgr::loader(data, w, h, copy);
         if (!loader) return Result::NonSupport;
         return Result::Success;
     }
 
+    Result feed(const char* data, uint32_t size)
+    {
+        //The first part of new contents
+        if (!streaming) {
+            if (loader) loader->close();
+            loader = LoaderMgr::stream(data, size);
+            if (!loader) return Result::NonSupport;
+            streaming = true;
+            return Result::Success;
+        }
+        if (!loader->feed(data, size)) return Result::Unknown;
+        return Result::Success;
+    }
+
+    Result finish()
+    {
+        if (!streaming) return Result::InsufficientCondition;
+        streaming = false;
+        if (!loader->read()) return Result::Unknown;
+        w = loader->w;
+        h = loader->h;
+        return Result::Success;
+    }
+
+    bool dirty()
+    {
+        if (resizing) return true;
+        if (paint) return paint->pImpl->dirty();
+        //Not loaded yet
+        return (loader && !pixels);
+    }
+
     Paint* duplicate()
     {
         reload();
@@ -0,0 +1,316 @@
+/*
+ * Copyright (c) 2020 Samsung Electronics Co., Ltd. All rights reserved.
+
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef _TVG_POOL_H_
+#define _TVG_POOL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <atomic>
+#include <new>
+
+namespace tvg
+{
+
+#define POOL_SLAB_SIZE 64     //blocks per slab
+
+//Shared by the pools of all types and threads
+struct PoolStatus
+{
+    //bytes kept in the free lists
+    static std::atomic<size_t>& usage()
+    {
+        static std::atomic<size_t> usage{0};
+        return usage;
+    }
+
+    //bumped on every trim request, the pools release their free slabs on the next access
+    static std::atomic<uint32_t>& trimReq()
+    {
+        static std::atomic<uint32_t> trimReq{0};
+        return trimReq;
+    }
+
+    static void trim()
+    {
+        trimReq().fetch_add(1, std::memory_order_relaxed);
+    }
+};
+
+
+/* Serves the allocations of a type from slabs of blocks, recycled through an intrusive free list.
+   The pool is per thread, so it doesn't need any locking. The blocks released on the other
+   threads are returned through the lock free list of the depot, which outlives the pool
+   until its last slab is released. Only Initializer::trim() gives the free slabs back. */
+template<class T>
+struct Pool
+{
+    struct Slab;
+
+    //Prefixes every block, the object follows it
+    union Block
+    {
+        struct {
+            Slab* slab;       //null: allocated after the pool is gone
+            Block* next;      //while it's free
+        } link;
+        max_align_t align;
+    };
+
+    struct Depot
+    {
+        std::atomic<uintptr_t> returned{0};       //blocks released on the other threads, DEAD once the pool is gone
+        std::atomic<uint32_t> refCnt{1};           //slabs and the pool
+    };
+
+    struct Slab
+    {
+        Depot* depot;
+        Slab* next;
+        uint32_t freeCnt;                          //counted on trim
+        std::atomic<uint32_t> live{0};             //blocks in use, counted once the pool is gone
+    };
+
+    static constexpr uintptr_t DEAD = 1;
+    static constexpr size_t ALIGN = alignof(max_align_t);
+    static constexpr size_t STRIDE = sizeof(Block) + (sizeof(T) + ALIGN - 1) / ALIGN * ALIGN;
+    static constexpr size_t SLAB_HEADER = (sizeof(Slab) + ALIGN - 1) / ALIGN * ALIGN;
+
+    Block* blocks = nullptr;                       //free list
+    uint32_t freeCnt = 0;
+    Slab* slabs = nullptr;
+    Depot* depot = nullptr;
+    uint32_t trimmed = PoolStatus::trimReq().load(std::memory_order_relaxed);
+
+    ~Pool()
+    {
+        if (depot) {
+            //Slabs with blocks in use are left to the threads releasing them
+            count();
+            for (auto slab = slabs; slab; ) {
+                auto next = slab->next;
+                auto live = POOL_SLAB_SIZE - slab->freeCnt;
+                if (live == 0) freeSlab(slab);
+                else slab->live.store(live, std::memory_order_release);
+                slab = next;
+            }
+            PoolStatus::usage().fetch_sub(freeCnt * STRIDE, std::memory_order_relaxed);
+
+            //The blocks returned so far are released as if the pool was gone before
+            auto block = reinterpret_cast<Block*>(depot->returned.exchange(DEAD, std::memory_order_acq_rel));
+            while (block) {
+                auto next = block->link.next;
+                orphan(block);
+                block = next;
+            }
+            if (depot->refCnt.fetch_sub(1, std::memory_order_acq_rel) == 1) delete(depot);
+        }
+        destroyed() = true;
+    }
+
+    //Outlives the pool, the thread exit might still release blocks after the pool is gone
+    static bool& destroyed()
+    {
+        static thread_local bool destroyed = false;
+        return destroyed;
+    }
+
+    static Pool& get()
+    {
+        static thread_local Pool pool;
+
+        auto req = PoolStatus::trimReq().load(std::memory_order_relaxed);
+        if (pool.trimmed != req) {
+            pool.trimmed = req;
+            pool.trim();
+        }
+        return pool;
+    }
+
+    static void* object(Block* block)
+    {
+        return reinterpret_cast<char*>(block) + sizeof(Block);
+    }
+
+    static void* alloc()
+    {
+        Block* block;
+
+        if (destroyed()) {
+            block = static_cast<Block*>(malloc(STRIDE));
+            if (!block) return nullptr;
+            block->link.slab = nullptr;
+            return object(block);
+        }
+
+        auto& pool = get();
+        if (!pool.blocks) pool.collect();
+        if (!pool.blocks && !pool.grow()) return nullptr;
+
+        block = pool.blocks;
+        pool.blocks = block->link.next;
+        --pool.freeCnt;
+        PoolStatus::usage().fetch_sub(STRIDE, std::memory_order_relaxed);
+        return object(block);
+    }
+
+    static void release(void* ptr)
+    {
+        if (!ptr) return;
+        auto block = reinterpret_cast<Block*>(static_cast<char*>(ptr) - sizeof(Block));
+        auto slab = block->link.slab;
+
+        if (!slab) {
+            free(block);
+            return;
+        }
+
+        //Back to the own free list
+        if (!destroyed()) {
+            auto& pool = get();
+            if (slab->depot == pool.depot) {
+                pool.push(block);
+                return;
+            }
+        }
+
+        //Back to the owner thread, unless it's gone
+        auto& returned = slab->depot->returned;
+        auto head = returned.load(std::memory_order_acquire);
+        while (true) {
+            if (head == DEAD) {
+                orphan(block);
+                return;
+            }
+            block->link.next = reinterpret_cast<Block*>(head);
+            if (returned.compare_exchange_weak(head, reinterpret_cast<uintptr_t>(block), std::memory_order_acq_rel, std::memory_order_acquire)) return;
+        }
+    }
+
+    void push(Block* block)
+    {
+        block->link.next = blocks;
+        blocks = block;
+        ++freeCnt;
+        PoolStatus::usage().fetch_add(STRIDE, std::memory_order_relaxed);
+    }
+
+    //Take over the blocks released on the other threads
+    void collect()
+    {
+        if (!depot) return;
+        auto block = reinterpret_cast<Block*>(depot->returned.exchange(0, std::memory_order_acq_rel));
+        while (block) {
+            auto next = block->link.next;
+            push(block);
+            block = next;
+        }
+    }
+
+    bool grow()
+    {
+        if (!depot) {
+            depot = new Depot;
+            if (!depot) return false;
+        }
+
+        auto slab = static_cast<Slab*>(malloc(SLAB_HEADER + POOL_SLAB_SIZE * STRIDE));
+        if (!slab) return false;
+        slab->depot = depot;
+        slab->next = slabs;
+        new (&slab->live) std::atomic<uint32_t>(0);
+        slabs = slab;
+        depot->refCnt.fetch_add(1, std::memory_order_relaxed);
+
+        auto block = reinterpret_cast<char*>(slab) + SLAB_HEADER;
+        for (uint32_t i = 0; i < POOL_SLAB_SIZE; ++i, block += STRIDE) {
+            reinterpret_cast<Block*>(block)->link.slab = slab;
+            push(reinterpret_cast<Block*>(block));
+        }
+        return true;
+    }
+
+    //Release the slabs of which every block is free
+    void trim()
+    {
+        collect();
+        count();
+
+        Block* kept = nullptr;
+        auto released = 0U;
+        for (auto block = blocks; block; ) {
+            auto next = block->link.next;
+            if (block->link.slab->freeCnt < POOL_SLAB_SIZE) {
+                block->link.next = kept;
+                kept = block;
+            } else {
+                ++released;
+            }
+            block = next;
+        }
+        blocks = kept;
+        freeCnt -= released;
+        PoolStatus::usage().fetch_sub(released * STRIDE, std::memory_order_relaxed);
+
+        auto slab = &slabs;
+        while (*slab) {
+            auto cur = *slab;
+            if (cur->freeCnt == POOL_SLAB_SIZE) {
+                *slab = cur->next;
+                freeSlab(cur);
+            } else {
+                slab = &cur->next;
+            }
+        }
+    }
+
+    //Free blocks per slab
+    void count()
+    {
+        for (auto slab = slabs; slab; slab = slab->next) slab->freeCnt = 0;
+        for (auto block = blocks; block; block = block->link.next) ++block->link.slab->freeCnt;
+    }
+
+    static void freeSlab(Slab* slab)
+    {
+        auto depot = slab->depot;
+        slab->live.~atomic();
+        free(slab);
+        if (depot->refCnt.fetch_sub(1, std::memory_order_acq_rel) == 1) delete(depot);
+    }
+
+    //A block of the pool which is gone, the last one takes its slab along
+    static void orphan(Block* block)
+    {
+        auto slab = block->link.slab;
+        if (slab->live.fetch_sub(1, std::memory_order_acq_rel) == 1) freeSlab(slab);
+    }
+};
+
+}
+
+//Route the allocations of the type through its pool
+#define TVG_DECLARE_POOL(T) \
+    static void* operator new(size_t) noexcept { return tvg::Pool<T>::alloc(); } \
+    static void operator delete(void* block) { tvg::Pool<T>::release(block); }
+
+#endif //_TVG_POOL_H_
@@ -24,6 +24,7 @@
 
 #include "tvgCommon.h"
 #include "tvgArray.h"
+#include "tvgPool.h"
 
 namespace tvg
 {
@@ -48,6 +49,8 @@ enum RenderUpdateFlag {None = 0, Path = 1, Color = 2, Gradient = 4, Stroke = 8,
 
 struct RenderTransform
 {
+    TVG_DECLARE_POOL(RenderTransform);
+
     Matrix m;             //3x3 Matrix Elements
     float x = 0.0f;
     float y = 0.0f;
@@ -65,7 +68,7 @@ struct RenderTransform
 struct RenderMethod
 {
     virtual ~RenderMethod() {}
-    virtual RenderData prepare(const Shape& shape, RenderData data, const RenderTransform* transform, uint32_t opacity, Array<RenderData>& clips, RenderUpdateFlag flags) = 0;
+    virtual RenderData prepare(const Shape& shape, const PathCmd* cmds, uint32_t cmdCnt, RenderData data, const RenderTransform* transform, uint32_t opacity, Array<RenderData>& clips, RenderUpdateFlag flags) = 0;
     virtual RenderData prepare(const Picture& picture, RenderData data, const RenderTransform* transform, uint32_t opacity, Array<RenderData>& clips, RenderUpdateFlag flags) = 0;
     virtual bool preRender() = 0;
     virtual bool renderShape(RenderData data) = 0;
@@ -73,13 +76,22 @@ struct RenderMethod
     virtual bool postRender() = 0;
     virtual bool dispose(RenderData data) = 0;
     virtual bool region(RenderData data, uint32_t* x, uint32_t* y, uint32_t* w, uint32_t* h) = 0;
+    virtual bool hit(RenderData data, uint32_t x, uint32_t y, uint32_t w, uint32_t h, uint8_t threshold) = 0;
+    virtual bool viewport(uint32_t* x, uint32_t* y, uint32_t* w, uint32_t* h) = 0;
 
     virtual bool clear() = 0;
     virtual bool sync() = 0;
+    virtual bool quality(Quality q) = 0;
 
     virtual Compositor* target(uint32_t x, uint32_t y, uint32_t w, uint32_t h) = 0;
     virtual bool beginComposite(Compositor* cmp, CompositeMethod method, uint32_t opacity) = 0;
     virtual bool endComposite(Compositor* cmp) = 0;
+
+    virtual RenderData beginCache(RenderData data, uint32_t x, uint32_t y, uint32_t w, uint32_t h) = 0;
+    virtual bool endCache(RenderData data) = 0;
+    virtual bool renderCache(RenderData data, int32_t dx, int32_t dy, uint32_t opacity) = 0;
+    virtual bool reusable(RenderData data, int32_t dx, int32_t dy) = 0;
+    virtual bool disposeCache(RenderData data) = 0;
 };
 
 }
@@ -48,6 +48,9 @@ Result Scene::push(unique_ptr<Paint> paint) noexcept
     auto p = paint.release();
     if (!p) return Result::MemoryCorruption;
     pImpl->paints.push(p);
+    pImpl->cached = false;
+    pImpl->region.valid = false;
+    p->pImpl->attach(Paint::pImpl, &pImpl->pending);
 
     return Result::Success;
 }
@@ -63,7 +66,90 @@ Result Scene::reserve(uint32_t size) noexcept
 
 Result Scene::clear() noexcept
 {
+    pImpl->pending.clear();
+    for (auto paint = pImpl->paints.data; paint < (pImpl->paints.data + pImpl->paints.count); ++paint) {
+        (*paint)->pImpl->detach();
+    }
     pImpl->paints.clear();
+    pImpl->cached = false;
+    pImpl->region.valid = false;
 
     return Result::Success;
 }
+
+
+Result Scene::insert(unique_ptr<Paint> paint, const Paint* at, bool after) noexcept
+{
+    auto idx = pImpl->find(at);
+    if (idx == pImpl->paints.count) return Result::InvalidArguments;
+
+    auto p = paint.release();
+    if (!p) return Result::MemoryCorruption;
+    pImpl->paints.insert(after ? idx + 1 : idx, p);
+    pImpl->cached = false;
+    pImpl->region.valid = false;
+    p->pImpl->attach(Paint::pImpl, &pImpl->pending);
+
+    return Result::Success;
+}
+
+
+Result Scene::remove(Paint* paint) noexcept
+{
+    auto idx = pImpl->find(paint);
+    if (idx == pImpl->paints.count) return Result::InvalidArguments;
+
+    pImpl->paints.erase(idx);
+    pImpl->cached = false;
+    pImpl->region.valid = false;
+
+    //Engine data is released on the next update.
+    paint->pImpl->detach();
+    pImpl->trash.push(paint);
+    Paint::pImpl->mark();
+
+    return Result::Success;
+}
+
+
+Result Scene::moveToFront(Paint* paint) noexcept
+{
+    auto idx = pImpl->find(paint);
+    if (idx == pImpl->paints.count) return Result::InvalidArguments;
+
+    pImpl->paints.erase(idx);
+    pImpl->paints.push(paint);
+    pImpl->cached = false;
+    pImpl->region.valid = false;
+
+    return Result::Success;
+}
+
+
+Result Scene::moveToBack(Paint* paint) noexcept
+{
+    auto idx = pImpl->find(paint);
+    if (idx == pImpl->paints.count) return Result::InvalidArguments;
+
+    pImpl->paints.erase(idx);
+    pImpl->paints.insert(0, paint);
+    pImpl->cached = false;
+    pImpl->region.valid = false;
+
+    return Result::Success;
+}
+
+
+Result Scene::cache(bool enable) noexcept
+{
+    pImpl->caching = enable;
+    pImpl->cached = false;
+
+    return Result::Success;
+}
+
+
+bool Scene::cache() const noexcept
+{
+    return pImpl->caching;
+}
@@ -28,11 +28,59 @@
 /* Internal Class Implementation                                        */
 /************************************************************************/
 
+#define SCENE_GRID_SIZE 8            //cells per axis of the children grid
+#define SCENE_GRID_THRESHOLD 32      //minimum children to build the grid
+
+static int _compareIndex(const void* a, const void* b)
+{
+    auto i1 = *static_cast<const uint32_t*>(a);
+    auto i2 = *static_cast<const uint32_t*>(b);
+    return (i1 > i2) - (i1 < i2);
+}
+
 struct Scene::Impl
 {
+    TVG_DECLARE_POOL(Scene::Impl);
+
     Array<Paint*> paints;
+    Array<Paint::Impl*> pending;    //children having changes to be updated
+    Array<Paint*> trash;            //removed children, disposed on the next update
     uint8_t opacity;            //for composition
 
+    RenderData cdata = nullptr; //layer cache
+    Matrix cacheTransform;      //transform of the cached layer
+    int32_t dx = 0, dy = 0;     //layer cache offset
+    bool caching = false;       //layer cache hint
+    bool cached = false;        //layer cache is valid
+    bool clipped = false;
+
+    struct Region {
+        uint32_t x1, y1, x2, y2;
+    };
+
+    struct {
+        uint32_t x1, y1, x2, y2;
+        bool valid = false;
+    } region;                   //merged regions of the children
+
+    struct {
+        Array<Region> regions;  //regions of the children
+        Array<uint32_t> cells;  //indices of the children, binned by the cells
+        Array<uint32_t> active; //indices of the children having a region
+        uint32_t offsets[SCENE_GRID_SIZE * SCENE_GRID_SIZE + 1];
+        uint32_t cw, ch;        //cell size
+        bool valid = false;
+    } grid;                     //uniform grid over the merged region for culling
+
+    Array<uint32_t> visible;    //culled children, in the painting order
+
+    ~Impl()
+    {
+        //Not disposed by any owner, the children go along with the scene.
+        for (auto paint = paints.data; paint < (paints.data + paints.count); ++paint) delete(*paint);
+        for (auto paint = trash.data; paint < (trash.data + trash.count); ++paint) delete(*paint);
+    }
+
     bool dispose(RenderMethod& renderer)
     {
         for (auto paint = paints.data; paint < (paints.data + paints.count); ++paint) {
@@ -40,20 +88,112 @@ struct Scene::Impl
             delete(*paint);
         }
         paints.clear();
+        pending.clear();
+        clean(renderer);
+
+        renderer.disposeCache(cdata);
+        cdata = nullptr;
+        cached = false;
+        region.valid = false;
+
+        return true;
+    }
+
+    void clean(RenderMethod& renderer)
+    {
+        for (auto paint = trash.data; paint < (trash.data + trash.count); ++paint) {
+            (*paint)->pImpl->dispose(renderer);
+            delete(*paint);
+        }
+        trash.clear();
+    }
+
+    uint32_t find(const Paint* paint)
+    {
+        for (uint32_t i = 0; i < paints.count; ++i) {
+            if (paints.data[i] == paint) return i;
+        }
+        return paints.count;
+    }
+
+    bool dirty()
+    {
+        for (auto paint = paints.data; paint < (paints.data + paints.count); ++paint) {
+            if ((*paint)->pImpl->dirty()) return true;
+        }
+        return false;
+    }
+
+    bool reusable(RenderMethod &renderer, const RenderTransform* transform, uint32_t opacity, Array<RenderData>& clips, RenderUpdateFlag flag)
+    {
+        if (!cached || opacity == 0 || clips.count > 0) return false;
+
+        //Only the transform and the opacity can be changed
+        if (flag & ~(RenderUpdateFlag::Transform | RenderUpdateFlag::Color)) return false;
+
+        Matrix m = {1, 0, 0, 0, 1, 0, 0, 0, 1};
+        if (transform) m = transform->m;
+
+        if (fabsf(m.e11 - cacheTransform.e11) > FLT_EPSILON || fabsf(m.e12 - cacheTransform.e12) > FLT_EPSILON ||
+            fabsf(m.e21 - cacheTransform.e21) > FLT_EPSILON || fabsf(m.e22 - cacheTransform.e22) > FLT_EPSILON) return false;
+
+        //Only the integral translation keeps the cached pixels
+        auto tx = m.e13 - cacheTransform.e13;
+        auto ty = m.e23 - cacheTransform.e23;
+        auto x = static_cast<int32_t>(roundf(tx));
+        auto y = static_cast<int32_t>(roundf(ty));
+        if (fabsf(tx - x) > 0.001f || fabsf(ty - y) > 0.001f) return false;
+
+        if (pending.count > 0 || dirty()) return false;
+
+        if (!renderer.reusable(cdata, x, y)) return false;
+
+        dx = x;
+        dy = y;
 
         return true;
     }
 
     void* update(RenderMethod &renderer, const RenderTransform* transform, uint32_t opacity, Array<RenderData>& clips, RenderUpdateFlag flag)
     {
+        if (trash.count > 0) clean(renderer);
+
+        if (!caching && cdata) {
+            renderer.disposeCache(cdata);
+            cdata = nullptr;
+            cached = false;
+        }
+
         /* Overriding opacity value. If this scene is half-translucent,
            It must do intermeidate composition with that opacity value. */
         this->opacity = static_cast<uint8_t>(opacity);
+
+        //Children are not touched while the layer cache is valid
+        if (caching && reusable(renderer, transform, opacity, clips, flag)) return nullptr;
+
+        //Children were left behind by the shifted layer cache
+        if (dx != 0 || dy != 0) flag = static_cast<RenderUpdateFlag>(flag | RenderUpdateFlag::Transform);
+
+        if (transform) cacheTransform = transform->m;
+        else cacheTransform = {1, 0, 0, 0, 1, 0, 0, 0, 1};
+        dx = dy = 0;
+        cached = false;
+        clipped = (clips.count > 0);
+        region.valid = false;
+
         if (opacity > 0) opacity = 255;
 
-        for (auto paint = paints.data; paint < (paints.data + paints.count); ++paint) {
-            (*paint)->pImpl->update(renderer, transform, opacity, clips, static_cast<uint32_t>(flag));
+        //Inherited changes reach all the children, otherwise only the changed ones.
+        if (flag == RenderUpdateFlag::None) {
+            for (uint32_t i = 0; i < pending.count; ++i) {
+                if (pending.data[i]) pending.data[i]->update(renderer, transform, opacity, clips, static_cast<uint32_t>(flag));
+            }
+        } else {
+            for (auto paint = paints.data; paint < (paints.data + paints.count); ++paint) {
+                (*paint)->pImpl->update(renderer, transform, opacity, clips, static_cast<uint32_t>(flag));
+            }
         }
+        pending.clear();
 
         /* FXIME: it requires to return list of children engine data
            This is necessary for scene composition */
@@ -62,18 +202,57 @@ struct Scene::Impl
 
     bool render(RenderMethod& renderer)
     {
+        uint32_t x, y, w, h;
+
+        if (caching && !clipped) {
+            if (opacity == 0) return true;
+
+            //Nothing is visible in this subtree
+            if (!bounds(renderer, &x, &y, &w, &h) || w == 0 || h == 0) return true;
+
+            //The engine may have dropped the layer image
+            if (cached && !renderer.reusable(cdata, dx, dy)) cached = false;
+
+            if (!cached) {
+
+                auto data = renderer.beginCache(cdata, x, y, w, h);
+                if (data) {
+                    cdata = data;
+                    for (auto paint = paints.data; paint < (paints.data + paints.count); ++paint) {
+                        if (!(*paint)->pImpl->render(renderer)) {
+                            renderer.endCache(cdata);
+                            return false;
+                        }
+                    }
+                    renderer.endCache(cdata);
+                    cached = true;
+                }
+            }
+
+            if (cached) return renderer.renderCache(cdata, dx, dy, opacity);
+        }
+
         Compositor* cmp = nullptr;
 
         //Half translucent. This condition requires intermediate composition.
         if ((opacity < 255 && opacity > 0) && (paints.count > 1)) {
-            uint32_t x, y, w, h;
-            if (!bounds(renderer, &x, &y, &w, &h)) return false;
+            //Nothing is visible in this subtree
+            if (!bounds(renderer, &x, &y, &w, &h) || w == 0 || h == 0) return true;
             cmp = renderer.target(x, y, w, h);
             renderer.beginComposite(cmp, CompositeMethod::None, opacity);
         }
 
-        for (auto paint = paints.data; paint < (paints.data + paints.count); ++paint) {
-            if (!(*paint)->pImpl->render(renderer)) return false;
+        /* Large scenes draw only the children within the viewport. Culling needs the engine regions,
+           so it only saves the rasterization: update() still prepares every changed child,
+           and the grid is rebuilt from scratch once any child region changes. */
+        if (paints.count >= SCENE_GRID_THRESHOLD && renderer.viewport(&x, &y, &w, &h) && cull(renderer, x, y, w, h, visible)) {
+            for (auto idx = visible.data; idx < (visible.data + visible.count); ++idx) {
+                if (!paints.data[*idx]->pImpl->render(renderer)) return false;
+            }
+        } else {
+            for (auto paint = paints.data; paint < (paints.data + paints.count); ++paint) {
+                if (!(*paint)->pImpl->render(renderer)) return false;
+            }
         }
 
         if (cmp) renderer.endComposite(cmp);
@@ -81,22 +260,33 @@ struct Scene::Impl
         return true;
     }
 
-    bool bounds(RenderMethod& renderer, uint32_t* px, uint32_t* py, uint32_t* pw, uint32_t* ph)
+    void merge(RenderMethod& renderer)
     {
-        if (paints.count == 0) return false;
-
         uint32_t x1 = UINT32_MAX;
         uint32_t y1 = UINT32_MAX;
         uint32_t x2 = 0;
         uint32_t y2 = 0;
 
+        auto indexing = (paints.count >= SCENE_GRID_THRESHOLD);
+        grid.regions.clear();
+        grid.active.clear();
+        grid.valid = false;
+
         for (auto paint = paints.data; paint < (paints.data + paints.count); ++paint) {
             uint32_t x = UINT32_MAX;
             uint32_t y = UINT32_MAX;
             uint32_t w = 0;
             uint32_t h = 0;
 
-            if (!(*paint)->pImpl->bounds(renderer, &x, &y, &w, &h)) continue;
+            if (!(*paint)->pImpl->bounds(renderer, &x, &y, &w, &h) || w == 0 || h == 0) {
+                if (indexing) grid.regions.push({0, 0, 0, 0});
+                continue;
+            }
+
+            if (indexing) {
+                grid.regions.push({x, y, x + w, y + h});
+                grid.active.push(paint - paints.data);
+            }
 
             //Merge regions
             if (x < x1) x1 = x;
@@ -105,6 +295,142 @@ struct Scene::Impl
             if (y2 < y + h) y2 = (y + h);
         }
 
+        //Empty
+        if (x1 >= x2 || y1 >= y2) x1 = x2 = y1 = y2 = 0;
+
+        region.x1 = x1;
+        region.y1 = y1;
+        region.x2 = x2;
+        region.y2 = y2;
+        region.valid = true;
+
+        if (indexing && x1 < x2 && y1 < y2) index();
+    }
+
+    void cellRange(const Region& r, uint32_t* cx1, uint32_t* cy1, uint32_t* cx2, uint32_t* cy2)
+    {
+        auto x1 = (r.x1 > region.x1) ? r.x1 : region.x1;
+        auto y1 = (r.y1 > region.y1) ? r.y1 : region.y1;
+        auto x2 = (r.x2 < region.x2) ? r.x2 : region.x2;
+        auto y2 = (r.y2 < region.y2) ? r.y2 : region.y2;
+
+        *cx1 = (x1 - region.x1) / grid.cw;
+        *cy1 = (y1 - region.y1) / grid.ch;
+        *cx2 = (x2 - 1 - region.x1) / grid.cw;
+        *cy2 = (y2 - 1 - region.y1) / grid.ch;
+    }
+
+    //Bin the children regions into the grid cells
+    void index()
+    {
+        grid.cw = (region.x2 - region.x1 + SCENE_GRID_SIZE - 1) / SCENE_GRID_SIZE;
+        grid.ch = (region.y2 - region.y1 + SCENE_GRID_SIZE - 1) / SCENE_GRID_SIZE;
+
+        auto offsets = grid.offsets;
+        memset(offsets, 0, sizeof(grid.offsets));
+
+        uint32_t cx1, cy1, cx2, cy2;
+
+        //Count the children per cell
+        for (auto r = grid.regions.data; r < (grid.regions.data + grid.regions.count); ++r) {
+            if (r->x1 >= r->x2) continue;
+            cellRange(*r, &cx1, &cy1, &cx2, &cy2);
+            for (auto cy = cy1; cy <= cy2; ++cy) {
+                for (auto cx = cx1; cx <= cx2; ++cx) ++offsets[cy * SCENE_GRID_SIZE + cx + 1];
+            }
+        }
+
+        for (uint32_t i = 1; i <= SCENE_GRID_SIZE * SCENE_GRID_SIZE; ++i) offsets[i] += offsets[i - 1];
+
+        grid.cells.reserve(offsets[SCENE_GRID_SIZE * SCENE_GRID_SIZE]);
+        grid.cells.count = offsets[SCENE_GRID_SIZE * SCENE_GRID_SIZE];
+
+        //Fill the cells, the counts are the cursors of the cells
+        uint32_t cursors[SCENE_GRID_SIZE * SCENE_GRID_SIZE];
+        memcpy(cursors, offsets, sizeof(cursors));
+
+        for (uint32_t i = 0; i < grid.regions.count; ++i) {
+            auto r = grid.regions.data + i;
+            if (r->x1 >= r->x2) continue;
+            cellRange(*r, &cx1, &cy1, &cx2, &cy2);
+            for (auto cy = cy1; cy <= cy2; ++cy) {
+                for (auto cx = cx1; cx <= cx2; ++cx) grid.cells.data[cursors[cy * SCENE_GRID_SIZE + cx]++] = i;
+            }
+        }
+
+        grid.valid = true;
+    }
+
+    //Collect the children overlapping the given area in the painting order. False if nothing can be culled.
+    bool cull(RenderMethod& renderer, uint32_t x, uint32_t y, uint32_t w, uint32_t h, Array<uint32_t>& list)
+    {
+        if (paints.count < SCENE_GRID_THRESHOLD) return false;
+
+        if (!region.valid) merge(renderer);
+        if (!grid.valid) return false;
+
+        Region area = {x, y, x + w, y + h};
+
+        list.clear();
+
+        //The area covers all the children, skip the ones out of the surface
+        if (area.x1 <= region.x1 && area.y1 <= region.y1 && area.x2 >= region.x2 && area.y2 >= region.y2) {
+            if (grid.active.count == paints.count) return false;
+            list.reserve(grid.active.count);
+            memcpy(list.data, grid.active.data, sizeof(uint32_t) * grid.active.count);
+            list.count = grid.active.count;
+            return true;
+        }
+
+        if (area.x1 >= region.x2 || area.y1 >= region.y2 || area.x2 <= region.x1 || area.y2 <= region.y1) return true;
+
+        uint32_t cx1, cy1, cx2, cy2;
+        cellRange(area, &cx1, &cy1, &cx2, &cy2);
+
+        for (auto cy = cy1; cy <= cy2; ++cy) {
+            for (auto cx = cx1; cx <= cx2; ++cx) {
+                auto cell = cy * SCENE_GRID_SIZE + cx;
+                for (auto i = grid.offsets[cell]; i < grid.offsets[cell + 1]; ++i) {
+                    auto idx = grid.cells.data[i];
+                    auto& r = grid.regions.data[idx];
+                    if (area.x1 >= r.x2 || area.y1 >= r.y2 || area.x2 <= r.x1 || area.y2 <= r.y1) continue;
+                    list.push(idx);
+                }
+            }
+        }
+
+        //Children spanning several cells are collected more than once
+        qsort(list.data, list.count, sizeof(uint32_t), _compareIndex);
+
+        uint32_t cnt = 0;
+        for (uint32_t i = 0; i < list.count; ++i) {
+            if (cnt == 0 || list.data[cnt - 1] != list.data[i]) list.data[cnt++] = list.data[i];
+        }
+        list.count = cnt;
+
+        return true;
+    }
+
+    bool bounds(RenderMethod& renderer, uint32_t* px, uint32_t* py, uint32_t* pw, uint32_t* ph)
+    {
+        if (paints.count == 0) return false;
+
+        //Children regions don't change until the next update
+        if (!region.valid) merge(renderer);
+
+        auto x1 = region.x1;
+        auto y1 = region.y1;
+        auto x2 = region.x2;
+        auto y2 = region.y2;
+
+        //Children regions are behind the shifted layer cache
+        if (cached && x1 < x2 && y1 < y2) {
+            x1 = (static_cast<int32_t>(x1) + dx < 0) ? 0 : (x1 + dx);
+            y1 = (static_cast<int32_t>(y1) + dy < 0) ? 0 : (y1 + dy);
+            x2 = (static_cast<int32_t>(x2) + dx < 0) ? 0 : (x2 + dx);
+            y2 = (static_cast<int32_t>(y2) + dy < 0) ? 0 : (y2 + dy);
+        }
+
         if (px) *px = x1;
         if (py) *py = y1;
         if (pw) *pw = (x2 - x1);
@@ -113,7 +439,43 @@ struct Scene::Impl
         return true;
     }
 
-    bool bounds(float* px, float* py, float* pw, float* ph)
+    bool hit(RenderMethod& renderer, uint32_t x, uint32_t y, uint32_t w, uint32_t h, uint8_t threshold, Array<Paint*>& list)
+    {
+        //Reject by the merged region of the children
+        uint32_t rx, ry, rw, rh;
+        if (!bounds(renderer, &rx, &ry, &rw, &rh)) return false;
+        if (x >= rx + rw || y >= ry + rh || x + w <= rx || y + h <= ry) return false;
+
+        //Children are behind the shifted layer cache
+        if (cached) {
+            auto x1 = static_cast<int32_t>(x) - dx;
+            auto y1 = static_cast<int32_t>(y) - dy;
+            auto x2 = static_cast<int32_t>(x + w) - dx;
+            auto y2 = static_cast<int32_t>(y + h) - dy;
+            if (x2 <= 0 || y2 <= 0) return false;
+            x = x1 < 0 ? 0 : x1;
+            y = y1 < 0 ? 0 : y1;
+            w = x2 - x;
+            h = y2 - y;
+        }
+
+        auto ret = false;
+
+        //Front to back, only the children around the area
+        if (cull(renderer, x, y, w, h, visible)) {
+            for (auto i = visible.count; i > 0; --i) {
+                if (paints.data[visible.data[i - 1]]->pImpl->hit(renderer, x, y, w, h, threshold, list)) ret = true;
+            }
+            return ret;
+        }
+
+        for (auto i = paints.count; i > 0; --i) {
+            if (paints.data[i - 1]->pImpl->hit(renderer, x, y, w, h, threshold, list)) ret = true;
+        }
+        return ret;
+    }
+
+    bool bounds(float* px, float* py, float* pw, float* ph, bool tight)
     {
         if (paints.count == 0) return false;
 
@@ -128,7 +490,7 @@ struct Scene::Impl
             auto w = 0.0f;
             auto h = 0.0f;
 
-            if (!(*paint)->pImpl->bounds(&x, &y, &w, &h)) continue;
+            if (!(*paint)->pImpl->bounds(&x, &y, &w, &h, tight)) continue;
 
             //Merge regions
             if (x < x1) x1 = x;
@@ -151,10 +513,14 @@ struct Scene::Impl
         if (!ret) return nullptr;
         auto dup = ret.get()->pImpl;
 
+        dup->caching = caching;
         dup->paints.reserve(paints.count);
 
         for (auto paint = paints.data; paint < (paints.data + paints.count); ++paint) {
-            dup->paints.push((*paint)->duplicate());
+            auto p = (*paint)->duplicate();
+            if (!p) continue;
+            dup->paints.push(p);
+            p->pImpl->attach(ret->Paint::pImpl, &dup->pending);
         }
 
         return ret.release();
@@ -61,7 +61,7 @@ uint32_t Shape::pathCommands(const PathCommand** cmds) const noexcept
 {
     if (!cmds) return 0;
 
-    *cmds = pImpl->path.cmds;
+    *cmds = pImpl->exportCmds();
 
     return pImpl->path.cmdCnt;
 }
@@ -84,7 +84,35 @@ Result Shape::appendPath(const PathCommand *cmds, uint32_t cmdCnt, const Point*
     pImpl->path.grow(cmdCnt, ptsCnt);
     pImpl->path.append(cmds, cmdCnt, pts, ptsCnt);
 
-    pImpl->flag |= RenderUpdateFlag::Path;
+    pImpl->mark(RenderUpdateFlag::Path);
+
+    return Result::Success;
+}
+
+
+Result Shape::appendPath(PathCommand* cmds, uint32_t cmdCnt, Point* pts, uint32_t ptsCnt, void (*deleter)(void*)) noexcept
+{
+    if (cmdCnt == 0 || ptsCnt == 0 || !cmds || !pts) return Result::InvalidArguments;
+
+    auto& path = pImpl->path;
+    auto release = deleter ? deleter : free;
+
+    //Nothing to merge with, just take over the points.
+    if (path.cmdCnt == 0 && path.ptsCnt == 0) {
+        if (!path.adopt(cmds, cmdCnt, pts, ptsCnt, deleter)) {
+            release(cmds);
+            release(pts);
+            return Result::FailedAllocation;
+        }
+        release(cmds);
+    } else {
+        path.grow(cmdCnt, ptsCnt);
+        path.append(cmds, cmdCnt, pts, ptsCnt);
+        release(cmds);
+        release(pts);
+    }
+
+    pImpl->mark(RenderUpdateFlag::Path);
 
     return Result::Success;
 }
@@ -94,7 +122,7 @@ Result Shape::moveTo(float x, float y) noexcept
 {
     pImpl->path.moveTo(x, y);
 
-    pImpl->flag |= RenderUpdateFlag::Path;
+    pImpl->mark(RenderUpdateFlag::Path);
 
     return Result::Success;
 }
@@ -104,7 +132,7 @@ Result Shape::lineTo(float x, float y) noexcept
 {
     pImpl->path.lineTo(x, y);
 
-    pImpl->flag |= RenderUpdateFlag::Path;
+    pImpl->mark(RenderUpdateFlag::Path);
 
     return Result::Success;
 }
@@ -114,7 +142,7 @@ Result Shape::cubicTo(float cx1, float cy1, float cx2, float cy2, float x, float
 {
     pImpl->path.cubicTo(cx1, cy1, cx2, cy2, x, y);
 
-    pImpl->flag |= RenderUpdateFlag::Path;
+    pImpl->mark(RenderUpdateFlag::Path);
 
     return Result::Success;
 }
@@ -124,7 +152,7 @@ Result Shape::close() noexcept
 {
     pImpl->path.close();
 
-    pImpl->flag |= RenderUpdateFlag::Path;
+    pImpl->mark(RenderUpdateFlag::Path);
 
     return Result::Success;
 }
@@ -143,7 +171,7 @@ Result Shape::appendCircle(float cx, float cy, float rx, float ry) noexcept
     pImpl->path.cubicTo(cx - rx, cy - ryKappa, cx - rxKappa, cy - ry, cx, cy - ry);
     pImpl->path.close();
 
-    pImpl->flag |= RenderUpdateFlag::Path;
+    pImpl->mark(RenderUpdateFlag::Path);
 
     return Result::Success;
 }
@@ -204,7 +232,7 @@ Result Shape::appendArc(float cx, float cy, float radius, float startAngle, floa
 
     if (pie) pImpl->path.close();
 
-    pImpl->flag |= RenderUpdateFlag::Path;
+    pImpl->mark(RenderUpdateFlag::Path);
 
     return Result::Success;
 }
@@ -246,7 +274,7 @@ Result Shape::appendRect(float x, float y, float w, float h, float rx, float ry)
         pImpl->path.close();
     }
 
-    pImpl->flag |= RenderUpdateFlag::Path;
+    pImpl->mark(RenderUpdateFlag::Path);
 
     return Result::Success;
 }
@@ -258,12 +286,12 @@ Result Shape::fill(uint8_t r, uint8_t g, uint8_t b, uint8_t a) noexcept
     pImpl->color[1] = g;
     pImpl->color[2] = b;
     pImpl->color[3] = a;
-    pImpl->flag |= RenderUpdateFlag::Color;
+    pImpl->mark(RenderUpdateFlag::Color);
 
     if (pImpl->fill) {
         delete(pImpl->fill);
         pImpl->fill = nullptr;
-        pImpl->flag |= RenderUpdateFlag::Gradient;
+        pImpl->mark(RenderUpdateFlag::Gradient);
     }
 
     return Result::Success;
@@ -277,12 +305,33 @@ Result Shape::fill(unique_ptr<Fill> f) noexcept
 
     if (pImpl->fill && pImpl->fill != p) delete(pImpl->fill);
     pImpl->fill = p;
-    pImpl->flag |= RenderUpdateFlag::Gradient;
+    pImpl->mark(RenderUpdateFlag::Gradient);
+
+    return Result::Success;
+}
+
+
+Result Shape::instances(const Point* offsets, const uint8_t* opacities, uint32_t cnt) noexcept
+{
+    if (cnt > 0 && !offsets) return Result::InvalidArguments;
+
+    if (!pImpl->instance(offsets, opacities, cnt)) return Result::FailedAllocation;
 
     return Result::Success;
 }
 
 
+uint32_t Shape::instances(const Point** offsets, const uint8_t** opacities) const noexcept
+{
+    if (!pImpl->instances) return 0;
+
+    if (offsets) *offsets = pImpl->instances->offsets;
+    if (opacities) *opacities = pImpl->instances->opacities;
+
+    return pImpl->instances->cnt;
+}
+
+
 Result Shape::fillColor(uint8_t* r, uint8_t* g, uint8_t* b, uint8_t* a) const noexcept
 {
     if (r) *r = pImpl->color[0];
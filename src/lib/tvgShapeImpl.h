@@ -23,6 +23,7 @@
 #define _TVG_SHAPE_IMPL_H_
 
 #include <memory.h>
+#include <atomic>
 #include "tvgPaint.h"
 
 /************************************************************************/
@@ -58,9 +59,122 @@ struct ShapeStroke
 };
 
 
+struct ShapeInstances
+{
+    Point* offsets = nullptr;
+    uint8_t* opacities = nullptr;
+    uint32_t cnt = 0;
+
+    ShapeInstances() {}
+
+    ShapeInstances(const ShapeInstances* src)
+    {
+        set(src->offsets, src->opacities, src->cnt);
+    }
+
+    ~ShapeInstances()
+    {
+        if (offsets) free(offsets);
+        if (opacities) free(opacities);
+    }
+
+    bool set(const Point* offsets, const uint8_t* opacities, uint32_t cnt)
+    {
+        if (this->cnt != cnt) {
+            if (this->offsets) free(this->offsets);
+            if (this->opacities) free(this->opacities);
+            this->offsets = static_cast<Point*>(malloc(sizeof(Point) * cnt));
+            this->opacities = static_cast<uint8_t*>(malloc(sizeof(uint8_t) * cnt));
+            if (!this->offsets || !this->opacities) {
+                this->cnt = 0;
+                return false;
+            }
+        }
+        memcpy(this->offsets, offsets, sizeof(Point) * cnt);
+        if (opacities) memcpy(this->opacities, opacities, sizeof(uint8_t) * cnt);
+        else memset(this->opacities, 255, sizeof(uint8_t) * cnt);
+        this->cnt = cnt;
+
+        return true;
+    }
+};
+
+
+struct ShapeBounds
+{
+    Point min = {FLT_MAX, FLT_MAX};
+    Point max = {-FLT_MAX, -FLT_MAX};
+    uint32_t cmdCnt = 0;            //commands accumulated so far
+    uint32_t ptsCnt = 0;            //points accumulated so far
+
+    void reset()
+    {
+        min = {FLT_MAX, FLT_MAX};
+        max = {-FLT_MAX, -FLT_MAX};
+        cmdCnt = ptsCnt = 0;
+    }
+
+    void add(const Point& pt)
+    {
+        if (pt.x < min.x) min.x = pt.x;
+        if (pt.y < min.y) min.y = pt.y;
+        if (pt.x > max.x) max.x = pt.x;
+        if (pt.y > max.y) max.y = pt.y;
+    }
+
+    //Parameters of the curve turning points on one axis (B'(t) = 0)
+    static uint32_t extrema(float p0, float p1, float p2, float p3, float* t)
+    {
+        auto a = -p0 + 3 * p1 - 3 * p2 + p3;
+        auto b = 2 * (p0 - 2 * p1 + p2);
+        auto c = p1 - p0;
+        uint32_t cnt = 0;
+
+        if (fabsf(a) < FLT_EPSILON) {
+            if (fabsf(b) > FLT_EPSILON) t[cnt++] = -c / b;
+        } else {
+            auto d = b * b - 4 * a * c;
+            if (d >= 0) {
+                d = sqrtf(d);
+                t[cnt++] = (-b + d) / (2 * a);
+                t[cnt++] = (-b - d) / (2 * a);
+            }
+        }
+        return cnt;
+    }
+
+    void add(const Point& p0, const Point* ctrl)
+    {
+        const Point& p1 = ctrl[0];
+        const Point& p2 = ctrl[1];
+        const Point& p3 = ctrl[2];
+
+        add(p3);
+
+        //Control points inside of the current bounds can't push it
+        if (p1.x >= min.x && p1.x <= max.x && p1.y >= min.y && p1.y <= max.y &&
+            p2.x >= min.x && p2.x <= max.x && p2.y >= min.y && p2.y <= max.y) return;
+
+        float t[4];
+        auto cnt = extrema(p0.x, p1.x, p2.x, p3.x, t);
+        cnt += extrema(p0.y, p1.y, p2.y, p3.y, t + cnt);
+
+        for (uint32_t i = 0; i < cnt; ++i) {
+            if (t[i] <= 0.0f || t[i] >= 1.0f) continue;
+            auto mt = 1.0f - t[i];
+            auto w0 = mt * mt * mt;
+            auto w1 = 3 * mt * mt * t[i];
+            auto w2 = 3 * mt * t[i] * t[i];
+            auto w3 = t[i] * t[i] * t[i];
+            add({w0 * p0.x + w1 * p1.x + w2 * p2.x + w3 * p3.x, w0 * p0.y + w1 * p1.y + w2 * p2.y + w3 * p3.y});
+        }
+    }
+};
+
+
 struct ShapePath
 {
-    PathCommand* cmds = nullptr;
+    PathCmd* cmds = nullptr;
     uint32_t cmdCnt = 0;
     uint32_t reservedCmdCnt = 0;
 
@@ -68,44 +182,116 @@ struct ShapePath
     uint32_t ptsCnt = 0;
     uint32_t reservedPtsCnt = 0;
 
-    ~ShapePath()
+    atomic<uint32_t>* refCnt = nullptr; //shared by the duplicates (copy on write)
+
+    //Paths only grow until reset, so the bounds are accumulated incrementally.
+    ShapeBounds hull;               //control points
+    ShapeBounds tight;              //curve extrema
+    void (*deleter)(void*) = nullptr;   //adopted user points, not resizable
+
+    //The commands are always our own, only the points might be adopted.
+    static void dispose(PathCmd* cmds, Point* pts, void (*deleter)(void*))
     {
+        if (!deleter) deleter = free;
         if (cmds) free(cmds);
-        if (pts) free(pts);
+        if (pts) deleter(pts);
+    }
+
+    ~ShapePath()
+    {
+        release();
     }
 
     ShapePath()
     {
     }
 
-    void duplicate(const ShapePath* src)
+    void release()
     {
-        cmdCnt = src->cmdCnt;
-        reservedCmdCnt = src->reservedCmdCnt;
-        ptsCnt = src->ptsCnt;
-        reservedPtsCnt = src->reservedPtsCnt;
+        if (refCnt) {
+            if (refCnt->fetch_sub(1) > 1) {
+                cmds = nullptr;
+                pts = nullptr;
+                refCnt = nullptr;
+                deleter = nullptr;
+                return;
+            }
+            delete(refCnt);
+            refCnt = nullptr;
+        }
+        dispose(cmds, pts, deleter);
+        cmds = nullptr;
+        pts = nullptr;
+        deleter = nullptr;
+    }
 
-        cmds = static_cast<PathCommand*>(malloc(sizeof(PathCommand) * reservedCmdCnt));
-        if (!cmds) return;
-        memcpy(cmds, src->cmds, sizeof(PathCommand) * cmdCnt);
+    //Take own copy of the shared or adopted data before any modification
+    void detach()
+    {
+        if (!refCnt && !deleter) return;
 
-        pts = static_cast<Point*>(malloc(sizeof(Point) * reservedPtsCnt));
-        if (!pts) {
-            free(cmds);
+        if (refCnt && refCnt->load() == 1 && !deleter) {
+            delete(refCnt);
+            refCnt = nullptr;
             return;
         }
-        memcpy(pts, src->pts, sizeof(Point) * ptsCnt);
+
+        auto srcCmds = cmds;
+        auto srcPts = pts;
+
+        cmds = static_cast<PathCmd*>(malloc(sizeof(PathCmd) * reservedCmdCnt));
+        if (cmds) memcpy(cmds, srcCmds, sizeof(PathCmd) * cmdCnt);
+        else cmdCnt = reservedCmdCnt = 0;
+
+        pts = static_cast<Point*>(malloc(sizeof(Point) * reservedPtsCnt));
+        if (pts) memcpy(pts, srcPts, sizeof(Point) * ptsCnt);
+        else ptsCnt = reservedPtsCnt = 0;
+
+        //Last owner of the source buffers
+        if (!refCnt || refCnt->fetch_sub(1) == 1) {
+            if (refCnt) delete(refCnt);
+            dispose(srcCmds, srcPts, deleter);
+        }
+        refCnt = nullptr;
+        deleter = nullptr;
+    }
+
+    void duplicate(ShapePath* src)
+    {
+        release();
+
+        if (src->cmdCnt == 0 && src->ptsCnt == 0) return;
+
+        //Share the data with the source
+        if (!src->refCnt) {
+            src->refCnt = new atomic<uint32_t>(1);
+            if (!src->refCnt) return;
+        }
+        src->refCnt->fetch_add(1);
+
+        cmds = src->cmds;
+        cmdCnt = src->cmdCnt;
+        reservedCmdCnt = src->reservedCmdCnt;
+        pts = src->pts;
+        ptsCnt = src->ptsCnt;
+        reservedPtsCnt = src->reservedPtsCnt;
+        refCnt = src->refCnt;
+        deleter = src->deleter;
+        hull = src->hull;
+        tight = src->tight;
     }
 
     void reserveCmd(uint32_t cmdCnt)
     {
+        detach();
         if (cmdCnt <= reservedCmdCnt) return;
         reservedCmdCnt = cmdCnt;
-        cmds = static_cast<PathCommand*>(realloc(cmds, sizeof(PathCommand) * reservedCmdCnt));
+        cmds = static_cast<PathCmd*>(realloc(cmds, sizeof(PathCmd) * reservedCmdCnt));
     }
 
     void reservePts(uint32_t ptsCnt)
     {
+        detach();
         if (ptsCnt <= reservedPtsCnt) return;
         reservedPtsCnt = ptsCnt;
         pts = static_cast<Point*>(realloc(pts, sizeof(Point) * reservedPtsCnt));
@@ -119,42 +305,83 @@ struct ShapePath
 
     void reset()
     {
+        //Don't need to copy the shared data just for discarding it
+        if (refCnt || deleter) {
+            release();
+            reservedCmdCnt = 0;
+            reservedPtsCnt = 0;
+        }
         cmdCnt = 0;
         ptsCnt = 0;
+        hull.reset();
+        tight.reset();
+    }
+
+    void append(const PathCmd* cmds, uint32_t cmdCnt, const Point* pts, uint32_t ptsCnt)
+    {
+        detach();
+        memcpy(this->cmds + this->cmdCnt, cmds, sizeof(PathCmd) * cmdCnt);
+        memcpy(this->pts + this->ptsCnt, pts, sizeof(Point) * ptsCnt);
+        this->cmdCnt += cmdCnt;
+        this->ptsCnt += ptsCnt;
     }
 
     void append(const PathCommand* cmds, uint32_t cmdCnt, const Point* pts, uint32_t ptsCnt)
     {
-        memcpy(this->cmds + this->cmdCnt, cmds, sizeof(PathCommand) * cmdCnt);
+        detach();
+        for (uint32_t i = 0; i < cmdCnt; ++i) this->cmds[this->cmdCnt + i] = static_cast<PathCmd>(cmds[i]);
         memcpy(this->pts + this->ptsCnt, pts, sizeof(Point) * ptsCnt);
         this->cmdCnt += cmdCnt;
         this->ptsCnt += ptsCnt;
     }
 
+    //Take over the points without copying, the commands are narrowed into our own buffer. The path must be empty.
+    bool adopt(const PathCommand* cmds, uint32_t cmdCnt, Point* pts, uint32_t ptsCnt, void (*deleter)(void*))
+    {
+        release();
+        this->cmdCnt = this->reservedCmdCnt = this->ptsCnt = this->reservedPtsCnt = 0;
+        hull.reset();
+        tight.reset();
+
+        this->cmds = static_cast<PathCmd*>(malloc(sizeof(PathCmd) * cmdCnt));
+        if (!this->cmds) return false;
+        for (uint32_t i = 0; i < cmdCnt; ++i) this->cmds[i] = static_cast<PathCmd>(cmds[i]);
+
+        this->cmdCnt = this->reservedCmdCnt = cmdCnt;
+        this->pts = pts;
+        this->ptsCnt = this->reservedPtsCnt = ptsCnt;
+        this->deleter = deleter;
+
+        return true;
+    }
+
     void moveTo(float x, float y)
     {
+        detach();
         if (cmdCnt + 1 > reservedCmdCnt) reserveCmd((cmdCnt + 1) * 2);
         if (ptsCnt + 2 > reservedPtsCnt) reservePts((ptsCnt + 2) * 2);
 
-        cmds[cmdCnt++] = PathCommand::MoveTo;
+        cmds[cmdCnt++] = PathCmd::MoveTo;
         pts[ptsCnt++] = {x, y};
     }
 
     void lineTo(float x, float y)
     {
+        detach();
         if (cmdCnt + 1 > reservedCmdCnt) reserveCmd((cmdCnt + 1) * 2);
         if (ptsCnt + 2 > reservedPtsCnt) reservePts((ptsCnt + 2) * 2);
 
-        cmds[cmdCnt++] = PathCommand::LineTo;
+        cmds[cmdCnt++] = PathCmd::LineTo;
         pts[ptsCnt++] = {x, y};
     }
 
     void cubicTo(float cx1, float cy1, float cx2, float cy2, float x, float y)
     {
+        detach();
         if (cmdCnt + 1 > reservedCmdCnt) reserveCmd((cmdCnt + 1) * 2);
         if (ptsCnt + 3 > reservedPtsCnt) reservePts((ptsCnt + 3) * 2);
 
-        cmds[cmdCnt++] = PathCommand::CubicTo;
+        cmds[cmdCnt++] = PathCmd::CubicTo;
         pts[ptsCnt++] = {cx1, cy1};
         pts[ptsCnt++] = {cx2, cy2};
         pts[ptsCnt++] = {x, y};
@@ -162,30 +389,62 @@ struct ShapePath
 
     void close()
     {
-        if (cmdCnt > 0 && cmds[cmdCnt - 1] == PathCommand::Close) return;
+        if (cmdCnt > 0 && cmds[cmdCnt - 1] == PathCmd::Close) return;
 
+        detach();
         if (cmdCnt + 1 > reservedCmdCnt) reserveCmd((cmdCnt + 1) * 2);
-        cmds[cmdCnt++] = PathCommand::Close;
+        cmds[cmdCnt++] = PathCmd::Close;
     }
 
-    bool bounds(float* x, float* y, float* w, float* h)
+    void updateHull()
+    {
+        for (; hull.ptsCnt < ptsCnt; ++hull.ptsCnt) hull.add(pts[hull.ptsCnt]);
+    }
+
+    void updateTight()
+    {
+        for (; tight.cmdCnt < cmdCnt; ++tight.cmdCnt) {
+            switch (cmds[tight.cmdCnt]) {
+                case PathCmd::Close: break;
+                case PathCmd::MoveTo:
+                case PathCmd::LineTo: {
+                    if (tight.ptsCnt + 1 > ptsCnt) return;
+                    tight.add(pts[tight.ptsCnt]);
+                    tight.ptsCnt += 1;
+                    break;
+                }
+                case PathCmd::CubicTo: {
+                    if (tight.ptsCnt + 3 > ptsCnt) return;
+                    auto& start = (tight.ptsCnt > 0) ? pts[tight.ptsCnt - 1] : pts[0];
+                    if (tight.ptsCnt == 0) tight.add(start);
+                    tight.add(start, pts + tight.ptsCnt);
+                    tight.ptsCnt += 3;
+                    break;
+                }
+            }
+        }
+    }
+
+    bool bounds(float* x, float* y, float* w, float* h, bool tight)
     {
         if (ptsCnt == 0) return false;
 
-        Point min = { pts[0].x, pts[0].y };
-        Point max = { pts[0].x, pts[0].y };
+        ShapeBounds* bounds;
 
-        for (uint32_t i = 1; i < ptsCnt; ++i) {
-            if (pts[i].x < min.x) min.x = pts[i].x;
-            if (pts[i].y < min.y) min.y = pts[i].y;
-            if (pts[i].x > max.x) max.x = pts[i].x;
-            if (pts[i].y > max.y) max.y = pts[i].y;
+        if (tight) {
+            updateTight();
+            bounds = &this->tight;
+        } else {
+            updateHull();
+            bounds = &hull;
         }
 
-        if (x) *x = min.x;
-        if (y) *y = min.y;
-        if (w) *w = max.x - min.x;
-        if (h) *h = max.y - min.y;
+        if (bounds->ptsCnt == 0) return false;
+
+        if (x) *x = bounds->min.x;
+        if (y) *y = bounds->min.y;
+        if (w) *w = bounds->max.x - bounds->min.x;
+        if (h) *h = bounds->max.y - bounds->min.y;
 
         return true;
     }
@@ -194,14 +453,19 @@ struct ShapePath
 
 struct Shape::Impl
 {
+    TVG_DECLARE_POOL(Shape::Impl);
+
     ShapePath path;
     Fill *fill = nullptr;
     ShapeStroke *stroke = nullptr;
+    ShapeInstances *instances = nullptr;
     uint8_t color[4] = {0, 0, 0, 0};    //r, g, b, a
     FillRule rule = FillRule::Winding;
     RenderData rdata = nullptr;         //engine data
     Shape *shape = nullptr;
     uint32_t flag = RenderUpdateFlag::None;
+    PathCommand* exported = nullptr;    //widened commands for pathCommands()
+    uint32_t reservedExported = 0;
 
     Impl(Shape* s) : shape(s)
     {
@@ -211,6 +475,30 @@ struct Shape::Impl
     {
         if (fill) delete(fill);
         if (stroke) delete(stroke);
+        if (instances) delete(instances);
+        if (exported) free(exported);
+    }
+
+    const PathCommand* exportCmds()
+    {
+        if (path.cmdCnt > reservedExported) {
+            reservedExported = path.cmdCnt;
+            exported = static_cast<PathCommand*>(realloc(exported, sizeof(PathCommand) * reservedExported));
+        }
+        if (!exported) return nullptr;
+        for (uint32_t i = 0; i < path.cmdCnt; ++i) exported[i] = static_cast<PathCommand>(path.cmds[i]);
+        return exported;
+    }
+
+    bool dirty()
+    {
+        return (flag != RenderUpdateFlag::None);
+    }
+
+    void mark(RenderUpdateFlag flag)
+    {
+        this->flag |= flag;
+        shape->Paint::pImpl->mark();
     }
 
     bool dispose(RenderMethod& renderer)
@@ -227,7 +515,7 @@ struct Shape::Impl
 
     void* update(RenderMethod& renderer, const RenderTransform* transform, uint32_t opacity, Array<RenderData>& clips, RenderUpdateFlag pFlag)
     {
-        this->rdata = renderer.prepare(*shape, this->rdata, transform, opacity, clips, static_cast<RenderUpdateFlag>(pFlag | flag));
+        this->rdata = renderer.prepare(*shape, path.cmds, path.cmdCnt, this->rdata, transform, opacity, clips, static_cast<RenderUpdateFlag>(pFlag | flag));
         flag = RenderUpdateFlag::None;
         return this->rdata;
     }
@@ -237,9 +525,16 @@ struct Shape::Impl
         return renderer.region(rdata, x, y, w, h);
     }
 
-    bool bounds(float* x, float* y, float* w, float* h)
+    bool hit(RenderMethod& renderer, uint32_t x, uint32_t y, uint32_t w, uint32_t h, uint8_t threshold, Array<Paint*>& list)
     {
-        auto ret = path.bounds(x, y, w, h);
+        if (!rdata || !renderer.hit(rdata, x, y, w, h, threshold)) return false;
+        list.push(shape);
+        return true;
+    }
+
+    bool bounds(float* x, float* y, float* w, float* h, bool tight)
+    {
+        auto ret = path.bounds(x, y, w, h, tight);
 
         //Stroke feathering
         if (stroke) {
@@ -259,7 +554,7 @@ struct Shape::Impl
         if (!stroke) return false;
 
         stroke->width = width;
-        flag |= RenderUpdateFlag::Stroke;
+        mark(RenderUpdateFlag::Stroke);
 
         return true;
     }
@@ -270,7 +565,7 @@ struct Shape::Impl
         if (!stroke) return false;
 
         stroke->cap = cap;
-        flag |= RenderUpdateFlag::Stroke;
+        mark(RenderUpdateFlag::Stroke);
 
         return true;
     }
@@ -281,7 +576,7 @@ struct Shape::Impl
         if (!stroke) return false;
 
         stroke->join = join;
-        flag |= RenderUpdateFlag::Stroke;
+        mark(RenderUpdateFlag::Stroke);
 
         return true;
     }
@@ -296,7 +591,7 @@ struct Shape::Impl
         stroke->color[2] = b;
         stroke->color[3] = a;
 
-        flag |= RenderUpdateFlag::Stroke;
+        mark(RenderUpdateFlag::Stroke);
 
         return true;
     }
@@ -320,7 +615,28 @@ struct Shape::Impl
             stroke->dashPattern[i] = pattern[i];
 
         stroke->dashCnt = cnt;
-        flag |= RenderUpdateFlag::Stroke;
+        mark(RenderUpdateFlag::Stroke);
+
+        return true;
+    }
+
+    bool instance(const Point* offsets, const uint8_t* opacities, uint32_t cnt)
+    {
+        if (cnt == 0) {
+            if (instances) {
+                delete(instances);
+                instances = nullptr;
+                mark(RenderUpdateFlag::Path);
+            }
+            return true;
+        }
+
+        if (!instances) instances = new ShapeInstances();
+        if (!instances) return false;
+
+        if (!instances->set(offsets, opacities, cnt)) return false;
+
+        mark(RenderUpdateFlag::Path);
 
         return true;
     }
@@ -340,7 +656,7 @@ struct Shape::Impl
 
         color[0] = color[1] = color[2] = color[3] = 0;
 
-        flag = RenderUpdateFlag::All;
+        mark(RenderUpdateFlag::All);
     }
 
     Paint* duplicate()
@@ -371,6 +687,9 @@ struct Shape::Impl
             dup->flag |= RenderUpdateFlag::Gradient;
         }
 
+        //Instances
+        if (instances) dup->instances = new ShapeInstances(instances);
+
         return ret.release();
     }
 };
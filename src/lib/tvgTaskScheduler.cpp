@@ -127,8 +127,8 @@ public:
         //Thread Loop
         while (true) {
             auto success = false;
-            for (unsigned i = 0; i < threadCnt * 2; ++i) {
-                if (taskQueues[(i + i) % threadCnt].tryPop(&task)) {
+            for (unsigned n = 0; n < threadCnt * 2; ++n) {
+                if (taskQueues[(i + n) % threadCnt].tryPop(&task)) {
                     success = true;
                     break;
                 }
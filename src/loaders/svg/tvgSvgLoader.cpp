@@ -20,13 +20,21 @@
  * SOFTWARE.
  */
 #include <stddef.h>
-#include <fstream>
+#include <stdio.h>
 #include <string.h>
+#ifndef _WIN32
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+#endif
 #include <float.h>
 #include <math.h>
 #include "tvgLoaderMgr.h"
 #include "tvgXmlParser.h"
 #include "tvgSvgLoader.h"
+#include "tvgSvgUtil.h"
+#include "tvgSvgPath.h"
 
 /************************************************************************/
 /* Internal Class Implementation                                        */
@@ -44,11 +52,11 @@ static char* _skipSpace(const char* str, const char* end)
 }
 
 
-static string* _copyId(const char* str)
+static char* _copyId(SvgLoaderData* loader, const char* str)
 {
     if (str == nullptr) return nullptr;
 
-    return new string(str);
+    return loader->arena.copy(str, strlen(str));
 }
 
 
@@ -64,7 +72,7 @@ static bool _parseNumber(const char** content, float* number)
 {
     char* end = nullptr;
 
-    *number = strtof(*content, &end);
+    *number = svgUtilStrtof(*content, &end);
     //If the start of string is not number
     if ((*content) == end) return false;
     //Skip comma if any
@@ -81,7 +89,7 @@ static bool _parseNumber(const char** content, float* number)
  */
 static float _toFloat(SvgParser* svgParse, const char* str, SvgParserLengthType type)
 {
-    float parsedValue = strtof(str, nullptr);
+    float parsedValue = svgUtilStrtof(str, nullptr);
 
     if (strstr(str, "cm")) parsedValue = parsedValue * 35.43307;
     else if (strstr(str, "mm")) parsedValue = parsedValue * 3.543307;
@@ -110,7 +118,7 @@ static float _gradientToFloat(SvgParser* svgParse, const char* str, SvgParserLen
 {
     char* end = nullptr;
 
-    float parsedValue = strtof(str, &end);
+    float parsedValue = svgUtilStrtof(str, &end);
     float max = 1;
 
     /**
@@ -141,7 +149,7 @@ static float _toOffset(const char* str)
 {
     char* end = nullptr;
 
-    float parsedValue = strtof(str, &end);
+    float parsedValue = svgUtilStrtof(str, &end);
 
     if (strstr(str, "%")) parsedValue = parsedValue / 100.0;
 
@@ -153,7 +161,7 @@ static int _toOpacity(const char* str)
 {
     char* end = nullptr;
     int a = 0;
-    float opacity = strtof(str, &end);
+    float opacity = svgUtilStrtof(str, &end);
 
     if (end && (*end == '\0')) a = lrint(opacity * 255);
     return a;
@@ -163,12 +171,10 @@ static int _toOpacity(const char* str)
 #define _PARSE_TAG(Type, Name, Name1, Tags_Array, Default)                        \
     static Type _to##Name1(const char* str)                                       \
     {                                                                             \
-        unsigned int i;                                                           \
-                                                                                  \
-        for (i = 0; i < sizeof(Tags_Array) / sizeof(Tags_Array[0]); i++) {        \
-            if (!strcmp(str, Tags_Array[i].tag)) return Tags_Array[i].Name;       \
-        }                                                                         \
-        return Default;                                                           \
+        static constexpr auto index = svgUtilKeyIndex(Tags_Array);                \
+        auto i = index.find(str, strlen(str));                                    \
+        if (i < 0) return Default;                                                \
+        return Tags_Array[i].Name;                                                \
     }
 
 
@@ -240,18 +246,15 @@ _parseDashArray(const char *str, SvgDash* dash)
     while (*str) {
         // skip white space, comma
         str = _skipComma(str);
-        (*dash).array.push(strtof(str, &end));
+        (*dash).array.push(svgUtilStrtof(str, &end));
         str = _skipComma(end);
     }
     //If dash array size is 1, it means that dash and gap size are the same.
     if ((*dash).array.count == 1) (*dash).array.push((*dash).array.data[0]);
 }
 
-static string* _idFromUrl(const char* url)
+static char* _idFromUrl(SvgLoaderData* loader, const char* url)
 {
-    char tmp[50];
-    int i = 0;
-
     url = _skipSpace(url, nullptr);
     if ((*url) == '(') {
         ++url;
@@ -260,13 +263,10 @@ static string* _idFromUrl(const char* url)
 
     if ((*url) == '#') ++url;
 
-    while ((*url) != ')') {
-        tmp[i++] = *url;
-        ++url;
-    }
-    tmp[i] = '\0';
+    auto end = url;
+    while ((*end != ')') && (*end != '\0')) ++end;
 
-    return new string(tmp);
+    return loader->arena.copy(url, end - url);
 }
 
 
@@ -274,7 +274,7 @@ static unsigned char _parserColor(const char* value, char** end)
 {
     float r;
 
-    r = strtof(value + 4, end);
+    r = svgUtilStrtof(value + 4, end);
     *end = _skipSpace(*end, nullptr);
     if (**end == '%') r = 255 * r / 100;
     *end = _skipSpace(*end, nullptr);
@@ -443,7 +443,7 @@ static constexpr struct
 };
 
 
-static void _toColor(const char* str, uint8_t* r, uint8_t* g, uint8_t* b, string** ref)
+static void _toColor(SvgLoaderData* loader, const char* str, uint8_t* r, uint8_t* g, uint8_t* b, char** ref)
 {
     unsigned int i, len = strlen(str);
     char *red, *green, *blue;
@@ -490,7 +490,7 @@ static void _toColor(const char* str, uint8_t* r, uint8_t* g, uint8_t* b, string
             }
         }
     } else if (len >= 3 && !strncmp(str, "url", 3)) {
-        *ref = _idFromUrl((const char*)(str + 3));
+        *ref = _idFromUrl(loader, (const char*)(str + 3));
     } else {
         //Handle named color
         for (i = 0; i < (sizeof(colors) / sizeof(colors[0])); i++) {
@@ -511,7 +511,9 @@ static char* _parseNumbersArray(char* str, float* points, int* ptCount)
 
     str = _skipSpace(str, nullptr);
     while (isdigit(*str) || *str == '-' || *str == '+' || *str == '.') {
-        points[count++] = strtof(str, &end);
+        points[count] = svgUtilStrtof(str, &end);
+        if (str == end) break;
+        ++count;
         str = end;
         str = _skipSpace(str, nullptr);
         if (*str == ',') ++str;
@@ -588,14 +590,14 @@ static void _matrixCompose(const Matrix* m1,
 /* parse transform attribute
  * https://www.w3.org/TR/SVG/coords.html#TransformAttribute
  */
-static Matrix* _parseTransformationMatrix(const char* value)
+static Matrix* _parseTransformationMatrix(SvgLoaderData* loader, const char* value)
 {
     unsigned int i;
     float points[8];
     int ptCount = 0;
     float sx, sy;
     MatrixState state = MatrixState::Unknown;
-    Matrix* matrix = (Matrix*)calloc(1, sizeof(Matrix));
+    Matrix* matrix = loader->arena.alloc<Matrix>();
     char* str = (char*)value;
     char* end = str + strlen(str);
 
@@ -710,7 +712,7 @@ static float _parseLength(const char* str, SvgLengthType* type)
     for (i = 0; i < sizeof(lengthTags) / sizeof(lengthTags[0]); i++) {
         if (lengthTags[i].sz - 1 == sz && !strncmp(lengthTags[i].tag, str, sz)) *type = lengthTags[i].type;
     }
-    value = strtof(str, nullptr);
+    value = svgUtilStrtof(str, nullptr);
     return value;
 }
 
@@ -760,7 +762,7 @@ static bool _attrParseSvgNode(void* data, const char* key, const char* value)
 
 
 //https://www.w3.org/TR/SVGTiny12/painting.html#SpecifyingPaint
-static void _handlePaintAttr(SvgPaint* paint, const char* value)
+static void _handlePaintAttr(SvgLoaderData* loader, SvgPaint* paint, const char* value)
 {
     if (!strcmp(value, "none")) {
         //No paint property
@@ -772,30 +774,30 @@ static void _handlePaintAttr(SvgPaint* paint, const char* value)
         paint->curColor = true;
         return;
     }
-    _toColor(value, &paint->r, &paint->g, &paint->b, &paint->url);
+    _toColor(loader, value, &paint->r, &paint->g, &paint->b, &paint->url);
 }
 
 
-static void _handleColorAttr(TVG_UNUSED SvgLoaderData* loader, SvgNode* node, const char* value)
+static void _handleColorAttr(SvgLoaderData* loader, SvgNode* node, const char* value)
 {
     SvgStyleProperty* style = node->style;
-    _toColor(value, &style->r, &style->g, &style->b, nullptr);
+    _toColor(loader, value, &style->r, &style->g, &style->b, nullptr);
 }
 
 
-static void _handleFillAttr(TVG_UNUSED SvgLoaderData* loader, SvgNode* node, const char* value)
+static void _handleFillAttr(SvgLoaderData* loader, SvgNode* node, const char* value)
 {
     SvgStyleProperty* style = node->style;
     style->fill.flags = (SvgFillFlags)((int)style->fill.flags | (int)SvgFillFlags::Paint);
-    _handlePaintAttr(&style->fill.paint, value);
+    _handlePaintAttr(loader, &style->fill.paint, value);
 }
 
 
-static void _handleStrokeAttr(TVG_UNUSED SvgLoaderData* loader, SvgNode* node, const char* value)
+static void _handleStrokeAttr(SvgLoaderData* loader, SvgNode* node, const char* value)
 {
     SvgStyleProperty* style = node->style;
     style->stroke.flags = (SvgStrokeFlags)((int)style->stroke.flags | (int)SvgStrokeFlags::Paint);
-    _handlePaintAttr(&style->stroke.paint, value);
+    _handlePaintAttr(loader, &style->stroke.paint, value);
 }
 
 
@@ -852,18 +854,18 @@ static void _handleFillOpacityAttr(TVG_UNUSED SvgLoaderData* loader, SvgNode* no
 }
 
 
-static void _handleTransformAttr(TVG_UNUSED SvgLoaderData* loader, SvgNode* node, const char* value)
+static void _handleTransformAttr(SvgLoaderData* loader, SvgNode* node, const char* value)
 {
-    node->transform = _parseTransformationMatrix(value);
+    node->transform = _parseTransformationMatrix(loader, value);
 }
 
-static void _handleClipPathAttr(TVG_UNUSED SvgLoaderData* loader, SvgNode* node, const char* value)
+static void _handleClipPathAttr(SvgLoaderData* loader, SvgNode* node, const char* value)
 {
     SvgStyleProperty* style = node->style;
     style->comp.flags = (SvgCompositeFlags)((int)style->comp.flags | (int)SvgCompositeFlags::ClipPath);
 
     int len = strlen(value);
-    if (len >= 3 && !strncmp(value, "url", 3)) style->comp.url = _idFromUrl((const char*)(value + 3));
+    if (len >= 3 && !strncmp(value, "url", 3)) style->comp.url = _idFromUrl(loader, (const char*)(value + 3));
 }
 
 static void _handleDisplayAttr(TVG_UNUSED SvgLoaderData* loader, SvgNode* node, const char* value)
@@ -913,8 +915,7 @@ static bool _parseStyleAttr(void* data, const char* key, const char* value)
 {
     SvgLoaderData* loader = (SvgLoaderData*)data;
     SvgNode* node = loader->svgParse->node;
-    unsigned int i;
-    int sz;
+    static constexpr auto index = svgUtilKeyIndex(styleTags);
     if (!key || !value) return false;
 
     //Trim the white space
@@ -922,15 +923,11 @@ static bool _parseStyleAttr(void* data, const char* key, const char* value)
 
     value = _skipSpace(value, nullptr);
 
-    sz = strlen(key);
-    for (i = 0; i < sizeof(styleTags) / sizeof(styleTags[0]); i++) {
-        if (styleTags[i].sz - 1 == sz && !strncmp(styleTags[i].tag, key, sz)) {
-            styleTags[i].tagHandler(loader, node, value);
-            return true;
-        }
-    }
+    auto i = index.find(key, strlen(key));
+    if (i < 0) return false;
 
-    return false;
+    styleTags[i].tagHandler(loader, node, value);
+    return true;
 }
 
 /* parse g node
@@ -944,9 +941,9 @@ static bool _attrParseGNode(void* data, const char* key, const char* value)
     if (!strcmp(key, "style")) {
         return simpleXmlParseW3CAttribute(value, _parseStyleAttr, loader);
     } else if (!strcmp(key, "transform")) {
-        node->transform = _parseTransformationMatrix(value);
+        node->transform = _parseTransformationMatrix(loader, value);
     } else if (!strcmp(key, "id")) {
-        node->id = _copyId(value);
+        node->id = _copyId(loader, value);
     } else if (!strcmp(key, "clip-path")) {
         _handleClipPathAttr(loader, node, value);
     } else {
@@ -967,28 +964,25 @@ static bool _attrParseClipPathNode(void* data, const char* key, const char* valu
     if (!strcmp(key, "style")) {
         return simpleXmlParseW3CAttribute(value, _parseStyleAttr, loader);
     } else if (!strcmp(key, "transform")) {
-        node->transform = _parseTransformationMatrix(value);
+        node->transform = _parseTransformationMatrix(loader, value);
     } else if (!strcmp(key, "id")) {
-        node->id = _copyId(value);
+        node->id = _copyId(loader, value);
     } else {
         return _parseStyleAttr(loader, key, value);
     }
     return true;
 }
 
-static SvgNode* _createNode(SvgNode* parent, SvgNodeType type)
+static SvgNode* _createNode(SvgLoaderData* loader, SvgNode* parent, SvgNodeType type)
 {
-    SvgNode* node = (SvgNode*)calloc(1, sizeof(SvgNode));
+    SvgNode* node = loader->arena.alloc<SvgNode>();
 
     if (!node) return nullptr;
 
     //Default fill property
-    node->style = (SvgStyleProperty*)calloc(1, sizeof(SvgStyleProperty));
+    node->style = loader->arena.alloc<SvgStyleProperty>();
 
-    if (!node->style) {
-        free(node);
-        return nullptr;
-    }
+    if (!node->style) return nullptr;
 
     //Update the default value of stroke and fill
     //https://www.w3.org/TR/SVGTiny12/painting.html#SpecifyingPaint
@@ -1023,9 +1017,9 @@ static SvgNode* _createNode(SvgNode* parent, SvgNodeType type)
 }
 
 
-static SvgNode* _createDefsNode(TVG_UNUSED SvgLoaderData* loader, TVG_UNUSED SvgNode* parent, const char* buf, unsigned bufLength)
+static SvgNode* _createDefsNode(SvgLoaderData* loader, TVG_UNUSED SvgNode* parent, const char* buf, unsigned bufLength)
 {
-    SvgNode* node = _createNode(nullptr, SvgNodeType::Defs);
+    SvgNode* node = _createNode(loader, nullptr, SvgNodeType::Defs);
     if (!node) return nullptr;
     simpleXmlParseAttributes(buf, bufLength, nullptr, node);
     return node;
@@ -1034,7 +1028,7 @@ static SvgNode* _createDefsNode(TVG_UNUSED SvgLoaderData* loader, TVG_UNUSED Svg
 
 static SvgNode* _createGNode(TVG_UNUSED SvgLoaderData* loader, SvgNode* parent, const char* buf, unsigned bufLength)
 {
-    loader->svgParse->node = _createNode(parent, SvgNodeType::G);
+    loader->svgParse->node = _createNode(loader, parent, SvgNodeType::G);
     if (!loader->svgParse->node) return nullptr;
 
     simpleXmlParseAttributes(buf, bufLength, _attrParseGNode, loader);
@@ -1044,7 +1038,7 @@ static SvgNode* _createGNode(TVG_UNUSED SvgLoaderData* loader, SvgNode* parent,
 
 static SvgNode* _createSvgNode(SvgLoaderData* loader, SvgNode* parent, const char* buf, unsigned bufLength)
 {
-    loader->svgParse->node = _createNode(parent, SvgNodeType::Doc);
+    loader->svgParse->node = _createNode(loader, parent, SvgNodeType::Doc);
     if (!loader->svgParse->node) return nullptr;
     SvgDocNode* doc = &(loader->svgParse->node->node.doc);
 
@@ -1057,7 +1051,7 @@ static SvgNode* _createSvgNode(SvgLoaderData* loader, SvgNode* parent, const cha
 
 static SvgNode* _createMaskNode(SvgLoaderData* loader, SvgNode* parent, const char* buf, unsigned bufLength)
 {
-    loader->svgParse->node = _createNode(parent, SvgNodeType::Unknown);
+    loader->svgParse->node = _createNode(loader, parent, SvgNodeType::Unknown);
     if (!loader->svgParse->node) return nullptr;
 
     loader->svgParse->node->display = false;
@@ -1071,7 +1065,7 @@ static SvgNode* _createMaskNode(SvgLoaderData* loader, SvgNode* parent, const ch
 
 static SvgNode* _createClipPathNode(SvgLoaderData* loader, SvgNode* parent, const char* buf, unsigned bufLength)
 {
-    loader->svgParse->node = _createNode(parent, SvgNodeType::ClipPath);
+    loader->svgParse->node = _createNode(loader, parent, SvgNodeType::ClipPath);
 
     if (!loader->svgParse->node) return nullptr;
 
@@ -1089,14 +1083,17 @@ static bool _attrParsePathNode(void* data, const char* key, const char* value)
     SvgPathNode* path = &(node->node.path);
 
     if (!strcmp(key, "d")) {
-        //Temporary: need to copy
-        path->path = _copyId(value);
+        //Parsed in place, the source text isn't kept.
+        svgPathUnref(path->cmds);
+        svgPathUnref(path->pts);
+        *path = {};
+        svgPathToTvgPath(value, *path);
     } else if (!strcmp(key, "style")) {
         return simpleXmlParseW3CAttribute(value, _parseStyleAttr, loader);
     } else if (!strcmp(key, "clip-path")) {
         _handleClipPathAttr(loader, node, value);
     } else if (!strcmp(key, "id")) {
-        node->id = _copyId(value);
+        node->id = _copyId(loader, value);
     } else {
         return _parseStyleAttr(loader, key, value);
     }
@@ -1106,7 +1103,7 @@ static bool _attrParsePathNode(void* data, const char* key, const char* value)
 
 static SvgNode* _createPathNode(SvgLoaderData* loader, SvgNode* parent, const char* buf, unsigned bufLength)
 {
-    loader->svgParse->node = _createNode(parent, SvgNodeType::Path);
+    loader->svgParse->node = _createNode(loader, parent, SvgNodeType::Path);
 
     if (!loader->svgParse->node) return nullptr;
 
@@ -1137,16 +1134,14 @@ static bool _attrParseCircleNode(void* data, const char* key, const char* value)
     SvgLoaderData* loader = (SvgLoaderData*)data;
     SvgNode* node = loader->svgParse->node;
     SvgCircleNode* circle = &(node->node.circle);
-    unsigned int i;
+    static constexpr auto index = svgUtilKeyIndex(circleTags);
     unsigned char* array;
-    int sz = strlen(key);
+    auto i = index.find(key, strlen(key));
 
     array = (unsigned char*)circle;
-    for (i = 0; i < sizeof(circleTags) / sizeof(circleTags[0]); i++) {
-        if (circleTags[i].sz - 1 == sz && !strncmp(circleTags[i].tag, key, sz)) {
-            *((float*)(array + circleTags[i].offset)) = _toFloat(loader->svgParse, value, circleTags[i].type);
-            return true;
-        }
+    if (i >= 0) {
+        *((float*)(array + circleTags[i].offset)) = _toFloat(loader->svgParse, value, circleTags[i].type);
+        return true;
     }
 
     if (!strcmp(key, "style")) {
@@ -1154,7 +1149,7 @@ static bool _attrParseCircleNode(void* data, const char* key, const char* value)
     } else if (!strcmp(key, "clip-path")) {
         _handleClipPathAttr(loader, node, value);
     } else if (!strcmp(key, "id")) {
-        node->id = _copyId(value);
+        node->id = _copyId(loader, value);
     } else {
         return _parseStyleAttr(loader, key, value);
     }
@@ -1164,7 +1159,7 @@ static bool _attrParseCircleNode(void* data, const char* key, const char* value)
 
 static SvgNode* _createCircleNode(SvgLoaderData* loader, SvgNode* parent, const char* buf, unsigned bufLength)
 {
-    loader->svgParse->node = _createNode(parent, SvgNodeType::Circle);
+    loader->svgParse->node = _createNode(loader, parent, SvgNodeType::Circle);
 
     if (!loader->svgParse->node) return nullptr;
 
@@ -1195,20 +1190,18 @@ static bool _attrParseEllipseNode(void* data, const char* key, const char* value
     SvgLoaderData* loader = (SvgLoaderData*)data;
     SvgNode* node = loader->svgParse->node;
     SvgEllipseNode* ellipse = &(node->node.ellipse);
-    unsigned int i;
+    static constexpr auto index = svgUtilKeyIndex(ellipseTags);
     unsigned char* array;
-    int sz = strlen(key);
+    auto i = index.find(key, strlen(key));
 
     array = (unsigned char*)ellipse;
-    for (i = 0; i < sizeof(ellipseTags) / sizeof(ellipseTags[0]); i++) {
-        if (ellipseTags[i].sz - 1 == sz && !strncmp(ellipseTags[i].tag, key, sz)) {
-            *((float*)(array + ellipseTags[i].offset)) = _toFloat(loader->svgParse, value, ellipseTags[i].type);
-            return true;
-        }
+    if (i >= 0) {
+        *((float*)(array + ellipseTags[i].offset)) = _toFloat(loader->svgParse, value, ellipseTags[i].type);
+        return true;
     }
 
     if (!strcmp(key, "id")) {
-        node->id = _copyId(value);
+        node->id = _copyId(loader, value);
     } else if (!strcmp(key, "style")) {
         return simpleXmlParseW3CAttribute(value, _parseStyleAttr, loader);
     } else if (!strcmp(key, "clip-path")) {
@@ -1222,7 +1215,7 @@ static bool _attrParseEllipseNode(void* data, const char* key, const char* value
 
 static SvgNode* _createEllipseNode(SvgLoaderData* loader, SvgNode* parent, const char* buf, unsigned bufLength)
 {
-    loader->svgParse->node = _createNode(parent, SvgNodeType::Ellipse);
+    loader->svgParse->node = _createNode(loader, parent, SvgNodeType::Ellipse);
 
     if (!loader->svgParse->node) return nullptr;
 
@@ -1287,7 +1280,7 @@ static bool _attrParsePolygonNode(void* data, const char* key, const char* value
     } else if (!strcmp(key, "clip-path")) {
         _handleClipPathAttr(loader, node, value);
     } else if (!strcmp(key, "id")) {
-        node->id = _copyId(value);
+        node->id = _copyId(loader, value);
     } else {
         return _parseStyleAttr(loader, key, value);
     }
@@ -1297,7 +1290,7 @@ static bool _attrParsePolygonNode(void* data, const char* key, const char* value
 
 static SvgNode* _createPolygonNode(SvgLoaderData* loader, SvgNode* parent, const char* buf, unsigned bufLength)
 {
-    loader->svgParse->node = _createNode(parent, SvgNodeType::Polygon);
+    loader->svgParse->node = _createNode(loader, parent, SvgNodeType::Polygon);
 
     if (!loader->svgParse->node) return nullptr;
 
@@ -1308,7 +1301,7 @@ static SvgNode* _createPolygonNode(SvgLoaderData* loader, SvgNode* parent, const
 
 static SvgNode* _createPolylineNode(SvgLoaderData* loader, SvgNode* parent, const char* buf, unsigned bufLength)
 {
-    loader->svgParse->node = _createNode(parent, SvgNodeType::Polyline);
+    loader->svgParse->node = _createNode(loader, parent, SvgNodeType::Polyline);
 
     if (!loader->svgParse->node) return nullptr;
 
@@ -1340,28 +1333,26 @@ static bool _attrParseRectNode(void* data, const char* key, const char* value)
     SvgLoaderData* loader = (SvgLoaderData*)data;
     SvgNode* node = loader->svgParse->node;
     SvgRectNode* rect = &(node->node.rect);
-    unsigned int i;
+    static constexpr auto index = svgUtilKeyIndex(rectTags);
     unsigned char* array;
     bool ret = true;
-    int sz = strlen(key);
+    auto i = index.find(key, strlen(key));
 
     array = (unsigned char*)rect;
-    for (i = 0; i < sizeof(rectTags) / sizeof(rectTags[0]); i++) {
-        if (rectTags[i].sz - 1 == sz && !strncmp(rectTags[i].tag, key, sz)) {
-            *((float*)(array + rectTags[i].offset)) = _toFloat(loader->svgParse, value, rectTags[i].type);
+    if (i >= 0) {
+        *((float*)(array + rectTags[i].offset)) = _toFloat(loader->svgParse, value, rectTags[i].type);
 
-            //Case if only rx or ry is declared
-            if (!strncmp(rectTags[i].tag, "rx", sz)) rect->hasRx = true;
-            if (!strncmp(rectTags[i].tag, "ry", sz)) rect->hasRy = true;
+        //Case if only rx or ry is declared
+        if (rectTags[i].offset == offsetof(SvgRectNode, rx)) rect->hasRx = true;
+        if (rectTags[i].offset == offsetof(SvgRectNode, ry)) rect->hasRy = true;
 
-            if ((rect->rx > FLT_EPSILON) && (rect->ry <= FLT_EPSILON) && rect->hasRx && !rect->hasRy) rect->ry = rect->rx;
-            if ((rect->ry > FLT_EPSILON) && (rect->rx <= FLT_EPSILON) && !rect->hasRx && rect->hasRy) rect->rx = rect->ry;
-            return ret;
-        }
+        if ((rect->rx > FLT_EPSILON) && (rect->ry <= FLT_EPSILON) && rect->hasRx && !rect->hasRy) rect->ry = rect->rx;
+        if ((rect->ry > FLT_EPSILON) && (rect->rx <= FLT_EPSILON) && !rect->hasRx && rect->hasRy) rect->rx = rect->ry;
+        return ret;
     }
 
     if (!strcmp(key, "id")) {
-        node->id = _copyId(value);
+        node->id = _copyId(loader, value);
     } else if (!strcmp(key, "style")) {
         ret = simpleXmlParseW3CAttribute(value, _parseStyleAttr, loader);
     } else if (!strcmp(key, "clip-path")) {
@@ -1376,7 +1367,7 @@ static bool _attrParseRectNode(void* data, const char* key, const char* value)
 
 static SvgNode* _createRectNode(SvgLoaderData* loader, SvgNode* parent, const char* buf, unsigned bufLength)
 {
-    loader->svgParse->node = _createNode(parent, SvgNodeType::Rect);
+    loader->svgParse->node = _createNode(loader, parent, SvgNodeType::Rect);
 
     if (!loader->svgParse->node) return nullptr;
 
@@ -1409,20 +1400,18 @@ static bool _attrParseLineNode(void* data, const char* key, const char* value)
     SvgLoaderData* loader = (SvgLoaderData*)data;
     SvgNode* node = loader->svgParse->node;
     SvgLineNode* line = &(node->node.line);
-    unsigned int i;
+    static constexpr auto index = svgUtilKeyIndex(lineTags);
     unsigned char* array;
-    int sz = strlen(key);
+    auto i = index.find(key, strlen(key));
 
     array = (unsigned char*)line;
-    for (i = 0; i < sizeof(lineTags) / sizeof(lineTags[0]); i++) {
-        if (lineTags[i].sz - 1 == sz && !strncmp(lineTags[i].tag, key, sz)) {
-            *((float*)(array + lineTags[i].offset)) = _toFloat(loader->svgParse, value, lineTags[i].type);
-            return true;
-        }
+    if (i >= 0) {
+        *((float*)(array + lineTags[i].offset)) = _toFloat(loader->svgParse, value, lineTags[i].type);
+        return true;
     }
 
     if (!strcmp(key, "id")) {
-        node->id = _copyId(value);
+        node->id = _copyId(loader, value);
     } else if (!strcmp(key, "style")) {
         return simpleXmlParseW3CAttribute(value, _parseStyleAttr, loader);
     } else if (!strcmp(key, "clip-path")) {
@@ -1436,7 +1425,7 @@ static bool _attrParseLineNode(void* data, const char* key, const char* value)
 
 static SvgNode* _createLineNode(SvgLoaderData* loader, SvgNode* parent, const char* buf, unsigned bufLength)
 {
-    loader->svgParse->node = _createNode(parent, SvgNodeType::Line);
+    loader->svgParse->node = _createNode(loader, parent, SvgNodeType::Line);
 
     if (!loader->svgParse->node) return nullptr;
 
@@ -1445,114 +1434,76 @@ static SvgNode* _createLineNode(SvgLoaderData* loader, SvgNode* parent, const ch
 }
 
 
-static string* _idFromHref(const char* href)
+static char* _idFromHref(SvgLoaderData* loader, const char* href)
 {
     href = _skipSpace(href, nullptr);
     if ((*href) == '#') href++;
-    return new string(href);
+    return _copyId(loader, href);
 }
 
 
-static SvgNode* _getDefsNode(SvgNode* node)
-{
-    if (!node) return nullptr;
-
-    while (node->parent != nullptr) {
-        node = node->parent;
-    }
-
-    if (node->type == SvgNodeType::Doc) return node->node.doc.defs;
-
-    return nullptr;
-}
-
-
-static SvgNode* _findChildById(SvgNode* node, const char* id)
-{
-    if (!node) return nullptr;
-
-    auto child = node->child.data;
-    for (uint32_t i = 0; i < node->child.count; ++i, ++child) {
-        if (((*child)->id != nullptr) && !strcmp((*child)->id->c_str(), id)) return (*child);
-    }
-    return nullptr;
-}
-
-static SvgNode* _findNodeById(SvgNode *node, string* id)
-{
-    SvgNode* result = nullptr;
-    if (node->id && !node->id->compare(*id)) return node;
-
-    if (node->child.count > 0) {
-        auto child = node->child.data;
-        for (uint32_t i = 0; i < node->child.count; ++i, ++child) {
-            result = _findNodeById(*child, id);
-            if (result) break;
-        }
-    }
-    return result;
-}
-
-static void _cloneGradStops(Array<Fill::ColorStop*>* dst, Array<Fill::ColorStop*>* src)
+static void _cloneGradStops(SvgLoaderData* loader, Array<Fill::ColorStop*>* dst, Array<Fill::ColorStop*>* src)
 {
     for (uint32_t i = 0; i < src->count; ++i) {
-        auto stop = static_cast<Fill::ColorStop *>(malloc(sizeof(Fill::ColorStop)));
+        auto stop = loader->arena.alloc<Fill::ColorStop>();
+        if (!stop) return;
         *stop = *src->data[i];
         dst->push(stop);
     }
 }
 
 
-static SvgStyleGradient* _cloneGradient(SvgStyleGradient* from)
+static SvgStyleGradient* _cloneGradient(SvgLoaderData* loader, SvgStyleGradient* from)
 {
     SvgStyleGradient* grad;
 
     if (!from) return nullptr;
 
-    grad = (SvgStyleGradient*)calloc(1, sizeof(SvgStyleGradient));
+    grad = loader->arena.alloc<SvgStyleGradient>();
     if (!grad) return nullptr;
     grad->type = from->type;
-    grad->id = from->id ? _copyId(from->id->c_str()) : nullptr;
-    grad->ref = from->ref ? _copyId(from->ref->c_str()) : nullptr;
+    //The strings live as long as the document, they can be shared.
+    grad->id = from->id;
+    grad->ref = from->ref;
     grad->spread = from->spread;
     grad->usePercentage = from->usePercentage;
     grad->userSpace = from->userSpace;
     if (from->transform) {
-        grad->transform = (Matrix*)calloc(1, sizeof(Matrix));
+        grad->transform = loader->arena.alloc<Matrix>();
         if (grad->transform) memcpy(grad->transform, from->transform, sizeof(Matrix));
     }
     if (grad->type == SvgGradientType::Linear) {
-        grad->linear = (SvgLinearGradient*)calloc(1, sizeof(SvgLinearGradient));
-        if (!grad->linear) goto error_grad_alloc;
+        grad->linear = loader->arena.alloc<SvgLinearGradient>();
+        if (!grad->linear) return nullptr;
         memcpy(grad->linear, from->linear, sizeof(SvgLinearGradient));
     } else if (grad->type == SvgGradientType::Radial) {
-        grad->radial = (SvgRadialGradient*)calloc(1, sizeof(SvgRadialGradient));
-        if (!grad->radial) goto error_grad_alloc;
+        grad->radial = loader->arena.alloc<SvgRadialGradient>();
+        if (!grad->radial) return nullptr;
         memcpy(grad->radial, from->radial, sizeof(SvgRadialGradient));
     }
 
-    _cloneGradStops(&grad->stops, &from->stops);
+    _cloneGradStops(loader, &grad->stops, &from->stops);
     return grad;
-error_grad_alloc:
-    //LOG: allocation failed. out of memory
-    if (grad->transform) free(grad->transform);
-    if (grad->ref) delete grad->ref;
-    if (grad->id) delete grad->id;
-    if (grad) free(grad);
-    return nullptr;
 }
 
 
-static void _copyAttr(SvgNode* to, SvgNode* from)
+static void _copyAttr(SvgLoaderData* loader, SvgNode* to, SvgNode* from)
 {
     //Copy matrix attribute
     if (from->transform) {
-        to->transform = (Matrix*)calloc(1, sizeof(Matrix));
+        to->transform = loader->arena.alloc<Matrix>();
         if (to->transform) memcpy(to->transform, from->transform, sizeof(Matrix));
     }
     //Copy style attribute;
     memcpy(to->style, from->style, sizeof(SvgStyleProperty));
 
+    //The dash array is owned by each style
+    auto& dash = to->style->stroke.dash.array;
+    dash.data = nullptr;
+    dash.count = dash.reserved = 0;
+    auto& fromDash = from->style->stroke.dash.array;
+    for (uint32_t i = 0; i < fromDash.count; ++i) dash.push(fromDash.data[i]);
+
     //Copy node attribute
     switch (from->type) {
         case SvgNodeType::Circle: {
@@ -1587,7 +1538,10 @@ static void _copyAttr(SvgNode* to, SvgNode* from)
             break;
         }
         case SvgNodeType::Path: {
-            to->node.path.path = new string(from->node.path.path->c_str());
+            //Share the path data
+            to->node.path = from->node.path;
+            svgPathRef(to->node.path.cmds);
+            svgPathRef(to->node.path.pts);
             break;
         }
         case SvgNodeType::Polygon: {
@@ -1602,6 +1556,11 @@ static void _copyAttr(SvgNode* to, SvgNode* from)
             memcpy(to->node.polyline.points, from->node.polyline.points, to->node.polyline.pointsCount * sizeof(float));
             break;
         }
+        case SvgNodeType::Use: {
+            to->node.use.symbol = from->node.use.symbol;
+            loader->uses.push(to);
+            break;
+        }
         default: {
             break;
         }
@@ -1609,20 +1568,23 @@ static void _copyAttr(SvgNode* to, SvgNode* from)
 }
 
 
-static void _cloneNode(SvgNode* from, SvgNode* parent)
+static void _cloneNode(SvgLoaderData* loader, SvgNode* from, SvgNode* parent)
 {
     SvgNode* newNode;
     if (!from || !parent) return;
 
-    newNode = _createNode(parent, from->type);
+    newNode = _createNode(loader, parent, from->type);
 
     if (!newNode) return;
 
-    _copyAttr(newNode, from);
+    _copyAttr(loader, newNode, from);
+
+    //The copy of a <use> is instanced on its own
+    if (from->type == SvgNodeType::Use) return;
 
     auto child = from->child.data;
     for (uint32_t i = 0; i < from->child.count; ++i, ++child) {
-        _cloneNode(*child, newNode);
+        _cloneNode(loader, *child, newNode);
     }
 }
 
@@ -1630,15 +1592,17 @@ static void _cloneNode(SvgNode* from, SvgNode* parent)
 static bool _attrParseUseNode(void* data, const char* key, const char* value)
 {
     SvgLoaderData* loader = (SvgLoaderData*)data;
-    SvgNode *defs, *nodeFrom, *node = loader->svgParse->node;
-    string* id;
+    SvgNode *nodeFrom, *node = loader->svgParse->node;
 
     if (!strcmp(key, "xlink:href")) {
-        id = _idFromHref(value);
-        defs = _getDefsNode(node);
-        nodeFrom = _findChildById(defs, id->c_str());
-        _cloneNode(nodeFrom, node);
-        delete id;
+        auto id = _skipSpace(value, nullptr);
+        if (*id == '#') ++id;
+        nodeFrom = loader->nodeIds.find(id);
+        //The ancestors are not completed yet, and would be cloned endlessly.
+        for (auto ancestor = node; nodeFrom && ancestor; ancestor = ancestor->parent) {
+            if (ancestor == nodeFrom) nodeFrom = nullptr;
+        }
+        node->node.use.symbol = nodeFrom;
     } else if (!strcmp(key, "clip-path")) {
         _handleClipPathAttr(loader, node, value);
     } else {
@@ -1650,11 +1614,12 @@ static bool _attrParseUseNode(void* data, const char* key, const char* value)
 
 static SvgNode* _createUseNode(SvgLoaderData* loader, SvgNode* parent, const char* buf, unsigned bufLength)
 {
-    loader->svgParse->node = _createNode(parent, SvgNodeType::G);
+    loader->svgParse->node = _createNode(loader, parent, SvgNodeType::Use);
 
     if (!loader->svgParse->node) return nullptr;
 
     simpleXmlParseAttributes(buf, bufLength, _attrParseUseNode, loader);
+    loader->uses.push(loader->svgParse->node);
     return loader->svgParse->node;
 }
 
@@ -1692,17 +1657,12 @@ static constexpr struct
 
 #define FIND_FACTORY(Short_Name, Tags_Array)                                           \
     static FactoryMethod                                                               \
-        _find##Short_Name##Factory(const char* name)                                   \
+        _find##Short_Name##Factory(const char* name, size_t sz)                        \
     {                                                                                  \
-        unsigned int i;                                                                \
-        int sz = strlen(name);                                                         \
-                                                                                       \
-        for (i = 0; i < sizeof(Tags_Array) / sizeof(Tags_Array[0]); i++) {             \
-            if (Tags_Array[i].sz - 1 == sz && !strncmp(Tags_Array[i].tag, name, sz)) { \
-                return Tags_Array[i].tagHandler;                                       \
-            }                                                                          \
-        }                                                                              \
-        return nullptr;                                                                \
+        static constexpr auto index = svgUtilKeyIndex(Tags_Array);                     \
+        auto i = index.find(name, sz);                                                 \
+        if (i < 0) return nullptr;                                                     \
+        return Tags_Array[i].tagHandler;                                               \
     }
 
 FIND_FACTORY(Group, groupTags)
@@ -1817,22 +1777,20 @@ static bool _attrParseRadialGradientNode(void* data, const char* key, const char
     SvgLoaderData* loader = (SvgLoaderData*)data;
     SvgStyleGradient* grad = loader->svgParse->styleGrad;
     SvgRadialGradient* radial = grad->radial;
-    unsigned int i;
-    int sz = strlen(key);
+    static constexpr auto index = svgUtilKeyIndex(radialTags);
+    auto i = index.find(key, strlen(key));
 
-    for (i = 0; i < sizeof(radialTags) / sizeof(radialTags[0]); i++) {
-        if (radialTags[i].sz - 1 == sz && !strncmp(radialTags[i].tag, key, sz)) {
-            radialTags[i].tagHandler(loader, radial, value);
-            return true;
-        }
+    if (i >= 0) {
+        radialTags[i].tagHandler(loader, radial, value);
+        return true;
     }
 
     if (!strcmp(key, "id")) {
-        grad->id = _copyId(value);
+        grad->id = _copyId(loader, value);
     } else if (!strcmp(key, "spreadMethod")) {
         grad->spread = _parseSpreadValue(value);
     } else if (!strcmp(key, "xlink:href")) {
-        grad->ref = _idFromHref(value);
+        grad->ref = _idFromHref(loader, value);
     } else if (!strcmp(key, "gradientUnits") && !strcmp(value, "userSpaceOnUse")) {
         grad->userSpace = true;
     } else {
@@ -1846,17 +1804,14 @@ static bool _attrParseRadialGradientNode(void* data, const char* key, const char
 static SvgStyleGradient* _createRadialGradient(SvgLoaderData* loader, const char* buf, unsigned bufLength)
 {
     unsigned int i = 0;
-    SvgStyleGradient* grad = (SvgStyleGradient*)calloc(1, sizeof(SvgStyleGradient));
+    SvgStyleGradient* grad = loader->arena.alloc<SvgStyleGradient>();
     if (!grad) return nullptr;
     loader->svgParse->styleGrad = grad;
 
     grad->type = SvgGradientType::Radial;
     grad->userSpace = false;
-    grad->radial = (SvgRadialGradient*)calloc(1, sizeof(SvgRadialGradient));
-    if (!grad->radial) {
-        free(grad);
-        return nullptr;
-    }
+    grad->radial = loader->arena.alloc<SvgRadialGradient>();
+    if (!grad->radial) return nullptr;
     /**
     * Default values of gradient
     */
@@ -1891,7 +1846,7 @@ static bool _attrParseStops(void* data, const char* key, const char* value)
     } else if (!strcmp(key, "stop-opacity")) {
         stop->a = _toOpacity(value);
     } else if (!strcmp(key, "stop-color")) {
-        _toColor(value, &stop->r, &stop->g, &stop->b, nullptr);
+        _toColor(loader, value, &stop->r, &stop->g, &stop->b, nullptr);
     } else if (!strcmp(key, "style")) {
         simpleXmlParseW3CAttribute(value, _attrParseStops, data);
     } else {
@@ -1979,26 +1934,24 @@ static bool _attrParseLinearGradientNode(void* data, const char* key, const char
     SvgLoaderData* loader = (SvgLoaderData*)data;
     SvgStyleGradient* grad = loader->svgParse->styleGrad;
     SvgLinearGradient* linear = grad->linear;
-    unsigned int i;
-    int sz = strlen(key);
+    static constexpr auto index = svgUtilKeyIndex(linear_tags);
+    auto i = index.find(key, strlen(key));
 
-    for (i = 0; i < sizeof(linear_tags) / sizeof(linear_tags[0]); i++) {
-        if (linear_tags[i].sz - 1 == sz && !strncmp(linear_tags[i].tag, key, sz)) {
-            linear_tags[i].tagHandler(loader, linear, value);
-            return true;
-        }
+    if (i >= 0) {
+        linear_tags[i].tagHandler(loader, linear, value);
+        return true;
     }
 
     if (!strcmp(key, "id")) {
-        grad->id = _copyId(value);
+        grad->id = _copyId(loader, value);
     } else if (!strcmp(key, "spreadMethod")) {
         grad->spread = _parseSpreadValue(value);
     } else if (!strcmp(key, "xlink:href")) {
-        grad->ref = _idFromHref(value);
+        grad->ref = _idFromHref(loader, value);
     } else if (!strcmp(key, "gradientUnits") && !strcmp(value, "userSpaceOnUse")) {
         grad->userSpace = true;
     } else if (!strcmp(key, "gradientTransform")) {
-        grad->transform = _parseTransformationMatrix(value);
+        grad->transform = _parseTransformationMatrix(loader, value);
     } else {
         return false;
     }
@@ -2009,18 +1962,15 @@ static bool _attrParseLinearGradientNode(void* data, const char* key, const char
 
 static SvgStyleGradient* _createLinearGradient(SvgLoaderData* loader, const char* buf, unsigned bufLength)
 {
-    SvgStyleGradient* grad = (SvgStyleGradient*)calloc(1, sizeof(SvgStyleGradient));
+    SvgStyleGradient* grad = loader->arena.alloc<SvgStyleGradient>();
     if (!grad) return nullptr;
     loader->svgParse->styleGrad = grad;
     unsigned int i;
 
     grad->type = SvgGradientType::Linear;
     grad->userSpace = false;
-    grad->linear = (SvgLinearGradient*)calloc(1, sizeof(SvgLinearGradient));
-    if (!grad->linear) {
-        free(grad);
-        return nullptr;
-    }
+    grad->linear = loader->arena.alloc<SvgLinearGradient>();
+    if (!grad->linear) return nullptr;
     /**
     * Default value of x2 is 100%
     */
@@ -2060,17 +2010,12 @@ static constexpr struct
 };
 
 
-static GradientFactoryMethod _findGradientFactory(const char* name)
+static GradientFactoryMethod _findGradientFactory(const char* name, size_t sz)
 {
-    unsigned int i;
-    int sz = strlen(name);
-
-    for (i = 0; i < sizeof(gradientTags) / sizeof(gradientTags[0]); i++) {
-        if (gradientTags[i].sz - 1 == sz && !strncmp(gradientTags[i].tag, name, sz)) {
-            return gradientTags[i].tagHandler;
-        }
-    }
-    return nullptr;
+    static constexpr auto index = svgUtilKeyIndex(gradientTags);
+    auto i = index.find(name, sz);
+    if (i < 0) return nullptr;
+    return gradientTags[i].tagHandler;
 }
 
 
@@ -2087,18 +2032,17 @@ static constexpr struct
 };
 
 
-static void _svgLoaderParerXmlClose(SvgLoaderData* loader, const char* content)
+static void _svgLoaderParerXmlClose(SvgLoaderData* loader, const char* content, unsigned int length)
 {
-    unsigned int i;
+    static constexpr auto index = svgUtilKeyIndex(popArray);
+    auto end = content + length;
 
-    content = _skipSpace(content, nullptr);
+    content = _skipSpace(content, end);
 
-    for (i = 0; i < sizeof(popArray) / sizeof(popArray[0]); i++) {
-        if (!strncmp(content, popArray[i].tag, popArray[i].sz - 1)) {
-            loader->stack.pop();
-            break;
-        }
-    }
+    auto name = content;
+    while ((name < end) && !isspace(*name)) ++name;
+
+    if (index.find(content, name - content) >= 0) loader->stack.pop();
 
     loader->level--;
 }
@@ -2109,7 +2053,7 @@ static void _svgLoaderParserXmlOpen(SvgLoaderData* loader, const char* content,
     const char* attrs = nullptr;
     int attrsLength = 0;
     int sz = length;
-    char tagName[20] = "";
+    const char* tagName = content;
     FactoryMethod method;
     GradientFactoryMethod gradientMethod;
     SvgNode *node = nullptr, *parent = nullptr;
@@ -2127,24 +2071,26 @@ static void _svgLoaderParserXmlOpen(SvgLoaderData* loader, const char* content,
         sz = attrs - content;
         attrsLength = length - sz;
         while ((sz > 0) && (isspace(content[sz - 1]))) sz--;
-        if ((uint)sz >= sizeof(tagName)) return;
-        strncpy(tagName, content, sz);
-        tagName[sz] = '\0';
     }
 
-    if ((method = _findGroupFactory(tagName))) {
+    auto isSvg = (sz == sizeof("svg") - 1) && !strncmp(tagName, "svg", sz);
+
+    if ((method = _findGroupFactory(tagName, sz))) {
         //Group
         if (!loader->doc) {
-            if (strcmp(tagName, "svg")) return; //Not a valid svg document
+            if (!isSvg) return; //Not a valid svg document
             node = method(loader, nullptr, attrs, attrsLength);
             loader->doc = node;
         } else {
-            if (!strcmp(tagName, "svg")) return; //Already loadded <svg>(SvgNodeType::Doc) tag
+            if (isSvg) return; //Already loadded <svg>(SvgNodeType::Doc) tag
             if (loader->stack.count > 0) parent = loader->stack.data[loader->stack.count - 1];
             else parent = loader->doc;
             node = method(loader, parent, attrs, attrsLength);
         }
 
+        if (!node) return;
+        loader->nodeIds.insert(node->id, node);
+
         if (node->type == SvgNodeType::Defs) {
             loader->doc->node.doc.defs = node;
             loader->def = node;
@@ -2152,13 +2098,15 @@ static void _svgLoaderParserXmlOpen(SvgLoaderData* loader, const char* content,
         } else {
             loader->stack.push(node);
         }
-    } else if ((method = _findGraphicsFactory(tagName))) {
+    } else if ((method = _findGraphicsFactory(tagName, sz))) {
         if (loader->stack.count > 0) parent = loader->stack.data[loader->stack.count - 1];
         else parent = loader->doc;
         node = method(loader, parent, attrs, attrsLength);
-    } else if ((gradientMethod = _findGradientFactory(tagName))) {
+        if (node) loader->nodeIds.insert(node->id, node);
+    } else if ((gradientMethod = _findGradientFactory(tagName, sz))) {
         SvgStyleGradient* gradient;
         gradient = gradientMethod(loader, attrs, attrsLength);
+        if (gradient) loader->gradientIds.insert(gradient->id, gradient);
         //FIXME: The current parsing structure does not distinguish end tags.
         //       There is no way to know if the currently parsed gradient is in defs.
         //       If a gradient is declared outside of defs after defs is set, it is included in the gradients of defs.
@@ -2171,8 +2119,8 @@ static void _svgLoaderParserXmlOpen(SvgLoaderData* loader, const char* content,
             loader->gradients.push(gradient);
         }
         loader->latestGradient = gradient;
-    } else if (!strcmp(tagName, "stop")) {
-        auto stop = static_cast<Fill::ColorStop*>(calloc(1, sizeof(Fill::ColorStop)));
+    } else if ((sz == sizeof("stop") - 1) && !strncmp(tagName, "stop", sz)) {
+        auto stop = loader->arena.alloc<Fill::ColorStop>();
         if (!stop) return;
         loader->svgParse->gradStop = stop;
         /* default value for opacity */
@@ -2184,7 +2132,7 @@ static void _svgLoaderParserXmlOpen(SvgLoaderData* loader, const char* content,
     }
 #ifdef THORVG_LOG_ENABLED
     else {
-        printf("SVG: Unsupported elements used [Elements: %s]\n", tagName);
+        printf("SVG: Unsupported elements used [Elements: %.*s]\n", sz, tagName);
     }
 #endif
 }
@@ -2204,7 +2152,7 @@ static bool _svgLoaderParser(void* data, SimpleXMLType type, const char* content
             break;
         }
         case SimpleXMLType::Close: {
-            _svgLoaderParerXmlClose(loader, content);
+            _svgLoaderParerXmlClose(loader, content, length);
             break;
         }
         case SimpleXMLType::Data:
@@ -2237,7 +2185,7 @@ static void _styleInherit(SvgStyleProperty* child, SvgStyleProperty* parent)
         child->fill.paint.b = parent->fill.paint.b;
         child->fill.paint.none = parent->fill.paint.none;
         child->fill.paint.curColor = parent->fill.paint.curColor;
-        if (parent->fill.paint.url) child->fill.paint.url = _copyId(parent->fill.paint.url->c_str());
+        child->fill.paint.url = parent->fill.paint.url;
     }
     if (!((int)child->fill.flags & (int)SvgFillFlags::Opacity)) {
         child->fill.opacity = parent->fill.opacity;
@@ -2252,7 +2200,7 @@ static void _styleInherit(SvgStyleProperty* child, SvgStyleProperty* parent)
         child->stroke.paint.b = parent->stroke.paint.b;
         child->stroke.paint.none = parent->stroke.paint.none;
         child->stroke.paint.curColor = parent->stroke.paint.curColor;
-        child->stroke.paint.url = parent->stroke.paint.url ? _copyId(parent->stroke.paint.url->c_str()) : nullptr;
+        child->stroke.paint.url = parent->stroke.paint.url;
     }
     if (!((int)child->stroke.flags & (int)SvgStrokeFlags::Opacity)) {
         child->stroke.opacity = parent->stroke.opacity;
@@ -2261,8 +2209,8 @@ static void _styleInherit(SvgStyleProperty* child, SvgStyleProperty* parent)
         child->stroke.width = parent->stroke.width;
     }
     if (!((int)child->stroke.flags & (int)SvgStrokeFlags::Dash)) {
+        child->stroke.dash.array.clear();
         if (parent->stroke.dash.array.count > 0) {
-            child->stroke.dash.array.clear();
             child->stroke.dash.array.reserve(parent->stroke.dash.array.count);
             for (uint32_t i = 0; i < parent->stroke.dash.array.count; ++i) {
                 child->stroke.dash.array.push(parent->stroke.dash.array.data[i]);
@@ -2286,7 +2234,7 @@ static void _inefficientNodeCheck(SvgNode* node){
 
     switch (node->type) {
         case SvgNodeType::Path: {
-            if (!node->node.path.path || node->node.path.path->empty()) printf("SVG: Inefficient elements used [Empty path][Node Type : %s]\n", simpleXmlNodeTypeToString(node->type).c_str());
+            if (node->node.path.cmdsCnt == 0) printf("SVG: Inefficient elements used [Empty path][Node Type : %s]\n", simpleXmlNodeTypeToString(node->type).c_str());
             break;
         }
         case SvgNodeType::Ellipse: {
@@ -2329,84 +2277,114 @@ static void _updateStyle(SvgNode* node, SvgStyleProperty* parentStyle)
 }
 
 
-static SvgStyleGradient* _gradientDup(Array<SvgStyleGradient*>* gradients, string* id)
+static bool _samePaint(const SvgPaint& lhs, const SvgPaint& rhs)
 {
-    SvgStyleGradient* result = nullptr;
+    if (lhs.none != rhs.none || lhs.curColor != rhs.curColor) return false;
+    if (lhs.r != rhs.r || lhs.g != rhs.g || lhs.b != rhs.b) return false;
+    if (!lhs.url || !rhs.url) return lhs.url == rhs.url;
+    return !strcmp(lhs.url, rhs.url);
+}
 
-    auto gradList = gradients->data;
 
-    for (uint32_t i = 0; i < gradients->count; ++i) {
-        if (!((*gradList)->id->compare(*id))) {
-            result = _cloneGradient(*gradList);
-            break;
+//Compare what _styleInherit() passes down
+static bool _sameInheritance(const SvgStyleProperty* lhs, const SvgStyleProperty* rhs)
+{
+    if (!_samePaint(lhs->fill.paint, rhs->fill.paint) || !_samePaint(lhs->stroke.paint, rhs->stroke.paint)) return false;
+    if (lhs->fill.opacity != rhs->fill.opacity || lhs->fill.fillRule != rhs->fill.fillRule) return false;
+    if (lhs->stroke.opacity != rhs->stroke.opacity || lhs->stroke.width != rhs->stroke.width) return false;
+    if (lhs->stroke.cap != rhs->stroke.cap || lhs->stroke.join != rhs->stroke.join) return false;
+
+    auto& ldash = lhs->stroke.dash.array;
+    auto& rdash = rhs->stroke.dash.array;
+    if (ldash.count != rdash.count) return false;
+    return (ldash.count == 0) || !memcmp(ldash.data, rdash.data, sizeof(float) * ldash.count);
+}
+
+
+/* Give every <use> the subtree it refers to. The ones with the same symbol and the same
+ * inherited style share a single copy, which is built once by the scene builder.
+ * The copies may have <use> inside, they are appended to the list and visited as well.
+ * Gradients and composites are resolved in the document tree only,
+ * so the copies under <defs> are never shared with the document. */
+static void _updateUse(SvgLoaderData* loader)
+{
+    for (uint32_t i = 0; i < loader->uses.count; ++i) {
+        auto node = loader->uses.data[i];
+        auto symbol = node->node.use.symbol;
+        if (!symbol) continue;
+
+        auto root = node;
+        while (root->parent) root = root->parent;
+        node->node.use.defs = (root != loader->doc);
+
+        auto source = symbol->uses;
+        while (source && (source->node.use.defs != node->node.use.defs || !_sameInheritance(source->style, node->style))) {
+            source = source->node.use.next;
         }
-        ++gradList;
-    }
 
-    if (result && result->ref) {
-        gradList = gradients->data;
-        for (uint32_t i = 0; i < gradients->count; ++i) {
-            if (!((*gradList)->id->compare(*result->ref))) {
-                if (result->stops.count > 0) {
-                    _cloneGradStops(&result->stops, &(*gradList)->stops);
-                }
-                //TODO: Properly inherit other property
-                break;
+        if (!source) {
+            source = node;
+            node->node.use.next = symbol->uses;
+            symbol->uses = node;
+            _cloneNode(loader, symbol, node);
+            auto child = node->child.data;
+            for (uint32_t j = 0; j < node->child.count; ++j, ++child) {
+                _updateStyle(*child, node->style);
             }
-            ++gradList;
         }
+        node->node.use.source = source;
+    }
+}
+
+
+static SvgStyleGradient* _gradientDup(SvgLoaderData* loader, const char* id)
+{
+    auto result = _cloneGradient(loader, loader->gradientIds.find(id));
+
+    if (result && result->ref) {
+        auto ref = loader->gradientIds.find(result->ref);
+        if (ref && result->stops.count > 0) _cloneGradStops(loader, &result->stops, &ref->stops);
+        //TODO: Properly inherit other property
     }
 
     return result;
 }
 
 
-static void _updateGradient(SvgNode* node, Array<SvgStyleGradient*>* gradidents)
+static void _updateGradient(SvgLoaderData* loader, SvgNode* node)
 {
     if (node->child.count > 0) {
         auto child = node->child.data;
         for (uint32_t i = 0; i < node->child.count; ++i, ++child) {
-            _updateGradient(*child, gradidents);
+            _updateGradient(loader, *child);
         }
-    } else {
+    } else if (node->type != SvgNodeType::Use) {
         if (node->style->fill.paint.url) {
-            node->style->fill.paint.gradient = _gradientDup(gradidents, node->style->fill.paint.url);
+            node->style->fill.paint.gradient = _gradientDup(loader, node->style->fill.paint.url);
         } else if (node->style->stroke.paint.url) {
-            //node->style->stroke.paint.gradient = _gradientDup(gradList, node->style->stroke.paint.url);
+            //node->style->stroke.paint.gradient = _gradientDup(loader, node->style->stroke.paint.url);
         }
     }
 }
 
-static void _updateComposite(SvgNode* node, SvgNode* root)
+static void _updateComposite(SvgNode* node, const SvgIdIndex<SvgNode>& nodes)
 {
     if (node->style->comp.url && !node->style->comp.node) {
-        SvgNode *findResult = _findNodeById(root, node->style->comp.url);
-        if (findResult) node->style->comp.node = findResult;
+        node->style->comp.node = nodes.find(node->style->comp.url);
     }
     if (node->child.count > 0) {
         auto child = node->child.data;
         for (uint32_t i = 0; i < node->child.count; ++i, ++child) {
-            _updateComposite(*child, root);
+            _updateComposite(*child, nodes);
         }
     }
 }
 
+//The nodes live in the arena, only their arrays and the shared path data are released here.
 static void _freeGradientStyle(SvgStyleGradient* grad)
 {
     if (!grad) return;
-
-    delete grad->id;
-    delete grad->ref;
-    free(grad->radial);
-    free(grad->linear);
-    if (grad->transform) free(grad->transform);
-
-    for (uint32_t i = 0; i < grad->stops.count; ++i) {
-        auto colorStop = grad->stops.data[i];
-        free(colorStop);
-    }
     grad->stops.reset();
-    free(grad);
 }
 
 static void _freeNodeStyle(SvgStyleProperty* style)
@@ -2414,11 +2392,8 @@ static void _freeNodeStyle(SvgStyleProperty* style)
     if (!style) return;
 
     _freeGradientStyle(style->fill.paint.gradient);
-    delete style->fill.paint.url;
     _freeGradientStyle(style->stroke.paint.gradient);
-    if (style->stroke.dash.array.count > 0) style->stroke.dash.array.reset();
-    delete style->stroke.paint.url;
-    free(style);
+    style->stroke.dash.array.reset();
 }
 
 static void _freeNode(SvgNode* node)
@@ -2431,12 +2406,11 @@ static void _freeNode(SvgNode* node)
     }
     node->child.reset();
 
-    delete node->id;
-    free(node->transform);
     _freeNodeStyle(node->style);
     switch (node->type) {
          case SvgNodeType::Path: {
-             delete node->node.path.path;
+             svgPathUnref(node->node.path.cmds);
+             svgPathUnref(node->node.path.pts);
              break;
          }
          case SvgNodeType::Polygon: {
@@ -2464,7 +2438,29 @@ static void _freeNode(SvgNode* node)
              break;
          }
     }
-    free(node);
+}
+
+
+//Discards the whole document at once
+static void _freeDocument(SvgLoaderData* loader)
+{
+    auto gradients = loader->gradients.data;
+    for (size_t i = 0; i < loader->gradients.count; ++i) {
+        _freeGradientStyle(*gradients);
+        ++gradients;
+    }
+    loader->gradients.reset();
+    loader->gradientIds.reset();
+    loader->nodeIds.reset();
+    loader->uses.reset();
+
+    _freeNode(loader->doc);
+    loader->doc = nullptr;
+    loader->def = nullptr;
+    loader->latestGradient = nullptr;
+    loader->stack.reset();
+
+    loader->arena.reset();
 }
 
 
@@ -2472,7 +2468,7 @@ static bool _svgLoaderParserForValidCheckXmlOpen(SvgLoaderData* loader, const ch
 {
     const char* attrs = nullptr;
     int sz = length;
-    char tagName[20] = "";
+    const char* tagName = content;
     FactoryMethod method;
     SvgNode *node = nullptr;
     int attrsLength = 0;
@@ -2489,14 +2485,11 @@ static bool _svgLoaderParserForValidCheckXmlOpen(SvgLoaderData* loader, const ch
         sz = attrs - content;
         attrsLength = length - sz;
         while ((sz > 0) && (isspace(content[sz - 1]))) sz--;
-        if ((uint)sz >= sizeof(tagName)) return false;
-        strncpy(tagName, content, sz);
-        tagName[sz] = '\0';
     }
 
-    if ((method = _findGroupFactory(tagName))) {
+    if ((method = _findGroupFactory(tagName, sz))) {
         if (!loader->doc) {
-            if (strcmp(tagName, "svg")) return true; //Not a valid svg document
+            if ((sz != sizeof("svg") - 1) || strncmp(tagName, "svg", sz)) return true; //Not a valid svg document
             node = method(loader, nullptr, attrs, attrsLength);
             loader->doc = node;
             loader->stack.push(node);
@@ -2532,6 +2525,110 @@ static bool _svgLoaderParserForValidCheck(void* data, SimpleXMLType type, const
 /* External Class Implementation                                        */
 /************************************************************************/
 
+bool SvgLoader::load(const string& path)
+{
+    unload();
+
+#ifndef _WIN32
+    //Parse the file in place, no copy of the contents.
+    auto fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        //LOG: Failed to open file
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0 && static_cast<uint64_t>(info.st_size) <= UINT32_MAX) {
+        auto addr = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr != MAP_FAILED) {
+            file = static_cast<char*>(addr);
+            fileSize = info.st_size;
+            fileMapped = true;
+        }
+    }
+    if (fileMapped) {
+        ::close(fd);
+        return true;
+    }
+    //Not mappable (pipes, etc), read the whole contents instead.
+    auto fp = fdopen(fd, "rb");
+    if (!fp) {
+        ::close(fd);
+        return false;
+    }
+#else
+    auto fp = fopen(path.c_str(), "rb");
+    if (!fp) {
+        //LOG: Failed to open file
+        return false;
+    }
+#endif
+
+    size_t reserved = 0;
+    while (true) {
+        if (fileSize == reserved) {
+            reserved = reserved > 0 ? reserved * 2 : 65536;
+            auto tmp = static_cast<char*>(realloc(file, reserved));
+            if (!tmp) break;
+            file = tmp;
+        }
+        auto len = fread(file + fileSize, 1, reserved - fileSize, fp);
+        if (len == 0) break;
+        fileSize += len;
+    }
+    auto success = !ferror(fp) && feof(fp) && fileSize > 0 && fileSize <= UINT32_MAX;
+    fclose(fp);
+
+    if (!success) unload();
+    return success;
+}
+
+
+bool SvgLoader::append(const char* data, uint32_t size)
+{
+    auto needed = pendingSize + size;
+    if (needed < pendingSize) return false;
+
+    if (needed > pendingReserved) {
+        auto reserved = pendingReserved > 0 ? pendingReserved : 4096;
+        while (reserved < needed) reserved = (reserved > UINT32_MAX / 2) ? needed : reserved * 2;
+        auto tmp = static_cast<char*>(realloc(pending, reserved));
+        if (!tmp) return false;
+        pending = tmp;
+        pendingReserved = reserved;
+    }
+    memcpy(pending + pendingSize, data, size);
+    pendingSize += size;
+
+    return true;
+}
+
+
+void SvgLoader::unload()
+{
+    //Don't leave the parser pointing to the released contents.
+    if (content && (content == file || content == pending)) {
+        content = nullptr;
+        size = 0;
+    }
+
+    free(pending);
+    pending = nullptr;
+    pendingSize = pendingReserved = 0;
+
+    if (!file) return;
+
+#ifndef _WIN32
+    if (fileMapped) munmap(file, fileSize);
+    else
+#endif
+    free(file);
+
+    file = nullptr;
+    fileSize = 0;
+    fileMapped = false;
+}
+
+
 SvgLoader::SvgLoader()
 {
 }
@@ -2545,19 +2642,20 @@ SvgLoader::~SvgLoader()
 
 void SvgLoader::run(unsigned tid)
 {
-    if (!simpleXmlParse(content, size, true, _svgLoaderParser, &(loaderData))) return;
+    //The fed contents are parsed already, but the last part
+    if (size > 0 && !simpleXmlParse(content, size, true, _svgLoaderParser, &(loaderData))) return;
 
     if (loaderData.doc) {
         _updateStyle(loaderData.doc, nullptr);
-        auto defs = loaderData.doc->node.doc.defs;
-        if (defs) _updateGradient(loaderData.doc, &defs->node.defs.gradients);
-
-        if (loaderData.gradients.count > 0) _updateGradient(loaderData.doc, &loaderData.gradients);
-
-        _updateComposite(loaderData.doc, loaderData.doc);
-        if (defs) _updateComposite(loaderData.doc, defs);
+        _updateUse(&loaderData);
+        if (loaderData.gradientIds.count > 0) _updateGradient(&loaderData, loaderData.doc);
+        _updateComposite(loaderData.doc, loaderData.nodeIds);
     }
     root = builder.build(loaderData.doc);
+
+    //The document is built, neither the source nor the nodes are referred anymore.
+    unload();
+    _freeDocument(&loaderData);
 };
 
 
@@ -2571,6 +2669,12 @@ bool SvgLoader::header()
 
     simpleXmlParse(content, size, true, _svgLoaderParserForValidCheck, &(loaderData));
 
+    return docInfo();
+}
+
+
+bool SvgLoader::docInfo()
+{
     if (loaderData.doc && loaderData.doc->type == SvgNodeType::Doc) {
         //Return the brief resource info such as viewbox:
         vx = loaderData.doc->node.doc.vx;
@@ -2603,30 +2707,62 @@ bool SvgLoader::open(const char* data, uint32_t size)
 
 bool SvgLoader::open(const string& path)
 {
-    ifstream f;
-    f.open(path);
+    if (!load(path)) return false;
 
-    if (!f.is_open())
-    {
-        //LOG: Failed to open file
-        return false;
-    } else {
-        getline(f, filePath, '\0');
-        f.close();
+    this->content = file;
+    this->size = fileSize;
 
-        if (filePath.empty()) return false;
+    return header();
+}
 
-        this->content = filePath.c_str();
-        this->size = filePath.size();
+
+bool SvgLoader::feed(const char* data, uint32_t size)
+{
+    if (failed) return false;
+
+    //The first part of the contents
+    if (!streaming) {
+        loaderData.svgParse = (SvgParser*)malloc(sizeof(SvgParser));
+        if (!loaderData.svgParse) return false;
+        streaming = true;
     }
 
-    return header();
+    //No token is completed without '<' or '>'
+    if (pendingSize > 0 && !memchr(data, '<', size) && !memchr(data, '>', size)) return append(data, size);
+
+    //Parse the part in place, unless a token is left behind
+    if (pendingSize > 0) {
+        if (!append(data, size)) return false;
+        data = pending;
+        size = pendingSize;
+    }
+
+    unsigned parsed = 0;
+    if (!simpleXmlParseChunk(data, size, true, _svgLoaderParser, &(loaderData), &parsed)) {
+        failed = true;
+        return false;
+    }
+
+    //Keep the incomplete token for the next
+    auto left = size - parsed;
+    if (data == pending) {
+        memmove(pending, pending + parsed, left);
+        pendingSize = left;
+        return true;
+    }
+    return append(data + parsed, left);
 }
 
 
 bool SvgLoader::read()
 {
-    if (!content || size == 0) return false;
+    if (streaming) {
+        //The last part is parsed on the task
+        streaming = false;
+        if (failed || !docInfo()) return false;
+        content = pending;
+        size = pendingSize;
+    } else if (!content || size == 0) return false;
 
     TaskScheduler::request(this);
 
@@ -2637,21 +2773,17 @@ bool SvgLoader::read()
 bool SvgLoader::close()
 {
     this->done();
+    builder.done();
+
+    unload();
 
     if (loaderData.svgParse) {
         free(loaderData.svgParse);
         loaderData.svgParse = nullptr;
     }
-    auto gradients = loaderData.gradients.data;
-    for (size_t i = 0; i < loaderData.gradients.count; ++i) {
-        _freeGradientStyle(*gradients);
-        ++gradients;
-    }
-    loaderData.gradients.reset();
+    _freeDocument(&loaderData);
 
-    _freeNode(loaderData.doc);
-    loaderData.doc = nullptr;
-    loaderData.stack.reset();
+    streaming = failed = false;
 
     return true;
 }
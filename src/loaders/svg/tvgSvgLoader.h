@@ -28,7 +28,6 @@
 class SvgLoader : public Loader, public Task
 {
 public:
-    string filePath;
     const char* content = nullptr;
     uint32_t size = 0;
 
@@ -42,6 +41,7 @@ public:
     using Loader::open;
     bool open(const string& path) override;
     bool open(const char* data, uint32_t size) override;
+    bool feed(const char* data, uint32_t size) override;
 
     bool header();
     bool read() override;
@@ -49,6 +49,22 @@ public:
     void run(unsigned tid) override;
 
     unique_ptr<Scene> scene() override;
+
+private:
+    char* file = nullptr;           //contents of the opened file, mapped or copied
+    size_t fileSize = 0;
+    bool fileMapped = false;
+
+    char* pending = nullptr;        //fed contents waiting for the rest of the token
+    uint32_t pendingSize = 0;
+    uint32_t pendingReserved = 0;
+    bool streaming = false;         //the contents come in parts through feed()
+    bool failed = false;            //the fed contents couldn't be parsed
+
+    bool load(const string& path);
+    bool append(const char* data, uint32_t size);
+    bool docInfo();
+    void unload();
 };
 
 
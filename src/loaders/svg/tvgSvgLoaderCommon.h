@@ -22,6 +22,7 @@
 #ifndef _TVG_SVG_LOADER_COMMON_H_
 #define _TVG_SVG_LOADER_COMMON_H_
 
+#include <string.h>
 #include "tvgCommon.h"
 #include "tvgArray.h"
 
@@ -189,7 +190,21 @@ struct SvgLineNode
 
 struct SvgPathNode
 {
-    string* path;
+    PathCommand* cmds;      //reference counted, see svgPathRef()
+    uint32_t cmdsCnt;
+    Point* pts;
+    uint32_t ptsCnt;
+};
+
+//Instances of the same symbol under the same inherited style share one copy of it,
+//which is held by the first of them (the source) and built once.
+struct SvgUseNode
+{
+    SvgNode* symbol;        //referred node
+    SvgNode* source;        //<use> holding the copy of the symbol
+    SvgNode* next;          //next source of the same symbol
+    Paint* paint;           //built copy, placed in the scene tree
+    bool defs;              //under <defs>, not a part of the document tree
 };
 
 struct SvgPolygonNode
@@ -227,14 +242,14 @@ struct SvgGradientStop
 struct SvgComposite
 {
     SvgCompositeFlags flags;
-    string *url;
+    char* url;
     SvgNode* node;
 };
 
 struct SvgPaint
 {
     SvgStyleGradient* gradient;
-    string *url;
+    char* url;
     uint8_t r;
     uint8_t g;
     uint8_t b;
@@ -250,8 +265,8 @@ struct SvgDash
 struct SvgStyleGradient
 {
     SvgGradientType type;
-    string *id;
-    string *ref;
+    char* id;
+    char* ref;
     FillSpread spread;
     SvgRadialGradient* radial;
     SvgLinearGradient* linear;
@@ -299,9 +314,10 @@ struct SvgNode
     SvgNodeType type;
     SvgNode* parent;
     Array<SvgNode*> child;
-    string *id;
+    char* id;
     SvgStyleProperty *style;
     Matrix* transform;
+    SvgNode* uses;          //first <use> source of this node
     union {
         SvgGNode g;
         SvgDocNode doc;
@@ -314,6 +330,7 @@ struct SvgNode
         SvgRectNode rect;
         SvgPathNode path;
         SvgLineNode line;
+        SvgUseNode use;
     } node;
     bool display;
 };
@@ -335,13 +352,171 @@ struct SvgParser
     } gradient;
 };
 
+//Hash table of the element ids, the first one in the document order is kept.
+template<class T>
+struct SvgIdIndex
+{
+    struct Slot
+    {
+        const char* id;
+        uint32_t hash;
+        T* item;
+    };
+
+    Slot* slots = nullptr;
+    uint32_t count = 0;
+    uint32_t reserved = 0;          //power of 2
+
+    static uint32_t hash(const char* id)
+    {
+        uint32_t h = 2166136261u;   //FNV-1a
+        for (; *id; ++id) h = (h ^ static_cast<uint8_t>(*id)) * 16777619u;
+        return h;
+    }
+
+    void insert(const char* id, T* item)
+    {
+        if (!id || !item) return;
+
+        //Keep the load under a half
+        if ((count + 1) * 2 > reserved) {
+            auto old = slots;
+            auto oldReserved = reserved;
+            reserved = reserved > 0 ? reserved * 2 : 64;
+            slots = static_cast<Slot*>(calloc(reserved, sizeof(Slot)));
+            if (!slots) {
+                slots = old;
+                reserved = oldReserved;
+                return;
+            }
+            for (auto slot = old; slot < old + oldReserved; ++slot) {
+                if (slot->id) _place(*slot);
+            }
+            free(old);
+        }
+
+        auto h = hash(id);
+        for (auto i = h & (reserved - 1); slots[i].id; i = (i + 1) & (reserved - 1)) {
+            if (slots[i].hash == h && !strcmp(slots[i].id, id)) return;
+        }
+        _place({id, h, item});
+        ++count;
+    }
+
+    T* find(const char* id) const
+    {
+        if (!id || count == 0) return nullptr;
+
+        auto h = hash(id);
+        for (auto i = h & (reserved - 1); slots[i].id; i = (i + 1) & (reserved - 1)) {
+            if (slots[i].hash == h && !strcmp(slots[i].id, id)) return slots[i].item;
+        }
+        return nullptr;
+    }
+
+    void reset()
+    {
+        free(slots);
+        slots = nullptr;
+        count = reserved = 0;
+    }
+
+    ~SvgIdIndex()
+    {
+        free(slots);
+    }
+
+private:
+    void _place(const Slot& slot)
+    {
+        auto i = slot.hash & (reserved - 1);
+        while (slots[i].id) i = (i + 1) & (reserved - 1);
+        slots[i] = slot;
+    }
+};
+
+//Bump allocator of the document. Nodes, styles, gradients and strings are carved out
+//of zeroed blocks and all of them are released at once when the document is discarded.
+struct SvgArena
+{
+    static constexpr size_t BLOCK = 64 * 1024;
+    static constexpr size_t ALIGN = 16;
+
+    struct Block
+    {
+        Block* prev;
+    };
+
+    Block* blocks = nullptr;
+    char* cur = nullptr;
+    char* end = nullptr;
+
+    //Zero filled memory
+    void* alloc(size_t size)
+    {
+        size = (size + ALIGN - 1) & ~(ALIGN - 1);
+
+        if (size > static_cast<size_t>(end - cur)) {
+            //Large requests get their own block, the current block keeps serving the small ones.
+            auto dedicated = size > BLOCK / 4;
+            auto block = static_cast<Block*>(calloc(1, ALIGN + (dedicated ? size : size_t(BLOCK))));
+            if (!block) return nullptr;
+            auto data = reinterpret_cast<char*>(block) + ALIGN;
+            if (dedicated && blocks) {
+                block->prev = blocks->prev;
+                blocks->prev = block;
+                return data;
+            }
+            block->prev = blocks;
+            blocks = block;
+            cur = data;
+            end = dedicated ? data + size : data + BLOCK;
+        }
+        auto ret = cur;
+        cur += size;
+        return ret;
+    }
+
+    template<class T>
+    T* alloc()
+    {
+        return static_cast<T*>(alloc(sizeof(T)));
+    }
+
+    char* copy(const char* str, size_t len)
+    {
+        auto ret = static_cast<char*>(alloc(len + 1));
+        if (ret) memcpy(ret, str, len);
+        return ret;
+    }
+
+    void reset()
+    {
+        while (blocks) {
+            auto prev = blocks->prev;
+            free(blocks);
+            blocks = prev;
+        }
+        cur = end = nullptr;
+    }
+
+    ~SvgArena()
+    {
+        reset();
+    }
+};
+
 struct SvgLoaderData
 {
     Array<SvgNode *> stack = {nullptr, 0, 0};
     SvgNode* doc = nullptr;
     SvgNode* def = nullptr;
     Array<SvgStyleGradient*> gradients;
+    SvgIdIndex<SvgNode> nodeIds;                //referred by url(#id) and xlink:href
+    SvgIdIndex<SvgStyleGradient> gradientIds;
     SvgStyleGradient* latestGradient = nullptr; //For stops
+    Array<SvgNode*> uses;                       //<use> nodes in the document order
+    SvgArena arena;                             //Storage of the document nodes
     SvgParser* svgParse = nullptr;
     int level = 0;
     bool result = false;
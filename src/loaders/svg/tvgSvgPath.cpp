@@ -22,8 +22,66 @@
 #include <string.h>
 #include <math.h>
 #include <ctype.h>
-#include <locale.h>
+#include <atomic>
 #include "tvgSvgPath.h"
+#include "tvgSvgUtil.h"
+
+/************************************************************************/
+/* Internal Class Implementation                                        */
+/************************************************************************/
+
+//The reference count of the path data is placed in front of it, so the deleter of the shapes can find it.
+#define SVG_PATH_HEADER 16
+
+static atomic<uint32_t>* _refCnt(void* data)
+{
+    return reinterpret_cast<atomic<uint32_t>*>(static_cast<char*>(data) - SVG_PATH_HEADER);
+}
+
+
+template<class T>
+struct SvgPathArray
+{
+    T* data = nullptr;
+    uint32_t count = 0;
+    uint32_t reserved = 0;
+    bool failed = false;    //out of memory, the parsing stops
+
+    void push(T element)
+    {
+        if (count + 1 > reserved && !reserve((count + 1) * 2)) return;
+        data[count++] = element;
+    }
+
+    bool reserve(uint32_t size)
+    {
+        if (size <= reserved) return true;
+        auto header = static_cast<char*>(realloc(data ? _refCnt(data) : nullptr, SVG_PATH_HEADER + sizeof(T) * size));
+        if (!header) {
+            failed = true;
+            return false;
+        }
+        if (!data) new (header) atomic<uint32_t>(1);
+        data = reinterpret_cast<T*>(header + SVG_PATH_HEADER);
+        reserved = size;
+        return true;
+    }
+
+    //Give the data away, the reference is taken over.
+    T* release()
+    {
+        auto ret = data;
+        data = nullptr;
+        count = reserved = 0;
+        return ret;
+    }
+
+    ~SvgPathArray()
+    {
+        if (data) svgPathUnref(data);
+    }
+};
+
 
 static char* _skipComma(const char* content)
 {
@@ -38,7 +96,7 @@ static char* _skipComma(const char* content)
 static bool _parseNumber(char** content, float* number)
 {
     char* end = NULL;
-    *number = strtof(*content, &end);
+    *number = svgUtilStrtof(*content, &end);
     //If the start of string is not number
     if ((*content) == end) return false;
     //Skip comma if any
@@ -47,19 +105,16 @@ static bool _parseNumber(char** content, float* number)
 }
 
 
+//The flags are single digits, they can be written without separators. ie) "a1 1 0 00 1 1"
 static bool _parseFlag(char** content, int* number)
 {
-    char* end = NULL;
-    *number = strtol(*content, &end, 10);
-    //If the start of string is not number or a number was a float
-    if ((*content) == end || *end == '.') return false;
-    //If a flag has a different value than 0 or 1
-    if (*number != 0 && *number != 1) return false;
-    *content = _skipComma(end);
+    if ((**content) != '0' && (**content) != '1') return false;
+    *number = (**content) - '0';
+    *content = _skipComma(*content + 1);
     return true;
 }
 
-void _pathAppendArcTo(Array<PathCommand>* cmds, Array<Point>* pts, Point* cur, Point* curCtl, float x, float y, float rx, float ry, float angle, bool largeArc, bool sweep)
+static void _pathAppendArcTo(SvgPathArray<PathCommand>* cmds, SvgPathArray<Point>* pts, Point* cur, Point* curCtl, float x, float y, float rx, float ry, float angle, bool largeArc, bool sweep)
 {
     float cxp, cyp, cx, cy;
     float sx, sy;
@@ -283,7 +338,7 @@ static int _numberCount(char cmd)
 }
 
 
-static void _processCommand(Array<PathCommand>* cmds, Array<Point>* pts, char cmd, float* arr, int count, Point* cur, Point* curCtl, Point* startPoint, bool *isQuadratic)
+static void _processCommand(SvgPathArray<PathCommand>* cmds, SvgPathArray<Point>* pts, char cmd, float* arr, int count, Point* cur, Point* curCtl, Point* startPoint, bool *isQuadratic)
 {
     int i;
     switch (cmd) {
@@ -499,7 +554,11 @@ static char* _nextCommand(char* path, char* cmd, float* arr, int* count)
 }
 
 
-bool svgPathToTvgPath(const char* svgPath, Array<PathCommand>& cmds, Array<Point>& pts)
+/************************************************************************/
+/* External Class Implementation                                        */
+/************************************************************************/
+
+bool svgPathToTvgPath(const char* svgPath, SvgPathNode& path)
 {
     float numberArray[7];
     int numberCount = 0;
@@ -508,21 +567,45 @@ bool svgPathToTvgPath(const char* svgPath, Array<PathCommand>& cmds, Array<Point
     Point startPoint = { 0, 0 };
     char cmd = 0;
     bool isQuadratic = false;
-    char* path = (char*)svgPath;
-    char* curLocale;
-
-    curLocale = setlocale(LC_NUMERIC, NULL);
-    if (curLocale) curLocale = strdup(curLocale);
-    setlocale(LC_NUMERIC, "POSIX");
-
-    while ((path[0] != '\0')) {
-        path = _nextCommand(path, &cmd, numberArray, &numberCount);
-        if (!path) break;
+    char* ptr = (char*)svgPath;
+    SvgPathArray<PathCommand> cmds;
+    SvgPathArray<Point> pts;
+
+    //Rough estimation, about 10 characters for a point and 2.5 points for a command.
+    auto len = strlen(svgPath);
+    if (len == 0) return false;
+    if (!pts.reserve(len / 10 + 4) || !cmds.reserve(len / 25 + 4)) return false;
+
+    while ((ptr[0] != '\0')) {
+        ptr = _nextCommand(ptr, &cmd, numberArray, &numberCount);
+        if (!ptr) break;
         _processCommand(&cmds, &pts, cmd, numberArray, numberCount, &cur, &curCtl, &startPoint, &isQuadratic);
+        if (cmds.failed || pts.failed) return false;
     }
 
-    setlocale(LC_NUMERIC, curLocale);
-    if (curLocale) free(curLocale);
+    if (cmds.count == 0 || pts.count == 0) return false;
+
+    path.cmdsCnt = cmds.count;
+    path.cmds = cmds.release();
+    path.ptsCnt = pts.count;
+    path.pts = pts.release();
 
     return true;
 }
+
+
+void svgPathRef(void* data)
+{
+    if (data) _refCnt(data)->fetch_add(1);
+}
+
+
+void svgPathUnref(void* data)
+{
+    if (!data) return;
+    auto refCnt = _refCnt(data);
+    if (refCnt->fetch_sub(1) == 1) {
+        refCnt->~atomic<uint32_t>();
+        free(refCnt);
+    }
+}
@@ -25,6 +25,10 @@
 
 #include "tvgSvgLoaderCommon.h"
 
-bool svgPathToTvgPath(const char* svgPath, Array<PathCommand>& cmds, Array<Point>& pts);
+bool svgPathToTvgPath(const char* svgPath, SvgPathNode& path);
+
+//The path data is shared by the nodes and the shapes, svgPathUnref() is the deleter for the shapes.
+void svgPathRef(void* data);
+void svgPathUnref(void* data);
 
 #endif //_TVG_SVG_PATH_H_
@@ -24,11 +24,15 @@
 #include "tvgSvgSceneBuilder.h"
 #include "tvgSvgPath.h"
 
+//Subtrees smaller than this are not worth a job, nor the documents smaller than SVG_BUILD_MIN.
+#define SVG_BUILD_GRAIN_MIN 32
+#define SVG_BUILD_MIN 1024
+
 bool _appendShape(SvgNode* node, Shape* shape, float vx, float vy, float vw, float vh);
 
 bool _isGroupType(SvgNodeType type)
 {
-    if (type == SvgNodeType::Doc || type == SvgNodeType::G || type == SvgNodeType::ClipPath) return true;
+    if (type == SvgNodeType::Doc || type == SvgNodeType::G || type == SvgNodeType::Use || type == SvgNodeType::ClipPath) return true;
     return false;
 }
 
@@ -41,11 +45,14 @@ unique_ptr<LinearGradient> _applyLinearGradientProperty(SvgStyleGradient* g, Sha
 
     auto fillGrad = LinearGradient::gen();
 
+    //The gradient can be shared by the shapes in build, don't modify it.
+    auto linear = *g->linear;
+
     if (g->usePercentage) {
-        g->linear->x1 = g->linear->x1 * rw + rx;
-        g->linear->y1 = g->linear->y1 * rh + ry;
-        g->linear->x2 = g->linear->x2 * rw + rx;
-        g->linear->y2 = g->linear->y2 * rh + ry;
+        linear.x1 = linear.x1 * rw + rx;
+        linear.y1 = linear.y1 * rh + ry;
+        linear.x2 = linear.x2 * rw + rx;
+        linear.y2 = linear.y2 * rh + ry;
     }
 
     //In case of objectBoundingBox it need proper scaling
@@ -70,10 +77,10 @@ unique_ptr<LinearGradient> _applyLinearGradientProperty(SvgStyleGradient* g, Sha
         float cx_scaled = (((float)gw) * 0.5) * scaleReversedX;
 
         //= T(gx, gy) x S(scaleX, scaleY) x T(cx_scaled - cx, cy_scaled - cy) x (radial->x, radial->y)
-        g->linear->x1 = g->linear->x1 * scaleX + scaleX * (cx_scaled - cx) + gx;
-        g->linear->y1 = g->linear->y1 * scaleY + scaleY * (cy_scaled - cy) + gy;
-        g->linear->x2 = g->linear->x2 * scaleX + scaleX * (cx_scaled - cx) + gx;
-        g->linear->y2 = g->linear->y2 * scaleY + scaleY * (cy_scaled - cy) + gy;
+        linear.x1 = linear.x1 * scaleX + scaleX * (cx_scaled - cx) + gx;
+        linear.y1 = linear.y1 * scaleY + scaleY * (cy_scaled - cy) + gy;
+        linear.x2 = linear.x2 * scaleX + scaleX * (cx_scaled - cx) + gx;
+        linear.y2 = linear.y2 * scaleY + scaleY * (cy_scaled - cy) + gy;
     }
 
     if (g->transform) {
@@ -82,15 +89,15 @@ unique_ptr<LinearGradient> _applyLinearGradientProperty(SvgStyleGradient* g, Sha
 
          //= T(x - cx, y - cy) x g->transform x T(cx, cy)
          //Calc start point
-         g->linear->x1 = (g->transform->e11 * cx) + (g->transform->e12 * cy) + g->linear->x1 + g->transform->e13 - cx;
-         g->linear->y1 = (g->transform->e21 * cx) + (g->transform->e22 * cy) + g->linear->y1 + g->transform->e23 - cy;
+         linear.x1 = (g->transform->e11 * cx) + (g->transform->e12 * cy) + linear.x1 + g->transform->e13 - cx;
+         linear.y1 = (g->transform->e21 * cx) + (g->transform->e22 * cy) + linear.y1 + g->transform->e23 - cy;
 
          //Calc end point
-         g->linear->x2 = (g->transform->e11 * cx) + (g->transform->e12 * cy) + g->linear->x2 + g->transform->e13 - cx;
-         g->linear->y2 = (g->transform->e21 * cx) + (g->transform->e22 * cy) + g->linear->y2 + g->transform->e23 - cy;
+         linear.x2 = (g->transform->e11 * cx) + (g->transform->e12 * cy) + linear.x2 + g->transform->e13 - cx;
+         linear.y2 = (g->transform->e21 * cx) + (g->transform->e22 * cy) + linear.y2 + g->transform->e23 - cy;
     }
 
-    fillGrad->linear(g->linear->x1, g->linear->y1, g->linear->x2, g->linear->y2);
+    fillGrad->linear(linear.x1, linear.y1, linear.x2, linear.y2);
     fillGrad->spread(g->spread);
 
     //Update the stops
@@ -124,6 +131,9 @@ unique_ptr<RadialGradient> _applyRadialGradientProperty(SvgStyleGradient* g, Sha
 
     auto fillGrad = RadialGradient::gen();
 
+    //The gradient can be shared by the shapes in build, don't modify it.
+    auto radial = *g->radial;
+
     radius = sqrt(pow(rw, 2) + pow(rh, 2)) / sqrt(2.0);
     if (!g->userSpace) {
          //That is according to Units in here
@@ -133,11 +143,11 @@ unique_ptr<RadialGradient> _applyRadialGradientProperty(SvgStyleGradient* g, Sha
     }
 
     if (g->usePercentage) {
-        g->radial->cx = g->radial->cx * rw + rx;
-        g->radial->cy = g->radial->cy * rh + ry;
-        g->radial->r = g->radial->r * radius;
-        g->radial->fx = g->radial->fx * rw + rx;
-        g->radial->fy = g->radial->fy * rh + ry;
+        radial.cx = radial.cx * rw + rx;
+        radial.cy = radial.cy * rh + ry;
+        radial.r = radial.r * radius;
+        radial.fx = radial.fx * rw + rx;
+        radial.fy = radial.fy * rh + ry;
     }
 
     //In case of objectBoundingBox it need proper scaling
@@ -162,8 +172,8 @@ unique_ptr<RadialGradient> _applyRadialGradientProperty(SvgStyleGradient* g, Sha
         float cx_scaled = (((float)gw) * 0.5) * scaleReversedX;
 
          //= T(gx, gy) x S(scaleX, scaleY) x T(cx_scaled - cx, cy_scaled - cy) x (radial->x, radial->y)
-        g->radial->cx = g->radial->cx * scaleX + scaleX * (cx_scaled - cx) + gx;
-        g->radial->cy = g->radial->cy * scaleY + scaleY * (cy_scaled - cy) + gy;
+        radial.cx = radial.cx * scaleX + scaleX * (cx_scaled - cx) + gx;
+        radial.cy = radial.cy * scaleY + scaleY * (cy_scaled - cy) + gy;
     }
 
     //TODO: Radial gradient transformation is not yet supported.
@@ -173,7 +183,7 @@ unique_ptr<RadialGradient> _applyRadialGradientProperty(SvgStyleGradient* g, Sha
     //if (g->radial->fx != 0 && g->radial->fy != 0) {
     //    fillGrad->radial(g->radial->fx, g->radial->fy, g->radial->r);
     //}
-    fillGrad->radial(g->radial->cx, g->radial->cy, g->radial->r);
+    fillGrad->radial(radial.cx, radial.cy, radial.r);
     fillGrad->spread(g->spread);
 
     //Update the stops
@@ -199,6 +209,10 @@ unique_ptr<RadialGradient> _applyRadialGradientProperty(SvgStyleGradient* g, Sha
 void _appendChildShape(SvgNode* node, Shape* shape, float vx, float vy, float vw, float vh)
 {
     _appendShape(node, shape, vx, vy, vw, vh);
+
+    //A <use> sharing the copy of another one has no children of its own
+    if (node->type == SvgNodeType::Use && node->node.use.source) node = node->node.use.source;
+
     if (node->child.count > 0) {
         auto child = node->child.data;
         for (uint32_t i = 0; i < node->child.count; ++i, ++child) _appendChildShape(*child, shape, vx, vy, vw, vh);
@@ -285,14 +299,14 @@ unique_ptr<Shape> _shapeBuildHelper(SvgNode* node, float vx, float vy, float vw,
 
 bool _appendShape(SvgNode* node, Shape* shape, float vx, float vy, float vw, float vh)
 {
-    Array<PathCommand> cmds;
-    Array<Point> pts;
-
     switch (node->type) {
         case SvgNodeType::Path: {
-            if (node->node.path.path) {
-                if (svgPathToTvgPath(node->node.path.path->c_str(), cmds, pts))
-                    shape->appendPath(cmds.data, cmds.count, pts.data, pts.count);
+            //The shape takes a reference of the parsed points, no copies.
+            auto& path = node->node.path;
+            if (path.cmdsCnt > 0) {
+                svgPathRef(path.cmds);
+                svgPathRef(path.pts);
+                shape->appendPath(path.cmds, path.cmdsCnt, path.pts, path.ptsCnt, svgPathUnref);
             }
             break;
         }
@@ -339,21 +353,81 @@ bool _appendShape(SvgNode* node, Shape* shape, float vx, float vy, float vw, flo
     return true;
 }
 
-unique_ptr<Scene> _sceneBuildHelper(SvgNode* node, float vx, float vy, float vw, float vh)
+//The jobs are met in the same order as collected.
+struct SvgBuildCursor
+{
+    SvgBuildJob* job;
+    SvgBuildJob* end;
+};
+
+
+static SvgBuildJob* _takeJob(SvgNode* node, SvgBuildCursor* cursor)
+{
+    if (!cursor || cursor->job == cursor->end || cursor->job->node != node) return nullptr;
+    return cursor->job++;
+}
+
+
+static uint32_t _countNodes(SvgNode* node)
+{
+    uint32_t cnt = 1;
+    auto child = node->child.data;
+    for (uint32_t i = 0; i < node->child.count; ++i, ++child) cnt += _countNodes(*child);
+    return cnt;
+}
+
+
+//Split the visible group subtrees down to the grain size, in the document order.
+static void _collectJobs(SvgNode* node, uint32_t grain, Array<SvgBuildJob>& jobs)
+{
+    if (!node->display || node->style->opacity == 0) return;
+
+    auto child = node->child.data;
+    for (uint32_t i = 0; i < node->child.count; ++i, ++child) {
+        //The instances are shared, see SvgSceneBuilder::instance()
+        if (!_isGroupType((*child)->type) || (*child)->type == SvgNodeType::Use) continue;
+        auto cnt = _countNodes(*child);
+        if (cnt > grain) _collectJobs(*child, grain, jobs);
+        else if (cnt >= SVG_BUILD_GRAIN_MIN) jobs.push({*child, nullptr});
+    }
+}
+
+
+unique_ptr<Scene> _sceneBuildHelper(SvgSceneBuilder* builder, SvgNode* node, float vx, float vy, float vw, float vh, SvgBuildCursor* cursor);
+
+
+void _appendChildren(SvgSceneBuilder* builder, SvgNode* node, Scene* scene, float vx, float vy, float vw, float vh, SvgBuildCursor* cursor)
+{
+    auto child = node->child.data;
+    for (uint32_t i = 0; i < node->child.count; ++i, ++child) {
+        if (_isGroupType((*child)->type)) {
+            auto job = _takeJob(*child, cursor);
+            if (job) {
+                scene->push(unique_ptr<Scene>(job->scene));
+                job->scene = nullptr;
+            } else {
+                scene->push(_sceneBuildHelper(builder, *child, vx, vy, vw, vh, cursor));
+            }
+        } else {
+            auto shape = _shapeBuildHelper(*child, vx, vy, vw, vh);
+            if (shape) scene->push(move(shape));
+        }
+    }
+}
+
+
+unique_ptr<Scene> _sceneBuildHelper(SvgSceneBuilder* builder, SvgNode* node, float vx, float vy, float vw, float vh, SvgBuildCursor* cursor)
 {
     if (_isGroupType(node->type)) {
         auto scene = Scene::gen();
         if (node->transform) scene->transform(*node->transform);
 
         if (node->display && node->style->opacity != 0) {
-            auto child = node->child.data;
-            for (uint32_t i = 0; i < node->child.count; ++i, ++child) {
-                if (_isGroupType((*child)->type)) {
-                    scene->push(_sceneBuildHelper(*child, vx, vy, vw, vh));
-                } else {
-                    auto shape = _shapeBuildHelper(*child, vx, vy, vw, vh);
-                    if (shape) scene->push(move(shape));
-                }
+            if (node->type == SvgNodeType::Use) {
+                auto instance = builder->instance(node->node.use.source);
+                if (instance) scene->push(move(instance));
+            } else {
+                _appendChildren(builder, node, scene.get(), vx, vy, vw, vh, cursor);
             }
             //Apply composite node
             if (node->style->comp.node) {
@@ -376,6 +450,30 @@ unique_ptr<Scene> _sceneBuildHelper(SvgNode* node, float vx, float vy, float vw,
 }
 
 
+void SvgBuildTask::run(unsigned tid)
+{
+    builder->work();
+}
+
+
+void SvgSceneBuilder::work()
+{
+    while (true) {
+        auto i = next++;
+        if (i >= jobs.count) return;
+
+        auto job = &jobs.data[i];
+        job->scene = _sceneBuildHelper(this, job->node, vx, vy, vw, vh, nullptr).release();
+
+        {
+            lock_guard<mutex> lock(mtx);
+            ++finished;
+        }
+        cv.notify_one();
+    }
+}
+
+
 SvgSceneBuilder::SvgSceneBuilder()
 {
 }
@@ -383,6 +481,7 @@ SvgSceneBuilder::SvgSceneBuilder()
 
 SvgSceneBuilder::~SvgSceneBuilder()
 {
+    done();
 }
 
 
@@ -390,5 +489,81 @@ unique_ptr<Scene> SvgSceneBuilder::build(SvgNode* node)
 {
     if (!node || (node->type != SvgNodeType::Doc)) return nullptr;
 
-    return _sceneBuildHelper(node, node->node.doc.vx, node->node.doc.vy, node->node.doc.vw, node->node.doc.vh);
+    vx = node->node.doc.vx;
+    vy = node->node.doc.vy;
+    vw = node->node.doc.vw;
+    vh = node->node.doc.vh;
+
+    //Build the large subtrees in parallel, then put them together in order.
+    auto threads = TaskScheduler::threads();
+    if (threads > 1 && !tasks) {
+        auto total = _countNodes(node);
+        auto grain = total / (threads * 4);
+        if (grain < SVG_BUILD_GRAIN_MIN) grain = SVG_BUILD_GRAIN_MIN;
+        if (total >= SVG_BUILD_MIN) _collectJobs(node, grain, jobs);
+    }
+
+    if (jobs.count > 1) {
+        //This thread takes the jobs as well.
+        taskCnt = jobs.count < threads ? jobs.count - 1 : threads - 1;
+        tasks = new SvgBuildTask[taskCnt];
+        for (uint32_t i = 0; i < taskCnt; ++i) {
+            tasks[i].builder = this;
+            TaskScheduler::request(&tasks[i]);
+        }
+        work();
+
+        //Only the jobs taken by the others, don't wait for the tasks not started yet.
+        unique_lock<mutex> lock(mtx);
+        while (finished < jobs.count) cv.wait(lock);
+    } else {
+        jobs.clear();
+    }
+
+    SvgBuildCursor cursor = {jobs.data, jobs.data + jobs.count};
+    auto scene = _sceneBuildHelper(this, node, vx, vy, vw, vh, &cursor);
+
+    //Not in the tree
+    for (auto job = jobs.data; job < jobs.data + jobs.count; ++job) {
+        if (job->scene) delete(job->scene);
+        job->scene = nullptr;
+    }
+
+    return scene;
+}
+
+
+//The first <use> of the source takes the built copy, the others get duplicates of it sharing the geometry.
+//It's built by the first one asking for it, on whichever thread.
+unique_ptr<Paint> SvgSceneBuilder::instance(SvgNode* source)
+{
+    if (!source) return nullptr;
+
+    unique_lock<mutex> lock(mtx);
+    if (!source->node.use.paint) {
+        lock.unlock();
+        auto content = Scene::gen();
+        _appendChildren(this, source, content.get(), vx, vy, vw, vh, nullptr);
+        lock.lock();
+        if (!source->node.use.paint) {
+            source->node.use.paint = content.get();
+            return content;
+        }
+    }
+
+    //The shared path data is reference counted, keep duplicate() serialized.
+    return unique_ptr<Paint>(source->node.use.paint->duplicate());
+}
+
+
+//Wait for the tasks requested by build(), they refer this builder.
+void SvgSceneBuilder::done()
+{
+    if (!tasks) return;
+
+    for (uint32_t i = 0; i < taskCnt; ++i) tasks[i].done();
+    delete[] tasks;
+    tasks = nullptr;
+    taskCnt = 0;
+    jobs.reset();
 }
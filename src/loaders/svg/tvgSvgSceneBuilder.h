@@ -23,8 +23,26 @@
 #ifndef _TVG_SVG_SCENE_BUILDER_H_
 #define _TVG_SVG_SCENE_BUILDER_H_
 
+#include <atomic>
+#include "tvgTaskScheduler.h"
 #include "tvgSvgLoaderCommon.h"
 
+class SvgSceneBuilder;
+
+//A large group subtree, built on the worker threads.
+struct SvgBuildJob
+{
+    SvgNode* node;
+    Scene* scene;
+};
+
+struct SvgBuildTask : Task
+{
+    SvgSceneBuilder* builder = nullptr;
+
+    void run(unsigned tid) override;
+};
+
 class SvgSceneBuilder
 {
 public:
@@ -32,6 +50,22 @@ public:
     ~SvgSceneBuilder();
 
     unique_ptr<Scene> build(SvgNode* node);
+    unique_ptr<Paint> instance(SvgNode* source);
+    void done();
+
+private:
+    Array<SvgBuildJob> jobs;
+    atomic<uint32_t> next{0};           //next job to take
+    uint32_t finished = 0;              //jobs built so far
+    mutex mtx;
+    condition_variable cv;
+    SvgBuildTask* tasks = nullptr;
+    uint32_t taskCnt = 0;
+    float vx = 0, vy = 0, vw = 0, vh = 0;
+
+    void work();
+
+    friend struct SvgBuildTask;
 };
 
 #endif //_TVG_SVG_SCENE_BUILDER_H_
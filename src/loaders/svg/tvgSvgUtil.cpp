@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) 2020 Samsung Electronics Co., Ltd. All rights reserved.
+
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <ctype.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "tvgSvgUtil.h"
+
+/************************************************************************/
+/* Internal Class Implementation                                        */
+/************************************************************************/
+
+#define MAX_FAST_INTEGER 9007199254740992ull  //2^53
+#define MAX_FAST_FRACTION 12
+#define MAX_DIGITS 120
+
+//Powers of ten, all exact in double.
+static constexpr double pow10Tbl[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+
+/* Exact conversion of the rare numbers the fast path can't take.
+   The digits are written without the decimal point, so strtof()
+   reads them the same in any locale. */
+static float _slowStrtof(bool negative, const char* digits, const char* end, int32_t exponent)
+{
+    char buf[MAX_DIGITS + 16];
+    auto p = buf;
+    auto cnt = 0;
+    auto sticky = false;
+
+    if (negative) *p++ = '-';
+
+    for (auto s = digits; s < end; ++s) {
+        if (*s == '.') continue;
+        if (cnt < MAX_DIGITS) {
+            *p++ = *s;
+            ++cnt;
+        } else {
+            //The dropped digits only matter as a tie breaker.
+            if (*s != '0') sticky = true;
+            ++exponent;
+        }
+    }
+    if (sticky) {
+        *p++ = '1';
+        --exponent;
+    }
+
+    *p++ = 'e';
+    if (exponent < 0) {
+        *p++ = '-';
+        exponent = -exponent;
+    }
+    char tmp[12];
+    auto len = 0;
+    do {
+        tmp[len++] = '0' + (exponent % 10);
+        exponent /= 10;
+    } while (exponent > 0);
+    while (len > 0) *p++ = tmp[--len];
+    *p = '\0';
+
+    return strtof(buf, nullptr);
+}
+
+
+/************************************************************************/
+/* External Class Implementation                                        */
+/************************************************************************/
+
+/* The significant digits are accumulated as an integer and scaled once by an
+   exact power of ten. A single double rounding of an exact integer and power
+   is correctly rounded, and the second rounding to float can't hit a tie with
+   integers under 2^53 or 12 fraction digits at most, so the result is the same as
+   strtof(). Anything else takes the exact, slow way. */
+float svgUtilStrtof(const char* nPtr, char** endPtr)
+{
+    auto s = nPtr;
+    while (isspace(*s)) ++s;
+
+    auto negative = false;
+    if (*s == '-') {
+        negative = true;
+        ++s;
+    } else if (*s == '+') {
+        ++s;
+    }
+
+    //Significant digits
+    uint64_t mantissa = 0;
+    int32_t digitCnt = 0;
+    int32_t scale = 0;                  //decimal exponent of the digits
+    const char* digits = nullptr;       //first significant digit
+    const char* digitsEnd = nullptr;
+
+    auto start = s;
+    auto dot = false;
+    for (; ; ++s) {
+        if (*s == '.' && !dot) {
+            dot = true;
+            continue;
+        }
+        if (!isdigit(*s)) break;
+        if (dot) --scale;
+        if (*s == '0' && digitCnt == 0) continue;
+        if (!digits) digits = s;
+        if (digitCnt < 19) mantissa = mantissa * 10 + (*s - '0');
+        digitsEnd = s + 1;
+        ++digitCnt;
+    }
+
+    //No digits at all, no conversion.
+    if (s == start || (s - start == 1 && dot)) {
+        if (endPtr) *endPtr = (char*)nPtr;
+        return 0.0f;
+    }
+
+    //Exponent, only if it has digits.
+    if (*s == 'e' || *s == 'E') {
+        auto e = s + 1;
+        auto eNegative = false;
+        if (*e == '-') {
+            eNegative = true;
+            ++e;
+        } else if (*e == '+') {
+            ++e;
+        }
+        if (isdigit(*e)) {
+            int32_t exponent = 0;
+            for (; isdigit(*e); ++e) {
+                if (exponent < 100000) exponent = exponent * 10 + (*e - '0');
+            }
+            scale += eNegative ? -exponent : exponent;
+            s = e;
+        }
+    }
+
+    if (endPtr) *endPtr = (char*)s;
+
+    if (digitCnt == 0) return negative ? -0.0f : 0.0f;
+
+    if (digitCnt <= 19 && mantissa < MAX_FAST_INTEGER && scale >= -MAX_FAST_FRACTION && scale <= 22) {
+        double value;
+        if (scale >= 0) value = (double)mantissa * pow10Tbl[scale];
+        else value = (double)mantissa / pow10Tbl[-scale];
+        if (scale <= 0 || value < MAX_FAST_INTEGER) return static_cast<float>(negative ? -value : value);
+    }
+
+    return _slowStrtof(negative, digits, digitsEnd, scale);
+}
@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2020 Samsung Electronics Co., Ltd. All rights reserved.
+
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _TVG_SVG_UTIL_H_
+#define _TVG_SVG_UTIL_H_
+
+#include "tvgSvgLoaderCommon.h"
+
+//Locale independent strtof() for the svg number grammar, no hex/inf/nan.
+float svgUtilStrtof(const char* nPtr, char** endPtr);
+
+static constexpr uint32_t svgUtilHash(const char* str, size_t len, uint32_t seed)
+{
+    uint32_t hash = 2166136261u ^ seed;
+    for (size_t i = 0; i < len; ++i) hash = (hash ^ (uint8_t)str[i]) * 16777619u;
+    hash ^= hash >> 16;
+    hash *= 0x7feb352du;
+    return hash ^ (hash >> 15);
+}
+
+
+static constexpr size_t svgUtilSlots(size_t cnt)
+{
+    size_t slots = 8;
+    while (slots < cnt * 4) slots <<= 1;
+    return slots;
+}
+
+
+//Perfect hash over a constant keyword table, built while compiling.
+//The seed is bumped until every keyword owns its slot, so a lookup is one hash and one compare.
+template<size_t N, size_t M = svgUtilSlots(N)>
+struct SvgKeyIndex
+{
+    static_assert(N < 256, "SvgKeyIndex: too many keywords");
+
+    const char* keys[N] = {};
+    size_t lens[N] = {};
+    uint8_t slots[M] = {};      //keyword index + 1, 0 for an empty slot
+    uint32_t seed = 0;
+
+    template<typename T>
+    constexpr SvgKeyIndex(const T (&table)[N])
+    {
+        for (size_t i = 0; i < N; ++i) {
+            keys[i] = table[i].tag;
+            while (keys[i][lens[i]]) ++lens[i];
+        }
+        while (!place()) ++seed;
+    }
+
+    constexpr bool place()
+    {
+        for (size_t i = 0; i < M; ++i) slots[i] = 0;
+        for (size_t i = 0; i < N; ++i) {
+            auto& slot = slots[svgUtilHash(keys[i], lens[i], seed) & (M - 1)];
+            if (slot) return false;
+            slot = i + 1;
+        }
+        return true;
+    }
+
+    //Returns the table index of the keyword or -1, the key needs no null termination.
+    int find(const char* key, size_t len) const
+    {
+        auto idx = slots[svgUtilHash(key, len, seed) & (M - 1)];
+        if (idx == 0 || lens[idx - 1] != len || memcmp(keys[idx - 1], key, len)) return -1;
+        return idx - 1;
+    }
+};
+
+
+template<typename T, size_t N>
+constexpr SvgKeyIndex<N> svgUtilKeyIndex(const T (&table)[N])
+{
+    return SvgKeyIndex<N>(table);
+}
+
+#endif //_TVG_SVG_UTIL_H_
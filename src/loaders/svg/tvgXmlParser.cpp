@@ -30,6 +30,11 @@
 
 #include "tvgXmlParser.h"
 
+//SSE2 is the baseline of x86-64, no build option is needed for it.
+#ifdef __SSE2__
+    #include <emmintrin.h>
+#endif
+
 #ifdef THORVG_LOG_ENABLED
 
 #include <stdio.h>
@@ -62,10 +67,53 @@ string simpleXmlNodeTypeToString(SvgNodeType type)
 }
 #endif
 
+
+//Same as isspace() in the "C" locale
+static inline bool _simpleXmlIsSpace(char c)
+{
+    return (c == ' ') || ((unsigned char)(c - '\t') <= '\r' - '\t');
+}
+
+
+#ifdef __SSE2__
+
+#define SIMPLE_XML_BLOCK 16
+#define _simpleXmlFirstBit(mask) __builtin_ctz(mask)
+
+static inline __m128i _simpleXmlLoad(const char* itr)
+{
+    return _mm_loadu_si128((const __m128i*)itr);
+}
+
+
+static inline __m128i _simpleXmlMatch(__m128i block, char c)
+{
+    return _mm_cmpeq_epi8(block, _mm_set1_epi8(c));
+}
+
+
+//Bit mask of the whitespaces in the block
+static inline uint32_t _simpleXmlSpaceMask(__m128i block)
+{
+    //'\t' ~ '\r' are contiguous, see if (c - '\t') is not greater than ('\r' - '\t') without sign.
+    auto ctrl = _mm_sub_epi8(block, _mm_set1_epi8('\t'));
+    ctrl = _mm_cmpeq_epi8(_mm_min_epu8(ctrl, _mm_set1_epi8('\r' - '\t')), ctrl);
+    return _mm_movemask_epi8(_mm_or_si128(ctrl, _simpleXmlMatch(block, ' ')));
+}
+
+#endif
+
+
 static const char* _simpleXmlFindWhiteSpace(const char* itr, const char* itrEnd)
 {
+#ifdef __SSE2__
+    for (; itr + SIMPLE_XML_BLOCK <= itrEnd; itr += SIMPLE_XML_BLOCK) {
+        auto mask = _simpleXmlSpaceMask(_simpleXmlLoad(itr));
+        if (mask) return itr + _simpleXmlFirstBit(mask);
+    }
+#endif
     for (; itr < itrEnd; itr++) {
-        if (isspace((unsigned char)*itr)) break;
+        if (_simpleXmlIsSpace(*itr)) break;
     }
     return itr;
 }
@@ -73,8 +121,18 @@ static const char* _simpleXmlFindWhiteSpace(const char* itr, const char* itrEnd)
 
 static const char* _simpleXmlSkipWhiteSpace(const char* itr, const char* itrEnd)
 {
+    //Mostly a few characters of indentation, don't pay for a block on them.
+    for (auto i = 0; i < 4; ++i, ++itr) {
+        if (itr == itrEnd || !_simpleXmlIsSpace(*itr)) return itr;
+    }
+#ifdef __SSE2__
+    for (; itr + SIMPLE_XML_BLOCK <= itrEnd; itr += SIMPLE_XML_BLOCK) {
+        auto mask = ~_simpleXmlSpaceMask(_simpleXmlLoad(itr)) & 0xffff;
+        if (mask) return itr + _simpleXmlFirstBit(mask);
+    }
+#endif
     for (; itr < itrEnd; itr++) {
-        if (!isspace((unsigned char)*itr)) break;
+        if (!_simpleXmlIsSpace(*itr)) break;
     }
     return itr;
 }
@@ -83,7 +141,7 @@ static const char* _simpleXmlSkipWhiteSpace(const char* itr, const char* itrEnd)
 static const char* _simpleXmlUnskipWhiteSpace(const char* itr, const char* itrStart)
 {
     for (itr--; itr > itrStart; itr--) {
-        if (!isspace((unsigned char)*itr)) break;
+        if (!_simpleXmlIsSpace(*itr)) break;
     }
     return itr + 1;
 }
@@ -98,6 +156,17 @@ static const char* _simpleXmlFindStartTag(const char* itr, const char* itrEnd)
 static const char* _simpleXmlFindEndTag(const char* itr, const char* itrEnd)
 {
     bool insideQuote = false;
+#ifdef __SSE2__
+    for (; itr + SIMPLE_XML_BLOCK <= itrEnd; itr += SIMPLE_XML_BLOCK) {
+        auto block = _simpleXmlLoad(itr);
+        uint32_t mask = _mm_movemask_epi8(_mm_or_si128(_simpleXmlMatch(block, '"'), _mm_or_si128(_simpleXmlMatch(block, '>'), _simpleXmlMatch(block, '<'))));
+        for (; mask; mask &= mask - 1) {
+            auto p = itr + _simpleXmlFirstBit(mask);
+            if (*p == '"') insideQuote = !insideQuote;
+            else if (!insideQuote) return p;
+        }
+    }
+#endif
     for (; itr < itrEnd; itr++) {
         if (*itr == '"') insideQuote = !insideQuote;
         if (!insideQuote) {
@@ -109,10 +178,30 @@ static const char* _simpleXmlFindEndTag(const char* itr, const char* itrEnd)
 }
 
 
-static const char* _simpleXmlFindEndCommentTag(const char* itr, const char* itrEnd)
+//The end of the attribute key, '=' or a whitespace
+static const char* _simpleXmlFindKeyEnd(const char* itr, const char* itrEnd)
 {
+#ifdef __SSE2__
+    for (; itr + SIMPLE_XML_BLOCK <= itrEnd; itr += SIMPLE_XML_BLOCK) {
+        auto block = _simpleXmlLoad(itr);
+        auto mask = _simpleXmlSpaceMask(block) | _mm_movemask_epi8(_simpleXmlMatch(block, '='));
+        if (mask) return itr + _simpleXmlFirstBit(mask);
+    }
+#endif
     for (; itr < itrEnd; itr++) {
-        if ((*itr == '-') && ((itr + 1 < itrEnd) && (*(itr + 1) == '-')) && ((itr + 2 < itrEnd) && (*(itr + 2) == '>'))) return itr + 2;
+        if ((*itr == '=') || (_simpleXmlIsSpace(*itr))) break;
+    }
+    return itr;
+}
+
+
+static const char* _simpleXmlFindEndCommentTag(const char* itr, const char* itrEnd)
+{
+    //The terminator starts at itr at the earliest
+    for (itr += 2; itr < itrEnd; ++itr) {
+        itr = (const char*)memchr(itr, '>', itrEnd - itr);
+        if (!itr) break;
+        if ((itr[-1] == '-') && (itr[-2] == '-')) return itr;
     }
     return nullptr;
 }
@@ -120,8 +209,11 @@ static const char* _simpleXmlFindEndCommentTag(const char* itr, const char* itrE
 
 static const char* _simpleXmlFindEndCdataTag(const char* itr, const char* itrEnd)
 {
-    for (; itr < itrEnd; itr++) {
-        if ((*itr == ']') && ((itr + 1 < itrEnd) && (*(itr + 1) == ']')) && ((itr + 2 < itrEnd) && (*(itr + 2) == '>'))) return itr + 2;
+    //The terminator starts at itr at the earliest
+    for (itr += 2; itr < itrEnd; ++itr) {
+        itr = (const char*)memchr(itr, '>', itrEnd - itr);
+        if (!itr) break;
+        if ((itr[-1] == ']') && (itr[-2] == ']')) return itr;
     }
     return nullptr;
 }
@@ -129,10 +221,7 @@ static const char* _simpleXmlFindEndCdataTag(const char* itr, const char* itrEnd
 
 static const char* _simpleXmlFindDoctypeChildEndTag(const char* itr, const char* itrEnd)
 {
-    for (; itr < itrEnd; itr++) {
-        if (*itr == '>') return itr;
-    }
-    return nullptr;
+    return (const char*)memchr(itr, '>', itrEnd - itr);
 }
 
 
@@ -152,9 +241,7 @@ bool simpleXmlParseAttributes(const char* buf, unsigned bufLength, simpleXMLAttr
         if (p == itrEnd) return true;
 
         key = p;
-        for (keyEnd = key; keyEnd < itrEnd; keyEnd++) {
-            if ((*keyEnd == '=') || (isspace((unsigned char)*keyEnd))) break;
-        }
+        keyEnd = _simpleXmlFindKeyEnd(key, itrEnd);
         if (keyEnd == itrEnd) return false;
         if (keyEnd == key) continue;
 
@@ -164,9 +251,7 @@ bool simpleXmlParseAttributes(const char* buf, unsigned bufLength, simpleXMLAttr
             if (!value) return false;
             value++;
         }
-        for (; value < itrEnd; value++) {
-            if (!isspace((unsigned char)*value)) break;
-        }
+        value = _simpleXmlSkipWhiteSpace(value, itrEnd);
         if (value == itrEnd) return false;
 
         if ((*value == '"') || (*value == '\'')) {
@@ -196,7 +281,8 @@ bool simpleXmlParseAttributes(const char* buf, unsigned bufLength, simpleXMLAttr
 }
 
 
-bool simpleXmlParse(const char* buf, unsigned bufLength, bool strip, simpleXMLCb func, const void* data)
+//If stop is given, the contents continue after bufLength. Parsing stops before the first incomplete token then.
+static bool _simpleXmlParse(const char* buf, unsigned bufLength, bool strip, simpleXMLCb func, const void* data, const char** stop)
 {
     const char *itr = buf, *itrEnd = buf + bufLength;
 
@@ -214,6 +300,9 @@ bool simpleXmlParse(const char* buf, unsigned bufLength, bool strip, simpleXMLCb
 
     while (itr < itrEnd) {
         if (itr[0] == '<') {
+            //The type of <! is decided by the following characters, up to <![CDATA[]]>
+            if (stop && ((itr + 1 >= itrEnd) || ((itr[1] == '!') && (itrEnd - itr < (ptrdiff_t)sizeof("<![CDATA[]]>"))))) break;
+
             if (itr + 1 >= itrEnd) {
                 CB(SimpleXMLType::Error, itr, itrEnd);
                 return false;
@@ -229,7 +318,7 @@ bool simpleXmlParse(const char* buf, unsigned bufLength, bool strip, simpleXMLCb
                     type = SimpleXMLType::Processing;
                     toff = 1;
                 } else if (itr[1] == '!') {
-                    if ((itr + sizeof("<!DOCTYPE>") - 1 < itrEnd) && (!memcmp(itr + 2, "DOCTYPE", sizeof("DOCTYPE") - 1)) && ((itr[2 + sizeof("DOCTYPE") - 1] == '>') || (isspace((unsigned char)itr[2 + sizeof("DOCTYPE") - 1])))) {
+                    if ((itr + sizeof("<!DOCTYPE>") - 1 < itrEnd) && (!memcmp(itr + 2, "DOCTYPE", sizeof("DOCTYPE") - 1)) && ((itr[2 + sizeof("DOCTYPE") - 1] == '>') || (_simpleXmlIsSpace(itr[2 + sizeof("DOCTYPE") - 1])))) {
                         type = SimpleXMLType::Doctype;
                         toff = sizeof("!DOCTYPE") - 1;
                     } else if ((itr + sizeof("<!---->") - 1 < itrEnd) && (!memcmp(itr + 2, "--", sizeof("--") - 1))) {
@@ -301,6 +390,7 @@ bool simpleXmlParse(const char* buf, unsigned bufLength, bool strip, simpleXMLCb
                     if (type != SimpleXMLType::Error) itr = p + 1;
                     else itr = p;
                 } else {
+                    if (stop) break;
                     CB(SimpleXMLType::Error, itr, itrEnd);
                     return false;
                 }
@@ -308,6 +398,13 @@ bool simpleXmlParse(const char* buf, unsigned bufLength, bool strip, simpleXMLCb
         } else {
             const char *p, *end;
 
+            //The data goes on to the next tag
+            auto next = _simpleXmlFindStartTag(itr, itrEnd);
+            if (!next) {
+                if (stop) break;
+                next = itrEnd;
+            }
+
             if (strip) {
                 p = _simpleXmlSkipWhiteSpace(itr, itrEnd);
                 if (p) {
@@ -316,9 +413,7 @@ bool simpleXmlParse(const char* buf, unsigned bufLength, bool strip, simpleXMLCb
                 }
             }
 
-            p = _simpleXmlFindStartTag(itr, itrEnd);
-            if (!p) p = itrEnd;
-
+            p = next;
             end = p;
             if (strip) end = _simpleXmlUnskipWhiteSpace(end, itr);
 
@@ -332,10 +427,27 @@ bool simpleXmlParse(const char* buf, unsigned bufLength, bool strip, simpleXMLCb
 
 #undef CB
 
+    if (stop) *stop = itr;
+
     return true;
 }
 
 
+bool simpleXmlParse(const char* buf, unsigned bufLength, bool strip, simpleXMLCb func, const void* data)
+{
+    return _simpleXmlParse(buf, bufLength, strip, func, data, nullptr);
+}
+
+
+bool simpleXmlParseChunk(const char* buf, unsigned bufLength, bool strip, simpleXMLCb func, const void* data, unsigned* parsed)
+{
+    const char* stop = buf;
+    auto ret = _simpleXmlParse(buf, bufLength, strip, func, data, &stop);
+    if (parsed) *parsed = stop - buf;
+    return ret;
+}
+
+
 bool simpleXmlParseW3CAttribute(const char* buf, simpleXMLAttributeCb func, const void* data)
 {
     const char* end;
@@ -391,7 +503,7 @@ const char* simpleXmlFindAttributesTag(const char* buf, unsigned bufLength)
     const char *itr = buf, *itrEnd = buf + bufLength;
 
     for (; itr < itrEnd; itr++) {
-        if (!isspace((unsigned char)*itr)) {
+        if (!_simpleXmlIsSpace(*itr)) {
             //User skip tagname and already gave it the attributes.
             if (*itr == '=') return buf;
         } else {
@@ -1,4 +1,5 @@
 #include <gtest/gtest.h>
+#include <cmath>
 #include <iostream>
 #include <thread>
 #include <thorvg.h>
@@ -17,12 +18,416 @@ public:
         //Terminate ThorVG Engine
         tvg::Initializer::term(tvgEngine);
     }
+
+    //Draws what the function pushes on a new canvas over the given buffer
+    template<typename Build> void render(uint32_t* buf, Build build) {
+        memset(buf, 0, sizeof(buffer));
+        auto canvas = tvg::SwCanvas::gen();
+        ASSERT_EQ(canvas->target(buf, 100, 100, 100, tvg::SwCanvas::ARGB8888), tvg::Result::Success);
+        build(canvas.get());
+        ASSERT_EQ(canvas->draw(), tvg::Result::Success);
+        ASSERT_EQ(canvas->sync(), tvg::Result::Success);
+    }
+
+    //The function builds the tested case with true, the reference with false. Both must look the same.
+    template<typename Build> void compare(Build build) {
+        render(buffer, [&](tvg::SwCanvas* canvas) { build(canvas, true); });
+        render(expected, [&](tvg::SwCanvas* canvas) { build(canvas, false); });
+        ASSERT_EQ(memcmp(buffer, expected, sizeof(buffer)), 0);
+    }
 public:
     std::unique_ptr<tvg::SwCanvas> swCanvas;
     tvg::CanvasEngine tvgEngine = tvg::CanvasEngine::Sw;
+    uint32_t buffer[100 * 100] = {};
+    uint32_t expected[100 * 100] = {};
 };
 
 TEST_F(CanvasTest, GenerateCanvas) {
     ASSERT_TRUE(swCanvas != nullptr);
 }
 
+
+TEST_F(CanvasTest, HitTest) {
+    ASSERT_TRUE(swCanvas != nullptr);
+
+    ASSERT_EQ(swCanvas->target(buffer, 100, 100, 100, tvg::SwCanvas::ARGB8888), tvg::Result::Success);
+
+    auto circle = tvg::Shape::gen();
+    circle->appendCircle(30, 30, 20, 20);
+    circle->fill(255, 0, 0, 255);
+    auto pCircle = circle.get();
+
+    auto rect = tvg::Shape::gen();
+    rect->appendRect(40, 40, 40, 40, 0, 0);
+    rect->fill(0, 0, 255, 255);
+    auto pRect = rect.get();
+
+    auto scene = tvg::Scene::gen();
+    scene->push(std::move(rect));
+
+    ASSERT_EQ(swCanvas->push(std::move(circle)), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->push(std::move(scene)), tvg::Result::Success);
+
+    tvg::Paint* paints[2];
+
+    //Front to back
+    ASSERT_EQ(swCanvas->hit(42, 42, paints, 2), 2U);
+    ASSERT_EQ(paints[0], pRect);
+    ASSERT_EQ(paints[1], pCircle);
+
+    //Inside the bounding box, outside of the circle
+    ASSERT_EQ(swCanvas->hit(12, 12, paints, 2), 0U);
+
+    ASSERT_EQ(swCanvas->hit(0, 0, 100, 100, nullptr, 0), 2U);
+    ASSERT_EQ(swCanvas->hit(85, 0, 15, 30, paints, 2), 0U);
+}
+
+
+TEST_F(CanvasTest, UpdateChanged) {
+    compare([](tvg::SwCanvas* canvas, bool modify) {
+        auto scene = tvg::Scene::gen();
+        auto inner = tvg::Scene::gen();
+
+        auto shape = tvg::Shape::gen();
+        shape->appendRect(10, 10, 30, 30, 0, 0);
+        shape->fill(modify ? 255 : 0, 0, 255, 255);
+        auto pShape = shape.get();
+        inner->push(std::move(shape));
+
+        auto shape2 = tvg::Shape::gen();
+        shape2->appendCircle(60, 60, 20, 20);
+        shape2->fill(0, 255, 0, 255);
+        auto pShape2 = shape2.get();
+        scene->push(std::move(shape2));
+
+        if (!modify) {
+            pShape2->translate(5, 5);
+            inner->opacity(128);
+        }
+
+        auto pInner = inner.get();
+        scene->push(std::move(inner));
+        ASSERT_EQ(canvas->push(std::move(scene)), tvg::Result::Success);
+
+        if (!modify) return;
+
+        ASSERT_EQ(canvas->draw(), tvg::Result::Success);
+        ASSERT_EQ(canvas->sync(), tvg::Result::Success);
+
+        //Changes deep in the tree are picked up by the canvas
+        pShape->fill(0, 0, 255, 255);
+        pShape2->translate(5, 5);
+        pInner->opacity(128);
+
+        ASSERT_EQ(canvas->update(nullptr), tvg::Result::Success);
+    });
+}
+
+
+TEST_F(CanvasTest, UpdateDuplicate) {
+    compare([](tvg::SwCanvas* canvas, bool duplicate) {
+        auto scene = tvg::Scene::gen();
+
+        auto shape = tvg::Shape::gen();
+        shape->appendRect(10, 10, 30, 30, 0, 0);
+        shape->fill(0, 0, 255, 255);
+        if (!duplicate) shape->translate(20, 0);
+        scene->push(std::move(shape));
+
+        auto shape2 = tvg::Shape::gen();
+        shape2->appendCircle(60, 60, 20, 20);
+        shape2->fill(0, 255, 0, 255);
+        scene->push(std::move(shape2));
+
+        if (!duplicate) {
+            ASSERT_EQ(canvas->push(std::move(scene)), tvg::Result::Success);
+            return;
+        }
+
+        auto dup = std::unique_ptr<tvg::Paint>(scene->duplicate());
+        ASSERT_EQ(canvas->push(std::move(dup)), tvg::Result::Success);
+        ASSERT_EQ(canvas->draw(), tvg::Result::Success);
+        ASSERT_EQ(canvas->sync(), tvg::Result::Success);
+
+        //Changes of the duplicated children reach the canvas
+        tvg::Paint* paints[1];
+        ASSERT_EQ(canvas->hit(20, 20, paints, 1), 1U);
+        ASSERT_EQ(paints[0]->translate(20, 0), tvg::Result::Success);
+
+        ASSERT_EQ(canvas->update(nullptr), tvg::Result::Success);
+    });
+}
+
+
+TEST_F(CanvasTest, Reorder) {
+    auto rect = [](float x, uint8_t r, uint8_t g, uint8_t b) {
+        auto shape = tvg::Shape::gen();
+        shape->appendRect(x, x, 40, 40, 0, 0);
+        shape->fill(r, g, b, 255);
+        return shape;
+    };
+
+    compare([&](tvg::SwCanvas* canvas, bool reorder) {
+        //Expected order: blue, red, yellow(scene: cyan, magenta)
+        if (!reorder) {
+            canvas->push(rect(20, 0, 0, 255));
+            canvas->push(rect(10, 255, 0, 0));
+            canvas->push(rect(30, 255, 255, 0));
+            auto scene = tvg::Scene::gen();
+            scene->push(rect(50, 0, 255, 255));
+            scene->push(rect(55, 255, 0, 255));
+            canvas->push(std::move(scene));
+            return;
+        }
+
+        auto red = rect(10, 255, 0, 0);
+        auto pRed = red.get();
+        auto green = rect(40, 0, 255, 0);
+        auto pGreen = green.get();
+        auto scene = tvg::Scene::gen();
+        auto magenta = rect(55, 255, 0, 255);
+        auto pMagenta = magenta.get();
+        auto gray = rect(60, 128, 128, 128);
+        auto pGray = gray.get();
+        scene->push(std::move(magenta));
+        scene->push(std::move(gray));
+        auto pScene = scene.get();
+
+        canvas->push(std::move(red));
+        canvas->push(std::move(green));
+        canvas->push(std::move(scene));
+        ASSERT_EQ(canvas->draw(), tvg::Result::Success);
+        ASSERT_EQ(canvas->sync(), tvg::Result::Success);
+
+        ASSERT_EQ(canvas->insert(rect(20, 0, 0, 255), pRed, false), tvg::Result::Success);
+        ASSERT_EQ(canvas->insert(rect(30, 255, 255, 0), pGreen, true), tvg::Result::Success);
+        ASSERT_EQ(canvas->remove(pGreen), tvg::Result::Success);
+        ASSERT_EQ(canvas->remove(pGreen), tvg::Result::InvalidArguments);
+        ASSERT_EQ(canvas->moveToBack(pScene), tvg::Result::Success);
+        ASSERT_EQ(canvas->moveToFront(pScene), tvg::Result::Success);
+
+        ASSERT_EQ(pScene->insert(rect(50, 0, 255, 255), pMagenta, false), tvg::Result::Success);
+        ASSERT_EQ(pScene->moveToBack(pGray), tvg::Result::Success);
+        ASSERT_EQ(pScene->remove(pGray), tvg::Result::Success);
+
+        ASSERT_EQ(canvas->update(nullptr), tvg::Result::Success);
+    });
+}
+
+
+TEST_F(CanvasTest, RemovePending) {
+    auto rect = [](float x, uint8_t r, uint8_t g, uint8_t b) {
+        auto shape = tvg::Shape::gen();
+        shape->appendRect(x, x, 30, 30, 0, 0);
+        shape->fill(r, g, b, 255);
+        return shape;
+    };
+
+    compare([&](tvg::SwCanvas* canvas, bool remove) {
+        auto scene = tvg::Scene::gen();
+        auto pScene = scene.get();
+        scene->push(rect(50, 0, 255, 0));
+        auto blue = rect(60, 0, 0, 255);
+        auto pBlue = blue.get();
+        if (remove) scene->push(std::move(blue));
+        ASSERT_EQ(canvas->push(std::move(scene)), tvg::Result::Success);
+
+        ASSERT_EQ(canvas->push(rect(10, 255, 255, 0)), tvg::Result::Success);
+        auto red = rect(20, 255, 0, 0);
+        auto pRed = red.get();
+        if (remove) ASSERT_EQ(canvas->push(std::move(red)), tvg::Result::Success);
+
+        //Paints are removed while the engine is preparing them, both owners release them on the next update
+        if (remove) {
+            ASSERT_EQ(canvas->remove(pRed), tvg::Result::Success);
+            ASSERT_EQ(canvas->remove(pRed), tvg::Result::InvalidArguments);
+            ASSERT_EQ(pScene->remove(pBlue), tvg::Result::Success);
+            ASSERT_EQ(pScene->remove(pBlue), tvg::Result::InvalidArguments);
+        }
+
+        ASSERT_EQ(canvas->draw(), tvg::Result::Success);
+        ASSERT_EQ(canvas->sync(), tvg::Result::Success);
+
+        ASSERT_EQ(canvas->update(nullptr), tvg::Result::Success);
+    });
+}
+
+
+TEST_F(CanvasTest, MemoryTrim) {
+    ASSERT_TRUE(swCanvas != nullptr);
+
+    ASSERT_EQ(swCanvas->target(buffer, 100, 100, 100, tvg::SwCanvas::ARGB8888), tvg::Result::Success);
+
+    auto fill = tvg::LinearGradient::gen();
+    fill->linear(10, 10, 60, 60);
+    tvg::Fill::ColorStop colorStops[2] = {{0, 255, 0, 0, 255}, {1, 0, 0, 255, 255}};
+    fill->colorStops(colorStops, 2);
+
+    auto shape = tvg::Shape::gen();
+    shape->appendCircle(35, 35, 25, 25);
+    shape->fill(std::move(fill));
+
+    auto scene = tvg::Scene::gen();
+    scene->cache(true);
+    scene->push(std::move(shape));
+    ASSERT_EQ(swCanvas->push(std::move(scene)), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->draw(), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->sync(), tvg::Result::Success);
+    memcpy(expected, buffer, sizeof(buffer));
+
+    tvg::MemoryUsage usage;
+    ASSERT_EQ(tvg::Initializer::usage(tvgEngine, &usage), tvg::Result::Success);
+    ASSERT_GT(usage.rle, 0U);
+    ASSERT_GT(usage.ctable, 0U);
+    ASSERT_GT(usage.image, 0U);
+
+    //Layer image is as large as the scene region
+    ASSERT_LE(usage.image, 50U * 50U * sizeof(uint32_t));
+
+    //Dropped layer cache is redrawn, the canvas drops it on its next draw
+    ASSERT_EQ(tvg::Initializer::trim(tvgEngine, 1), tvg::Result::Success);
+
+    memset(buffer, 0, sizeof(buffer));
+    ASSERT_EQ(swCanvas->draw(), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->sync(), tvg::Result::Success);
+    ASSERT_EQ(memcmp(buffer, expected, sizeof(buffer)), 0);
+
+    //Over the budget, the canvas trims the engine by itself
+    ASSERT_EQ(tvg::Initializer::budget(tvgEngine, 1), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->draw(), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->sync(), tvg::Result::Success);
+    ASSERT_EQ(tvg::Initializer::usage(tvgEngine, &usage), tvg::Result::Success);
+    ASSERT_EQ(usage.image, 0U);
+    ASSERT_EQ(tvg::Initializer::budget(tvgEngine, 0), tvg::Result::Success);
+
+    //Released paints stay in the pools until the trim
+    {
+        std::unique_ptr<tvg::Shape> shapes[100];
+        for (auto& shape : shapes) shape = tvg::Shape::gen();
+    }
+    ASSERT_EQ(tvg::Initializer::usage(tvgEngine, &usage), tvg::Result::Success);
+    auto pooled = usage.block;
+    ASSERT_GT(pooled, 0U);
+
+    ASSERT_EQ(tvg::Initializer::trim(tvgEngine, 0), tvg::Result::Success);
+    tvg::Shape::gen();
+    ASSERT_EQ(tvg::Initializer::usage(tvgEngine, &usage), tvg::Result::Success);
+    ASSERT_LT(usage.block, pooled);
+}
+
+
+TEST_F(CanvasTest, Quality) {
+    ASSERT_TRUE(swCanvas != nullptr);
+
+    ASSERT_EQ(swCanvas->target(buffer, 100, 100, 100, tvg::SwCanvas::ARGB8888), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->quality(), tvg::Quality::Normal);
+
+    auto shape = tvg::Shape::gen();
+    shape->appendCircle(50, 50, 30, 20);
+    shape->fill(255, 0, 0, 255);
+    shape->stroke(3);
+    shape->stroke(0, 0, 255, 255);
+    ASSERT_EQ(swCanvas->push(std::move(shape)), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->draw(), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->sync(), tvg::Result::Success);
+    memcpy(expected, buffer, sizeof(buffer));
+
+    //Coarser curves
+    ASSERT_EQ(swCanvas->quality(tvg::Quality::Draft), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->quality(), tvg::Quality::Draft);
+    ASSERT_EQ(swCanvas->draw(), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->sync(), tvg::Result::Success);
+    ASSERT_NE(memcmp(buffer, expected, sizeof(buffer)), 0);
+
+    //Back to the same curves
+    ASSERT_EQ(swCanvas->quality(tvg::Quality::Normal), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->draw(), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->sync(), tvg::Result::Success);
+    ASSERT_EQ(memcmp(buffer, expected, sizeof(buffer)), 0);
+
+    //Finer stroke outlines, closer to the ideal ring
+    auto error = [&](tvg::Quality quality) {
+        swCanvas->clear();
+        swCanvas->quality(quality);
+        auto ring = tvg::Shape::gen();
+        ring->appendCircle(50, 50, 20, 20);
+        ring->stroke(20);
+        ring->stroke(255, 255, 255, 255);
+        swCanvas->push(std::move(ring));
+        swCanvas->draw();
+        swCanvas->sync();
+
+        auto sum = 0.0f;
+        for (uint32_t y = 0; y < 100; ++y) {
+            for (uint32_t x = 0; x < 100; ++x) {
+                auto covered = 0;
+                for (uint32_t i = 0; i < 16; ++i) {
+                    auto dx = x + (i % 4 + 0.5f) / 4 - 50;
+                    auto dy = y + (i / 4 + 0.5f) / 4 - 50;
+                    auto d = sqrtf(dx * dx + dy * dy);
+                    if (d >= 10 && d <= 30) ++covered;
+                }
+                sum += fabsf(covered / 16.0f - (buffer[y * 100 + x] & 0xff) / 255.0f);
+            }
+        }
+        return sum;
+    };
+    ASSERT_LT(error(tvg::Quality::High), error(tvg::Quality::Normal));
+}
+
+TEST_F(CanvasTest, Hairline) {
+    ASSERT_TRUE(swCanvas != nullptr);
+
+    ASSERT_EQ(swCanvas->target(buffer, 100, 100, 100, tvg::SwCanvas::ARGB8888), tvg::Result::Success);
+
+    //A pixel wide line along the pixel centers covers exactly one row
+    auto shape = tvg::Shape::gen();
+    shape->moveTo(10, 50.5f);
+    shape->lineTo(90, 50.5f);
+    shape->stroke(1);
+    shape->stroke(255, 255, 255, 255);
+    shape->stroke(tvg::StrokeCap::Butt);
+    ASSERT_EQ(swCanvas->push(std::move(shape)), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->draw(), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->sync(), tvg::Result::Success);
+
+    auto pixel = buffer[50 * 100 + 10];
+    ASSERT_EQ(pixel >> 24, 0xffu);
+
+    for (uint32_t x = 10; x < 90; ++x) {
+        ASSERT_EQ(buffer[49 * 100 + x], 0u);
+        ASSERT_EQ(buffer[50 * 100 + x], pixel);
+        ASSERT_EQ(buffer[51 * 100 + x], 0u);
+    }
+    ASSERT_EQ(buffer[50 * 100 + 9], 0u);
+    ASSERT_EQ(buffer[50 * 100 + 90], 0u);
+
+    //Square caps reach half a pixel out of the ends
+    ASSERT_EQ(swCanvas->clear(), tvg::Result::Success);
+    shape = tvg::Shape::gen();
+    shape->moveTo(10, 50.5f);
+    shape->lineTo(90, 50.5f);
+    shape->stroke(1);
+    shape->stroke(255, 255, 255, 255);
+    shape->stroke(tvg::StrokeCap::Square);
+    ASSERT_EQ(swCanvas->push(std::move(shape)), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->draw(), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->sync(), tvg::Result::Success);
+    ASSERT_NE(buffer[50 * 100 + 9], 0u);
+    ASSERT_NE(buffer[50 * 100 + 90], 0u);
+
+    //Zero length dashes leave the dots of the round caps
+    ASSERT_EQ(swCanvas->clear(), tvg::Result::Success);
+    shape = tvg::Shape::gen();
+    shape->moveTo(10, 50.5f);
+    shape->lineTo(90, 50.5f);
+    shape->stroke(1);
+    shape->stroke(255, 255, 255, 255);
+    shape->stroke(tvg::StrokeCap::Round);
+    float dashPattern[2] = {0, 10};
+    shape->stroke(dashPattern, 2);
+    ASSERT_EQ(swCanvas->push(std::move(shape)), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->draw(), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->sync(), tvg::Result::Success);
+    ASSERT_NE(buffer[50 * 100 + 30], 0u);
+}
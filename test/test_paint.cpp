@@ -1,6 +1,8 @@
 #include <gtest/gtest.h>
 #include <iostream>
+#include <string>
 #include <thread>
+#include <vector>
 #include <thorvg.h>
 
 class PaintTest : public ::testing::Test {
@@ -21,11 +23,30 @@ public:
         //Terminate ThorVG Engine
         tvg::Initializer::term(tvgEngine);
     }
+
+    //Draws what the function pushes on a new canvas over the given buffer
+    template<typename Build> void render(uint32_t* buf, Build build) {
+        memset(buf, 0, sizeof(buffer));
+        auto canvas = tvg::SwCanvas::gen();
+        ASSERT_EQ(canvas->target(buf, 100, 100, 100, tvg::SwCanvas::ARGB8888), tvg::Result::Success);
+        build(canvas.get());
+        ASSERT_EQ(canvas->draw(), tvg::Result::Success);
+        ASSERT_EQ(canvas->sync(), tvg::Result::Success);
+    }
+
+    //The function builds the tested case with true, the reference with false. Both must look the same.
+    template<typename Build> void compare(Build build) {
+        render(buffer, [&](tvg::SwCanvas* canvas) { build(canvas, true); });
+        render(expected, [&](tvg::SwCanvas* canvas) { build(canvas, false); });
+        ASSERT_EQ(memcmp(buffer, expected, sizeof(buffer)), 0);
+    }
 public:
     std::unique_ptr<tvg::SwCanvas> swCanvas;
     std::unique_ptr<tvg::Scene> scene;
     std::unique_ptr<tvg::Shape> shape;
     tvg::CanvasEngine tvgEngine = tvg::CanvasEngine::Sw;
+    uint32_t buffer[100 * 100] = {};
+    uint32_t expected[100 * 100] = {};
 };
 
 TEST_F(PaintTest, GenerateShape) {
@@ -54,3 +75,383 @@ TEST_F(PaintTest, SceneBounds) {
     ASSERT_EQ(h, 200.0);
 }
 
+TEST_F(PaintTest, TightBounds) {
+    ASSERT_EQ(shape->moveTo(0, 0), tvg::Result::Success);
+    ASSERT_EQ(shape->cubicTo(0, 100, 100, 100, 100, 0), tvg::Result::Success);
+
+    float x, y, w, h;
+    ASSERT_EQ(shape->bounds(&x, &y, &w, &h), tvg::Result::Success);
+    ASSERT_EQ(h, 100.0f);
+
+    //The curve only reaches 3/4 of the control points
+    ASSERT_EQ(shape->bounds(&x, &y, &w, &h, true), tvg::Result::Success);
+    ASSERT_EQ(x, 0.0f);
+    ASSERT_EQ(w, 100.0f);
+    ASSERT_NEAR(h, 75.0f, 0.001f);
+
+    //Bounds follow the appended points
+    ASSERT_EQ(shape->lineTo(-10, 120), tvg::Result::Success);
+    ASSERT_EQ(shape->bounds(&x, &y, &w, &h, true), tvg::Result::Success);
+    ASSERT_EQ(x, -10.0f);
+    ASSERT_EQ(h, 120.0f);
+
+    ASSERT_EQ(shape->reset(), tvg::Result::Success);
+    ASSERT_EQ(shape->bounds(&x, &y, &w, &h), tvg::Result::InsufficientCondition);
+    ASSERT_EQ(shape->appendRect(10, 20, 30, 40, 0, 0), tvg::Result::Success);
+    ASSERT_EQ(shape->bounds(&x, &y, &w, &h, true), tvg::Result::Success);
+    ASSERT_EQ(x, 10.0f);
+    ASSERT_EQ(h, 40.0f);
+}
+
+
+TEST_F(PaintTest, SceneCache) {
+    ASSERT_TRUE(swCanvas != nullptr);
+    ASSERT_TRUE(scene != nullptr);
+
+    //Integral shift of the cached layer must match the shifted geometry
+    compare([](tvg::SwCanvas* canvas, bool cache) {
+        auto x = cache ? 0.0f : 20.0f;
+        auto y = cache ? 0.0f : 10.0f;
+
+        auto scene = tvg::Scene::gen();
+        ASSERT_EQ(scene->cache(cache), tvg::Result::Success);
+        ASSERT_EQ(scene->cache(), cache);
+
+        auto shape = tvg::Shape::gen();
+        shape->appendCircle(30 + x, 30 + y, 15.5, 12.5);
+        shape->fill(255, 0, 0, 255);
+        scene->push(std::move(shape));
+
+        auto shape2 = tvg::Shape::gen();
+        shape2->appendRect(40 + x, 35 + y, 30, 20, 5, 5);
+        shape2->fill(0, 0, 255, 255);
+        scene->push(std::move(shape2));
+
+        //Composition within the layer
+        auto shape3 = tvg::Shape::gen();
+        shape3->appendRect(20 + x, 45 + y, 40, 15, 0, 0);
+        shape3->fill(0, 255, 0, 255);
+        auto mask = tvg::Shape::gen();
+        mask->appendCircle(40 + x, 52 + y, 10, 10);
+        mask->fill(0, 0, 0, 255);
+        shape3->composite(std::move(mask), tvg::CompositeMethod::AlphaMask);
+        scene->push(std::move(shape3));
+
+        auto scene2 = scene.get();
+        ASSERT_EQ(canvas->push(std::move(scene)), tvg::Result::Success);
+
+        if (!cache) return;
+
+        ASSERT_EQ(canvas->draw(), tvg::Result::Success);
+        ASSERT_EQ(canvas->sync(), tvg::Result::Success);
+
+        scene2->translate(20, 10);
+        ASSERT_EQ(canvas->update(scene2), tvg::Result::Success);
+    });
+}
+
+TEST_F(PaintTest, SceneCulling) {
+    //Children of a large scene are culled against the surface, the result must be same as drawing them all
+    compare([](tvg::SwCanvas* canvas, bool culling) {
+        auto shift = culling ? -30.0f : -60.0f;
+        auto scene = tvg::Scene::gen();
+        std::unique_ptr<tvg::Shape> front;
+
+        for (int y = 0; y < 20; ++y) {
+            for (int x = 0; x < 20; ++x) {
+                auto shape = tvg::Shape::gen();
+                shape->appendRect(x * 10 + shift, y * 10 + shift, 25, 25, 0, 0);
+                shape->fill(x * 12, y * 12, 128, 255);
+                if (x == 9 && y == 9) front = std::move(shape);
+                else if (culling) scene->push(std::move(shape));
+                else canvas->push(std::move(shape));
+            }
+        }
+
+        auto p = front.get();
+
+        if (culling) {
+            //Reordering keeps the grid in sync
+            ASSERT_EQ(scene->push(std::move(front)), tvg::Result::Success);
+            ASSERT_EQ(scene->moveToBack(p), tvg::Result::Success);
+            ASSERT_EQ(scene->moveToFront(p), tvg::Result::Success);
+
+            auto s = scene.get();
+            ASSERT_EQ(canvas->push(std::move(scene)), tvg::Result::Success);
+            ASSERT_EQ(canvas->draw(), tvg::Result::Success);
+            ASSERT_EQ(canvas->sync(), tvg::Result::Success);
+
+            //Grid is rebuilt with the new regions
+            s->translate(shift, shift);
+            ASSERT_EQ(canvas->update(nullptr), tvg::Result::Success);
+        } else {
+            ASSERT_EQ(canvas->push(std::move(front)), tvg::Result::Success);
+        }
+
+        //Only the children around the point are tested, front to back
+        tvg::Paint* paints[8];
+        ASSERT_EQ(canvas->hit(37, 37, paints, 8), 4U);
+        ASSERT_EQ(paints[0], p);
+    });
+}
+
+TEST_F(PaintTest, DuplicateShapePath) {
+    ASSERT_TRUE(shape != nullptr);
+
+    ASSERT_EQ(shape->appendRect(10.0, 20.0, 100.0, 200.0, 0, 0), tvg::Result::Success);
+
+    auto dup = std::unique_ptr<tvg::Shape>(static_cast<tvg::Shape*>(shape->duplicate()));
+    ASSERT_TRUE(dup != nullptr);
+
+    const tvg::Point* pts1;
+    const tvg::Point* pts2;
+    ASSERT_EQ(dup->pathCoords(&pts2), shape->pathCoords(&pts1));
+    ASSERT_EQ(pts1[2].x, pts2[2].x);
+
+    //Modifying the duplicate leaves the source untouched
+    ASSERT_EQ(dup->lineTo(0.0, 0.0), tvg::Result::Success);
+    ASSERT_EQ(shape->pathCoords(&pts1), 4U);
+    ASSERT_EQ(dup->pathCoords(&pts2), 5U);
+    ASSERT_EQ(pts1[2].x, 110.0);
+    ASSERT_EQ(pts2[2].x, 110.0);
+
+    ASSERT_EQ(shape->reset(), tvg::Result::Success);
+    ASSERT_EQ(shape->pathCoords(&pts1), 0U);
+    ASSERT_EQ(dup->pathCoords(&pts2), 5U);
+}
+
+TEST_F(PaintTest, ShapeInstances) {
+    tvg::Point offsets[] = {{5.3f, 0.5f}, {40.7f, -0.2f}, {10.25f, 50.5f}};
+    uint8_t opacities[] = {255, 255, 128};
+
+    compare([&](tvg::SwCanvas* canvas, bool instanced) {
+        for (uint32_t i = 0; i < 3; ++i) {
+            auto shape = tvg::Shape::gen();
+            shape->appendCircle(20, 20, 12.5, 10.5);
+            shape->fill(255, 0, 0, 255);
+            shape->stroke(0, 0, 255, 255);
+            shape->stroke(3);
+            if (instanced) {
+                ASSERT_EQ(shape->instances(offsets, opacities, 3), tvg::Result::Success);
+                const tvg::Point* pts;
+                ASSERT_EQ(shape->instances(&pts, nullptr), 3U);
+                ASSERT_EQ(pts[1].x, offsets[1].x);
+                canvas->push(std::move(shape));
+                break;
+            }
+            shape->translate(offsets[i].x, offsets[i].y);
+            shape->opacity(opacities[i]);
+            canvas->push(std::move(shape));
+        }
+    });
+
+    ASSERT_EQ(shape->instances(nullptr, nullptr, 1), tvg::Result::InvalidArguments);
+}
+
+TEST_F(PaintTest, PoolThreads) {
+    std::vector<std::unique_ptr<tvg::Shape>> shapes;
+
+    //Allocated on a worker, released on this thread
+    std::thread([&] {
+        for (uint32_t i = 0; i < 1000; ++i) {
+            auto shape = tvg::Shape::gen();
+            shape->appendRect(0, 0, 10, 10, 0, 0);
+            shapes.push_back(std::move(shape));
+        }
+    }).join();
+    shapes.clear();
+
+    //Allocated on this thread, released on a worker
+    for (uint32_t i = 0; i < 1000; ++i) shapes.push_back(tvg::Shape::gen());
+    std::thread([&] { shapes.clear(); }).join();
+
+    //Returned by the workers while this thread keeps allocating
+    for (uint32_t i = 0; i < 1000; ++i) shapes.push_back(tvg::Shape::gen());
+    std::vector<std::thread> workers;
+    for (uint32_t t = 0; t < 4; ++t) {
+        workers.emplace_back([&shapes, t] {
+            for (uint32_t i = t; i < 1000; i += 4) shapes[i].reset();
+        });
+    }
+    for (uint32_t i = 0; i < 1000; ++i) tvg::Shape::gen();
+    for (auto& worker : workers) worker.join();
+    shapes.clear();
+
+    //Released at the thread exit, after the pools of the thread are gone
+    std::thread([] {
+        static thread_local std::unique_ptr<tvg::Shape> holder;
+        holder = tvg::Shape::gen();
+        auto scene = tvg::Scene::gen();
+        scene->push(tvg::Shape::gen());
+        holder->appendCircle(50, 50, 10, 10);
+        scene.reset();
+    }).join();
+
+    //The pools still serve this thread
+    auto canvas = tvg::SwCanvas::gen();
+    ASSERT_EQ(canvas->target(buffer, 100, 100, 100, tvg::SwCanvas::ARGB8888), tvg::Result::Success);
+    for (uint32_t i = 0; i < 10; ++i) {
+        auto shape = tvg::Shape::gen();
+        shape->appendRect(i * 10, 0, 10, 10, 0, 0);
+        shape->fill(255, 255, 255, 255);
+        ASSERT_EQ(canvas->push(std::move(shape)), tvg::Result::Success);
+    }
+    ASSERT_EQ(canvas->draw(), tvg::Result::Success);
+    ASSERT_EQ(canvas->sync(), tvg::Result::Success);
+    ASSERT_NE(buffer[5 * 100 + 95], 0U);
+}
+
+TEST_F(PaintTest, PathCommands) {
+    //The public type keeps its width, the conversion happens behind the API
+    ASSERT_EQ(sizeof(tvg::PathCommand), sizeof(int));
+
+    tvg::PathCommand cmds[4] = {tvg::PathCommand::MoveTo, tvg::PathCommand::LineTo, tvg::PathCommand::CubicTo, tvg::PathCommand::Close};
+    tvg::Point pts[5] = {{0, 0}, {10, 0}, {10, 5}, {5, 10}, {0, 10}};
+
+    ASSERT_EQ(shape->appendPath(cmds, 4, pts, 5), tvg::Result::Success);
+    ASSERT_EQ(shape->lineTo(20, 20), tvg::Result::Success);
+
+    const tvg::PathCommand* cmds2;
+    ASSERT_EQ(shape->pathCommands(&cmds2), 5U);
+    ASSERT_EQ(memcmp(cmds2, cmds, sizeof(cmds)), 0);
+    ASSERT_EQ(cmds2[4], tvg::PathCommand::LineTo);
+
+    //Duplicates share the same commands
+    auto dup = std::unique_ptr<tvg::Shape>(static_cast<tvg::Shape*>(shape->duplicate()));
+    ASSERT_EQ(dup->pathCommands(&cmds2), 5U);
+    ASSERT_EQ(memcmp(cmds2, cmds, sizeof(cmds)), 0);
+    ASSERT_EQ(cmds2[4], tvg::PathCommand::LineTo);
+}
+
+static uint32_t deleted = 0;
+
+TEST_F(PaintTest, MovePath) {
+    auto cmds = static_cast<tvg::PathCommand*>(malloc(sizeof(tvg::PathCommand) * 3));
+    cmds[0] = tvg::PathCommand::MoveTo;
+    cmds[1] = tvg::PathCommand::LineTo;
+    cmds[2] = tvg::PathCommand::Close;
+    auto pts = static_cast<tvg::Point*>(malloc(sizeof(tvg::Point) * 2));
+    pts[0] = {10, 20};
+    pts[1] = {30, 40};
+    auto deleter = [](void* data) { free(data); ++deleted; };
+
+    ASSERT_EQ(shape->appendPath(cmds, 3, pts, 0, deleter), tvg::Result::InvalidArguments);
+    ASSERT_EQ(shape->appendPath(cmds, 3, pts, 2, deleter), tvg::Result::Success);
+
+    //No copy is made
+    const tvg::Point* pts2;
+    ASSERT_EQ(shape->pathCoords(&pts2), 2U);
+    ASSERT_EQ(pts2, pts);
+
+    const tvg::PathCommand* cmds3;
+    ASSERT_EQ(shape->pathCommands(&cmds3), 3U);
+    ASSERT_EQ(cmds3[0], tvg::PathCommand::MoveTo);
+    ASSERT_EQ(cmds3[1], tvg::PathCommand::LineTo);
+    ASSERT_EQ(cmds3[2], tvg::PathCommand::Close);
+
+    //Growing the path hands back the buffers
+    ASSERT_EQ(shape->lineTo(50, 60), tvg::Result::Success);
+    ASSERT_EQ(deleted, 2U);
+    ASSERT_EQ(shape->pathCoords(&pts2), 3U);
+    ASSERT_EQ(pts2[1].x, 30.0f);
+
+    //Default deleter
+    auto cmds2 = static_cast<tvg::PathCommand*>(malloc(sizeof(tvg::PathCommand)));
+    auto pts3 = static_cast<tvg::Point*>(malloc(sizeof(tvg::Point)));
+    cmds2[0] = tvg::PathCommand::MoveTo;
+    pts3[0] = {1, 2};
+    ASSERT_EQ(shape->appendPath(cmds2, 1, pts3, 1, nullptr), tvg::Result::Success);
+    ASSERT_EQ(shape->pathCoords(&pts2), 4U);
+}
+
+TEST_F(PaintTest, SvgNumbers) {
+    //The numbers are parsed as strtof() does, bit by bit.
+    const char* numbers[] = {
+        "0", "-0", "-0.0", "-0e10", "+.5", "1.", ".", "-.", "1e", "1e+", "1e-3x",
+        "12345678901234567890123", "0.000123456789012345678901234",
+        "1234567890123456789012345678901234567890e-20",
+        "1e0000000000000000000000000038", "1e-000000000000000000000045", "123e-99999999999", "1e-400",
+        "16777217", "16777217.0000000001", "9007199254740993", "9007199254740991e3",
+        "1.000000059604644775390625", "1.00000005960464478", "0.000000000001", "0.0000000000001",
+        "1.693131148815155", "1.16075199842453", "1.6931311488151550000000001",
+        "3.4028235677973366e38", "3.40282346638528859811704183484516925440e38", "7.038531e-26", "8.589973e9"
+    };
+
+    for (auto number : numbers) {
+        auto svg = std::string("<svg viewBox=\"") + number + " 7 1 1\"><rect width=\"1\" height=\"1\"/></svg>";
+        auto picture = tvg::Picture::gen();
+        ASSERT_EQ(picture->load(svg.data(), svg.size()), tvg::Result::Success);
+
+        float x, y;
+        ASSERT_EQ(picture->viewbox(&x, &y, nullptr, nullptr), tvg::Result::Success);
+
+        char* end;
+        auto expected = strtof(number, &end);
+        ASSERT_EQ(memcmp(&x, &expected, sizeof(float)), 0) << number;
+
+        //The rest of the list is read only if the number is consumed entirely
+        ASSERT_EQ(y == 7.0f, end != number && *end == '\0') << number;
+    }
+}
+
+TEST_F(PaintTest, SvgClipUse) {
+    //The clip path refers to a symbol another <use> instanced before
+    const char* svg = "<svg viewBox=\"0 0 100 100\" width=\"100\" height=\"100\"><defs>"
+                      "<rect id=\"r\" width=\"50\" height=\"50\"/><use xlink:href=\"#r\"/>"
+                      "<clipPath id=\"c\"><use xlink:href=\"#r\"/></clipPath></defs>"
+                      "<g clip-path=\"url(#c)\"><rect width=\"100\" height=\"100\" fill=\"#fff\"/></g></svg>";
+
+    auto picture = tvg::Picture::gen();
+    ASSERT_EQ(picture->load(svg, strlen(svg)), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->target(buffer, 100, 100, 100, tvg::SwCanvas::ARGB8888), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->push(std::move(picture)), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->draw(), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->sync(), tvg::Result::Success);
+
+    uint32_t drawn = 0;
+    for (auto pixel : buffer) {
+        if (pixel) ++drawn;
+    }
+    ASSERT_EQ(drawn, 50U * 50U);
+}
+
+TEST_F(PaintTest, PictureStream) {
+    const char* svg = "<?xml version=\"1.0\"?><!-- stream --><svg viewBox=\"0 0 100 100\" width=\"100\" height=\"100\">"
+                      "<defs><linearGradient id=\"g\"><stop offset=\"0\" stop-color=\"#f00\"/><stop offset=\"1\" stop-color=\"#00f\"/></linearGradient></defs>"
+                      "<g id=\"r\"><rect x=\"10\" y=\"10\" width=\"40\" height=\"30\" fill=\"url(#g)\"/></g>"
+                      "<use xlink:href=\"#r\" transform=\"translate(40 50)\"/>"
+                      "<path d=\"M 60 10 L 90 10 L 75 40 Z\" stroke=\"#0f0\" stroke-width=\"3\"/></svg>";
+    uint32_t size = strlen(svg);
+
+    auto load = [&](tvg::SwCanvas* canvas, uint32_t chunk) {
+        auto picture = tvg::Picture::gen();
+        if (chunk == 0) {
+            ASSERT_EQ(picture->load(svg, size), tvg::Result::Success);
+        } else {
+            ASSERT_EQ(picture->finish(), tvg::Result::InsufficientCondition);
+            for (uint32_t i = 0; i < size; i += chunk) {
+                ASSERT_EQ(picture->feed(svg + i, std::min(chunk, size - i)), tvg::Result::Success);
+            }
+            ASSERT_EQ(picture->finish(), tvg::Result::Success);
+        }
+        float w, h;
+        ASSERT_EQ(picture->size(&w, &h), tvg::Result::Success);
+        ASSERT_EQ(w, 100.0f);
+
+        ASSERT_EQ(canvas->push(std::move(picture)), tvg::Result::Success);
+    };
+
+    render(expected, [&](tvg::SwCanvas* canvas) { load(canvas, 0); });
+    ASSERT_NE(expected[30 * 100 + 30], 0U);
+    ASSERT_NE(expected[70 * 100 + 70], 0U);
+
+    for (auto chunk : {1U, 5U, 64U}) {
+        render(buffer, [&](tvg::SwCanvas* canvas) { load(canvas, chunk); });
+        ASSERT_EQ(memcmp(buffer, expected, sizeof(buffer)), 0);
+    }
+
+    //Not a svg
+    auto picture = tvg::Picture::gen();
+    ASSERT_EQ(picture->feed("<html></html>", 13), tvg::Result::Success);
+    ASSERT_EQ(picture->finish(), tvg::Result::Unknown);
+}